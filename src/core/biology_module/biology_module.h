@@ -56,6 +56,22 @@ struct BaseBiologyModule {
 
   virtual ~BaseBiologyModule() {}
 
+  /// Releases a biology module that has been obtained through `new`,
+  /// `GetInstance` or `GetCopy`. The module is deleted once it is no longer
+  /// referenced by any simulation object.
+  /// \see GetSharedReference
+  static void Release(BaseBiologyModule* module) {
+    if (__atomic_sub_fetch(&module->num_references_, 1, __ATOMIC_ACQ_REL) ==
+        0) {
+      delete module;
+    }
+  }
+
+  /// Returns the number of simulation objects that share this module.
+  uint32_t GetNumReferences() const {
+    return __atomic_load_n(&num_references_, __ATOMIC_ACQUIRE);
+  }
+
   /// Create a new instance of this object using the default constructor.
   virtual BaseBiologyModule* GetInstance(const Event& event,
                                          BaseBiologyModule* other,
@@ -77,13 +93,27 @@ struct BaseBiologyModule {
   /// given event.
   bool Remove(EventId event) const { return (event & remove_mask_) != 0; }
 
+ protected:
+  /// Modules without state do not have to be copied. Instead, all simulation
+  /// objects can share the same instance. This function is used by
+  /// `BDM_STATELESS_BM_HEADER` to implement `GetInstance` and `GetCopy`
+  /// without allocating memory.
+  BaseBiologyModule* GetSharedReference() const {
+    __atomic_add_fetch(&num_references_, 1, __ATOMIC_RELAXED);
+    return const_cast<BaseBiologyModule*>(this);
+  }
+
  private:
   EventId copy_mask_;
   EventId remove_mask_;
-  BDM_CLASS_DEF(BaseBiologyModule, 2);
+  /// Number of simulation objects that reference this module
+  mutable uint32_t num_references_ = 1;
+  BDM_CLASS_DEF(BaseBiologyModule, 3);
 };
 
-/// Inserts boilerplate code for stateless biology modules
+/// Inserts boilerplate code for stateless biology modules.\n
+/// Stateless modules are not copied if a simulation object divides, or is
+/// copied. Instead, all simulation objects share the same instance.
 #define BDM_STATELESS_BM_HEADER(class_name, base_class, class_version_id)      \
  public:                                                                       \
   /** Empty default event constructor, because module does not have state. */  \
@@ -93,16 +123,14 @@ struct BaseBiologyModule {
                                                                                \
   /** Event handler not needed, because this module does not have state. */    \
                                                                                \
-  /** Create a new instance of this object using the default constructor. */   \
+  /** Returns a shared reference to this module (no state to copy). */         \
   BaseBiologyModule* GetInstance(const Event& event, BaseBiologyModule* other, \
                                  uint64_t new_oid = 0) const override {        \
-    return new class_name(event, other, new_oid);                              \
+    return GetSharedReference();                                               \
   }                                                                            \
                                                                                \
-  /** Create a copy of this biology module. */                                 \
-  BaseBiologyModule* GetCopy() const override {                                \
-    return new class_name(*this);                                              \
-  }                                                                            \
+  /** Returns a shared reference to this module (no state to copy). */         \
+  BaseBiologyModule* GetCopy() const override { return GetSharedReference(); } \
                                                                                \
  private:                                                                      \
   BDM_CLASS_DEF_OVERRIDE(class_name, class_version_id);
@@ -20,6 +20,7 @@
 #include "core/sim_object/cell.h"
 #include "core/util/log.h"
 #include "core/util/root.h"
+#include "core/util/type.h"
 
 namespace bdm {
 
@@ -35,13 +36,11 @@ struct GrowDivide : public BaseBiologyModule {
 
   GrowDivide(const Event& event, BaseBiologyModule* other, uint64_t new_oid = 0)
       : BaseBiologyModule(event, other, new_oid) {
-    if (GrowDivide* gdbm = dynamic_cast<GrowDivide*>(other)) {
-      threshold_ = gdbm->threshold_;
-      growth_rate_ = gdbm->growth_rate_;
-    } else {
-      Log::Fatal("GrowDivide::EventConstructor",
-                 "other was not of type GrowDivide");
-    }
+    auto* gdbm = bdm_static_cast<GrowDivide*>(other);
+    threshold_ = gdbm->threshold_;
+    growth_rate_ = gdbm->growth_rate_;
+    // new sim objects have the type of the one that created them
+    type_checked_ = gdbm->type_checked_;
   }
 
   /// Create a new instance of this object using the default constructor.
@@ -60,15 +59,19 @@ struct GrowDivide : public BaseBiologyModule {
     BaseBiologyModule::EventHandler(event, other1, other2);
   }
 
+  /// `so` must be a `Cell`. The type is only checked during the first call.
   void Run(SimObject* so) override {
-    if (Cell* cell = dynamic_cast<Cell*>(so)) {
-      if (cell->GetDiameter() <= threshold_) {
-        cell->ChangeVolume(growth_rate_);
-      } else {
-        cell->Divide();
+    if (!type_checked_) {
+      if (dynamic_cast<Cell*>(so) == nullptr) {
+        Log::Fatal("GrowDivide::Run", "SimObject is not a Cell");
       }
+      type_checked_ = true;
+    }
+    auto* cell = bdm_static_cast<Cell*>(so);
+    if (cell->GetDiameter() <= threshold_) {
+      cell->ChangeVolume(growth_rate_);
     } else {
-      Log::Fatal("GrowDivide::Run", "SimObject is not a Cell");
+      cell->Divide();
     }
   }
 
@@ -76,6 +79,8 @@ struct GrowDivide : public BaseBiologyModule {
   BDM_CLASS_DEF_OVERRIDE(GrowDivide, 1);
   double threshold_ = 40;
   double growth_rate_ = 300;
+  /// True if `Run` has verified that the sim object is a `Cell`
+  bool type_checked_ = false;  //!
 };
 
 }  // namespace bdm
@@ -93,9 +93,8 @@ struct RegulateGenes : public BaseBiologyModule {
     auto* param = sim->GetParam();
     auto* scheduler = sim->GetScheduler();
 
-    const auto& timestep = param->simulation_time_step_;
-    uint64_t simulated_steps = scheduler->GetSimulatedSteps();
-    const auto absolute_time = simulated_steps * timestep;
+    const auto timestep = scheduler->GetBiologyModuleTimeStep();
+    const auto absolute_time = scheduler->GetSimulatedTime();
 
     if (param->numerical_ode_solver_ == Param::NumericalODESolver::kEuler) {
       // Euler
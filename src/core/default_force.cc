@@ -17,9 +17,12 @@
 #include <algorithm>
 #include <cmath>
 
+#include "core/param/param.h"
+#include "core/scheduler.h"
 #include "core/shape.h"
 #include "core/sim_object/sim_object.h"
 #include "core/simulation.h"
+#include "core/util/cylinder_interaction_counter.h"
 #include "core/util/log.h"
 #include "core/util/math.h"
 #include "core/util/random.h"
@@ -30,7 +33,8 @@ namespace bdm {
 
 using experimental::neuroscience::NeuriteElement;
 
-Double4 DefaultForce::GetForce(const SimObject* lhs, const SimObject* rhs) {
+Double4 DefaultForce::GetForce(const SimObject* lhs,
+                               const SimObject* rhs) const {
   if (lhs->GetShape() == Shape::kSphere && rhs->GetShape() == Shape::kSphere) {
     Double3 result;
     ForceBetweenSpheres(lhs, rhs, &result);
@@ -57,56 +61,24 @@ Double4 DefaultForce::GetForce(const SimObject* lhs, const SimObject* rhs) {
   }
 }
 
+void DefaultForce::CountCylinderInteraction(bool rejected) {
+  auto* sim = Simulation::GetActive();
+  if (sim->GetParam()->statistics_) {
+    sim->GetScheduler()->GetCylinderInteractionCounter()->Count(rejected);
+  }
+}
+
+void DefaultForce::RandomForce(Double3* result) {
+  auto* random = Simulation::GetActive()->GetRandom();
+  *result = random->template UniformArray<3>(-3.0, 3.0);
+}
+
 void DefaultForce::ForceBetweenSpheres(const SimObject* sphere_lhs,
                                        const SimObject* sphere_rhs,
                                        Double3* result) const {
-  const Double3& ref_mass_location = sphere_lhs->GetPosition();
-  double ref_diameter = sphere_lhs->GetDiameter();
-  double ref_iof_coefficient = 0.15;
-  const Double3& nb_mass_location = sphere_rhs->GetPosition();
-  double nb_diameter = sphere_rhs->GetDiameter();
-  double nb_iof_coefficient = 0.15;
-
-  auto c1 = ref_mass_location;
-  double r1 = 0.5 * ref_diameter;
-  auto c2 = nb_mass_location;
-  double r2 = 0.5 * nb_diameter;
-  // We take virtual bigger radii to have a distant interaction, to get a
-  // desired density.
-  double additional_radius =
-      10.0 * std::min(ref_iof_coefficient, nb_iof_coefficient);
-  r1 += additional_radius;
-  r2 += additional_radius;
-  // the 3 components of the vector c2 -> c1
-  double comp1 = c1[0] - c2[0];
-  double comp2 = c1[1] - c2[1];
-  double comp3 = c1[2] - c2[2];
-  double center_distance =
-      std::sqrt(comp1 * comp1 + comp2 * comp2 + comp3 * comp3);
-  // the overlap distance (how much one penetrates in the other)
-  double delta = r1 + r2 - center_distance;
-  // if no overlap : no force
-  if (delta < 0) {
-    *result = {0.0, 0.0, 0.0};
-    return;
-  }
-  // to avoid a division by 0 if the centers are (almost) at the same
-  //  location
-  if (center_distance < 0.00000001) {
-    auto* random = Simulation::GetActive()->GetRandom();
-    auto force2on1 = random->template UniformArray<3>(-3.0, 3.0);
-    *result = force2on1;
-    return;
-  }
-  // the force itself
-  double r = (r1 * r2) / (r1 + r2);
-  double gamma = 1;  // attraction coeff
-  double k = 2;      // repulsion coeff
-  double f = k * delta - gamma * std::sqrt(r * delta);
-
-  double module = f / center_distance;
-  Double3 force2on1({module * comp1, module * comp2, module * comp3});
-  *result = force2on1;
+  ForceBetweenSpheres(sphere_lhs->GetPosition(), sphere_lhs->GetDiameter(),
+                      sphere_rhs->GetPosition(), sphere_rhs->GetDiameter(),
+                      result);
 }
 
 void DefaultForce::ForceOnACylinderFromASphere(const SimObject* cylinder,
@@ -122,6 +94,16 @@ void DefaultForce::ForceOnACylinderFromASphere(const SimObject* cylinder,
   auto c = sphere->GetPosition();
   double r = 0.5 * sphere->GetDiameter();
 
+  // Early rejection: the interaction point on the cylinder lies at most `d/2`
+  // outside of the segment (case I below) and must be closer than `d/2 + r`
+  // to the sphere center.
+  bool rejected = BoundingBoxesApart(proximal_end, distal_end, c, c, d + r);
+  CountCylinderInteraction(rejected);
+  if (rejected) {
+    *result = {0.0, 0.0, 0.0, 0.0};
+    return;
+  }
+
   // I. If the cylinder is small with respect to the sphere:
   // we only consider the interaction between the sphere and the point mass
   // (i.e. distal point) of the cylinder - that we treat as a sphere.
@@ -221,6 +203,15 @@ void DefaultForce::ForceBetweenCylinders(const SimObject* cylinder1,
   auto d = c2->GetMassLocation();
   double d2 = c2->GetDiameter();
 
+  // Early rejection: the interaction points lie on the segments and must be
+  // closer than the sum of the radii.
+  bool rejected = BoundingBoxesApart(a, b, c, d, (d1 + d2) * 0.5);
+  CountCylinderInteraction(rejected);
+  if (rejected) {
+    *result = {0.0, 0.0, 0.0, 0.0};
+    return;
+  }
+
   double k = 0.5;  // part devoted to the distal node
 
   //  looking for closest point on them
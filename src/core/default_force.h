@@ -15,7 +15,9 @@
 #ifndef CORE_DEFAULT_FORCE_H_
 #define CORE_DEFAULT_FORCE_H_
 
+#include <algorithm>
 #include <array>
+#include <cmath>
 
 #include "core/container/math_array.h"
 
@@ -23,16 +25,166 @@ namespace bdm {
 
 class SimObject;
 
+/// Force model used to calculate the mechanical interactions between
+/// simulation objects.\n
+/// Custom force models can be used instead (see `DisplacementOpCpu`). They
+/// must provide the following two functions:
+///
+///     // force of rhs on lhs; the fourth element is the part of the force
+///     // that is transmitted to the proximal end of a cylinder
+///     Double4 GetForce(const SimObject* lhs, const SimObject* rhs) const;
+///     // force between two spheres (used if all sim objects are spheres)
+///     void ForceBetweenSpheres(const Double3& ref_mass_location,
+///                              double ref_diameter,
+///                              const Double3& nb_mass_location,
+///                              double nb_diameter, Double3* result) const;
 class DefaultForce {
  public:
   DefaultForce() {}
   ~DefaultForce() {}
-  DefaultForce(const DefaultForce&) = delete;
-  DefaultForce& operator=(const DefaultForce&) = delete;
 
-  Double4 GetForce(const SimObject* lhs, const SimObject* rhs);
+  Double4 GetForce(const SimObject* lhs, const SimObject* rhs) const;
+
+  /// Calculates the force between two spheres given their center and
+  /// diameter. Does not require any virtual function calls and can therefore
+  /// be used by mechanics implementations that know the shape of both
+  /// simulation objects at compile time.
+  /// \see Cell::CalculateDisplacement
+  static void ForceBetweenSpheres(const Double3& ref_mass_location,
+                                  double ref_diameter,
+                                  const Double3& nb_mass_location,
+                                  double nb_diameter, Double3* result) {
+    double ref_iof_coefficient = 0.15;
+    double nb_iof_coefficient = 0.15;
+
+    auto c1 = ref_mass_location;
+    double r1 = 0.5 * ref_diameter;
+    auto c2 = nb_mass_location;
+    double r2 = 0.5 * nb_diameter;
+    // We take virtual bigger radii to have a distant interaction, to get a
+    // desired density.
+    double additional_radius =
+        10.0 * std::min(ref_iof_coefficient, nb_iof_coefficient);
+    r1 += additional_radius;
+    r2 += additional_radius;
+    // the 3 components of the vector c2 -> c1
+    double comp1 = c1[0] - c2[0];
+    double comp2 = c1[1] - c2[1];
+    double comp3 = c1[2] - c2[2];
+    double center_distance =
+        std::sqrt(comp1 * comp1 + comp2 * comp2 + comp3 * comp3);
+    // the overlap distance (how much one penetrates in the other)
+    double delta = r1 + r2 - center_distance;
+    // if no overlap : no force
+    if (delta < 0) {
+      *result = {0.0, 0.0, 0.0};
+      return;
+    }
+    // to avoid a division by 0 if the centers are (almost) at the same
+    //  location
+    if (center_distance < 0.00000001) {
+      RandomForce(result);
+      return;
+    }
+    // the force itself
+    double r = (r1 * r2) / (r1 + r2);
+    double gamma = 1;  // attraction coeff
+    double k = 2;      // repulsion coeff
+    double f = k * delta - gamma * std::sqrt(r * delta);
+
+    double module = f / center_distance;
+    *result = {module * comp1, module * comp2, module * comp3};
+  }
+
+  /// Calculates the sum of the forces that `size` spheres exert on the
+  /// sphere at `ref_mass_location` and adds it to `result`.\n
+  /// The neighbor positions and diameters are passed as structure of arrays
+  /// so that the main loop can be vectorized. The rare case of (almost)
+  /// coinciding centers is handled afterwards in neighbor order. Therefore,
+  /// random numbers are consumed in the same order as by the scalar version.
+  /// Results are equal to the sum of the scalar version up to floating point
+  /// rounding (summation order).
+  static void ForceBetweenSpheres(const Double3& ref_mass_location,
+                                  double ref_diameter, const double* nb_x,
+                                  const double* nb_y, const double* nb_z,
+                                  const double* nb_diameter, uint64_t size,
+                                  Double3* result) {
+    // see scalar version
+    const double additional_radius = 10.0 * 0.15;
+    const double c1x = ref_mass_location[0];
+    const double c1y = ref_mass_location[1];
+    const double c1z = ref_mass_location[2];
+    const double r1 = 0.5 * ref_diameter + additional_radius;
+    double fx = 0;
+    double fy = 0;
+    double fz = 0;
+    uint64_t num_coinciding = 0;
+#pragma omp simd reduction(+ : fx, fy, fz, num_coinciding)
+    for (uint64_t i = 0; i < size; i++) {
+      double comp1 = c1x - nb_x[i];
+      double comp2 = c1y - nb_y[i];
+      double comp3 = c1z - nb_z[i];
+      double center_distance =
+          std::sqrt(comp1 * comp1 + comp2 * comp2 + comp3 * comp3);
+      double r2 = 0.5 * nb_diameter[i] + additional_radius;
+      double delta = r1 + r2 - center_distance;
+      bool overlap = delta >= 0;
+      bool coinciding = overlap && center_distance < 0.00000001;
+      double r = (r1 * r2) / (r1 + r2);
+      double f = 2 * delta - std::sqrt(r * std::max(delta, 0.0));
+      double module = overlap && !coinciding ? f / center_distance : 0.0;
+      fx += module * comp1;
+      fy += module * comp2;
+      fz += module * comp3;
+      num_coinciding += coinciding ? 1 : 0;
+    }
+
+    // (almost) coinciding centers
+    for (uint64_t i = 0; num_coinciding != 0 && i < size; i++) {
+      double comp1 = c1x - nb_x[i];
+      double comp2 = c1y - nb_y[i];
+      double comp3 = c1z - nb_z[i];
+      double center_distance =
+          std::sqrt(comp1 * comp1 + comp2 * comp2 + comp3 * comp3);
+      double r2 = 0.5 * nb_diameter[i] + additional_radius;
+      if (r1 + r2 - center_distance >= 0 && center_distance < 0.00000001) {
+        Double3 force;
+        RandomForce(&force);
+        fx += force[0];
+        fy += force[1];
+        fz += force[2];
+        num_coinciding--;
+      }
+    }
+
+    (*result)[0] += fx;
+    (*result)[1] += fy;
+    (*result)[2] += fz;
+  }
 
  private:
+  /// Random force used if the centers of two spheres (almost) coincide
+  static void RandomForce(Double3* result);
+
+  /// Returns true if the axis-aligned bounding boxes of the segments `a-b`
+  /// and `c-d` are further apart than `margin` along at least one axis.
+  /// In this case, the distance between any point on `a-b` and any point on
+  /// `c-d` is larger than `margin`.
+  static bool BoundingBoxesApart(const Double3& a, const Double3& b,
+                                 const Double3& c, const Double3& d,
+                                 double margin) {
+    bool apart = false;
+    for (int i = 0; i < 3; i++) {
+      apart |= std::min(a[i], b[i]) - std::max(c[i], d[i]) > margin;
+      apart |= std::min(c[i], d[i]) - std::max(a[i], b[i]) > margin;
+    }
+    return apart;
+  }
+
+  /// Counts the result of a bounding box test if `Param::statistics_` is
+  /// enabled (see `Scheduler::GetCylinderInteractionCounter`)
+  static void CountCylinderInteraction(bool rejected);
+
   void ForceBetweenSpheres(const SimObject* sphere_lhs,
                            const SimObject* sphere_rhs, Double3* result) const;
 
@@ -51,6 +203,64 @@ class DefaultForce {
                                          const Double3& c2, double r2) const;
 };
 
+/// Calculates the force of neighboring spheres on a query sphere.\n
+/// Neighbors are collected in batches, which are passed to the vectorized
+/// version of `DefaultForce::ForceBetweenSpheres`. No memory is allocated.\n
+/// If `kReference` is true, the scalar version is called for each neighbor
+/// immediately. This reproduces the result of summing up the pairwise forces
+/// in neighbor order bitwise and serves as reference for the batched kernel.
+template <bool kReference = false>
+class SphereForceAccumulator {
+ public:
+  SphereForceAccumulator(const Double3& position, double diameter)
+      : position_(position), diameter_(diameter) {}
+
+  /// Adds the force of the neighbor sphere with the given position and
+  /// diameter
+  void Add(const Double3& position, double diameter) {
+    if (kReference) {
+      Double3 force;
+      DefaultForce::ForceBetweenSpheres(position_, diameter_, position,
+                                        diameter, &force);
+      force_ += force;
+      return;
+    }
+    x_[size_] = position[0];
+    y_[size_] = position[1];
+    z_[size_] = position[2];
+    diameters_[size_] = diameter;
+    if (++size_ == kBatchSize) {
+      Flush();
+    }
+  }
+
+  /// Returns the sum of the forces of all added neighbors
+  const Double3& GetForce() {
+    Flush();
+    return force_;
+  }
+
+ private:
+  static constexpr uint64_t kBatchSize = 32;
+
+  Double3 position_;
+  double diameter_;
+  Double3 force_ = {0, 0, 0};
+  uint64_t size_ = 0;
+  double x_[kBatchSize];
+  double y_[kBatchSize];
+  double z_[kBatchSize];
+  double diameters_[kBatchSize];
+
+  void Flush() {
+    if (size_ != 0) {
+      DefaultForce::ForceBetweenSpheres(position_, diameter_, x_, y_, z_,
+                                        diameters_, size_, &force_);
+      size_ = 0;
+    }
+  }
+};
+
 }  // namespace bdm
 
 #endif  // CORE_DEFAULT_FORCE_H_
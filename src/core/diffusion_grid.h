@@ -16,13 +16,18 @@
 #define CORE_DIFFUSION_GRID_H_
 
 #include <assert.h>
+#include <omp.h>
 
 #include <algorithm>
 #include <array>
 #include <cmath>
 #include <functional>
 #include <iostream>
+#include <limits>
 #include <string>
+#include <tuple>
+#include <type_traits>
+#include <utility>
 #include <vector>
 #include "core/util/root.h"
 
@@ -31,6 +36,7 @@
 #include "core/param/param.h"
 #include "core/util/log.h"
 #include "core/util/math.h"
+#include "core/util/thread_info.h"
 
 namespace bdm {
 
@@ -90,14 +96,25 @@ class DiffusionGrid {
         num_boxes_axis_[0] * num_boxes_axis_[1] * num_boxes_axis_[2];
 
     // Allocate memory for the concentration and gradient arrays
-    c1_.resize(total_num_boxes_);
-    c2_.resize(total_num_boxes_);
-    gradients_.resize(3 * total_num_boxes_);
+    WithBuffers([&](auto& c1, auto& c2, auto& gradients) {
+      c1.resize(total_num_boxes_);
+      c2.resize(total_num_boxes_);
+      gradients.resize(3 * total_num_boxes_);
+    });
+    // the grid is empty
+    InitializeBlocks(false);
+    InitializeGradientCache();
 
     initialized_ = true;
   }
 
   void ParametersCheck() {
+    // If the diffusion grid is sub-cycled, the time step is derived from the
+    // stability criterion in `AdaptTimeStep` and does not need to be checked.
+    // The ADI scheme is stable for any time step.
+    if (sub_cycling_ || diffusion_method_ == Param::DiffusionMethod::kADI) {
+      return;
+    }
     // The 1.0 is to impose floating point operations
     if ((1.0 * (1 - dc_[0]) * dt_) / (1.0 * box_length_ * box_length_) >=
         (1.0 / 6)) {
@@ -111,36 +128,48 @@ class DiffusionGrid {
     }
   }
 
+  /// Applies all functions that have been added with `AddInitializer` and
+  /// removes them afterwards. The grid lines along x are processed in
+  /// parallel in memory order. Initializers may therefore be called
+  /// concurrently from different threads.
   void RunInitializers() {
     assert(num_boxes_axis_[0] > 0 &&
            "The number of boxes along an axis was found to be zero!");
     if (initializers_.empty()) {
       return;
     }
-
-    auto nx = num_boxes_axis_[0];
-    auto ny = num_boxes_axis_[1];
-    auto nz = num_boxes_axis_[2];
-
-    // Apply all functions that initialize this diffusion grid
-    for (size_t f = 0; f < initializers_.size(); f++) {
-      for (size_t x = 0; x < nx; x++) {
-        double real_x = grid_dimensions_[0] + x * box_length_;
-        for (size_t y = 0; y < ny; y++) {
-          double real_y = grid_dimensions_[2] + y * box_length_;
-          for (size_t z = 0; z < nz; z++) {
+    ApplyDeposits();
+
+    const int64_t nx = num_boxes_axis_[0];
+    const int64_t ny = num_boxes_axis_[1];
+    const int64_t nz = num_boxes_axis_[2];
+    const double x0 = grid_dimensions_[0];
+
+    WithBuffers([&](auto& c1, auto&, auto&) {
+#pragma omp parallel
+      {
+        std::vector<double> values(nx);
+#pragma omp for collapse(2) schedule(static)
+        for (int64_t z = 0; z < nz; z++) {
+          for (int64_t y = 0; y < ny; y++) {
+            double real_y = grid_dimensions_[2] + y * box_length_;
             double real_z = grid_dimensions_[4] + z * box_length_;
-            std::array<uint32_t, 3> box_coord;
-            box_coord[0] = x;
-            box_coord[1] = y;
-            box_coord[2] = z;
-            size_t idx = GetBoxIndex(box_coord);
-            IncreaseConcentrationBy(idx,
-                                    initializers_[f](real_x, real_y, real_z));
+            const int64_t line = y * nx + z * nx * ny;
+            // Apply all functions that initialize this diffusion grid
+            for (auto& initializer : initializers_) {
+              initializer(x0, box_length_, nx, real_y, real_z, values.data());
+              for (int64_t x = 0; x < nx; x++) {
+                c1[line + x] = std::min(c1[line + x] + values[x],
+                                        concentration_threshold_);
+                if (values[x] != 0) {
+                  ActivateBlock(line + x);
+                }
+              }
+            }
           }
         }
       }
-    }
+    });
 
     // Clear the initializer to free up space
     initializers_.clear();
@@ -154,7 +183,15 @@ class DiffusionGrid {
   ///
   /// @param[in]  threshold_dimensions  The threshold values
   ///
+  /// If the grid grows and the growth factor is larger than one (see
+  /// `SetGrowthFactor`), the grid is padded such that it can accommodate
+  /// further growth without reallocation.
+  ///
   void Update(const std::array<int32_t, 2>& threshold_dimensions) {
+    // buffered deposits refer to the current box indices
+    ApplyDeposits();
+    // the grid only changes if it grows
+    const auto old_grid_dimensions = grid_dimensions_;
     // Update the grid dimensions such that each dimension ranges from
     // {treshold_dimensions[0] - treshold_dimensions[1]}
     auto min_gd = threshold_dimensions[0];
@@ -176,46 +213,78 @@ class DiffusionGrid {
     int new_dimension_length = grid_dimensions_[1] - grid_dimensions_[0];
     int new_num_boxes = std::ceil(new_dimension_length / box_length_);
     int growth = new_num_boxes - num_boxes_axis_[0];
+    bool covered = true;
+    for (int i = 0; i < 3; i++) {
+      covered &= old_grid_dimensions[2 * i] <= min_gd &&
+                 old_grid_dimensions[2 * i + 1] >= max_gd;
+    }
+    if (covered) {
+      // the thresholds are still covered by the current (padded) grid
+      grid_dimensions_ = old_grid_dimensions;
+      return;
+    }
 
-    if (growth > 0) {
-      // Store the old number of boxes along each axis for comparison
-      std::array<size_t, 3> tmp_num_boxes_axis = num_boxes_axis_;
-
-      // Increase number of boxes along axis accordingly
-      num_boxes_axis_[0] += growth;
-      num_boxes_axis_[1] += growth;
-      num_boxes_axis_[2] += growth;
-
-      // We need to maintain the parity of the number of boxes along each
-      // dimension, otherwise copying of the substances to the increases grid
-      // will not be symmetrically done; resulting in shifting of boxes
-      // We add a box in the negative direction, because the only way the parity
-      // could have changed is because of adding a box in the positive direction
-      // (due to the grid not being perfectly divisible; see above)
-      if (num_boxes_axis_[0] % 2 != parity_) {
-        for (int i = 0; i < 3; i++) {
-          grid_dimensions_[2 * i] -= box_length_;
-          num_boxes_axis_[i]++;
-        }
+    // Over-allocate geometrically, such that most of the following growth
+    // events are covered by the padding. The padding is distributed evenly
+    // to both sides to keep the grid centered.
+    // If the thresholds moved past one side of the grid, but its width is
+    // still sufficient, the grid must grow nevertheless.
+    int target = std::max<int>(new_num_boxes, num_boxes_axis_[0] + 1);
+    if (growth_factor_ > 1) {
+      target = std::max<int>(target,
+                             std::ceil(num_boxes_axis_[0] * growth_factor_));
+    }
+    int padding = target - new_num_boxes;
+    padding += padding % 2;
+    for (int i = 0; i < 3; i++) {
+      grid_dimensions_[2 * i] -= padding / 2 * box_length_;
+      grid_dimensions_[2 * i + 1] += padding / 2 * box_length_;
+    }
+    growth += padding;
+
+    // Store the old number of boxes along each axis for comparison
+    std::array<size_t, 3> tmp_num_boxes_axis = num_boxes_axis_;
+
+    // Increase number of boxes along axis accordingly
+    num_boxes_axis_[0] += growth;
+    num_boxes_axis_[1] += growth;
+    num_boxes_axis_[2] += growth;
+
+    // We need to maintain the parity of the number of boxes along each
+    // dimension, otherwise copying of the substances to the increases grid
+    // will not be symmetrically done; resulting in shifting of boxes
+    // We add a box in the negative direction, because the only way the parity
+    // could have changed is because of adding a box in the positive direction
+    // (due to the grid not being perfectly divisible; see above)
+    if (num_boxes_axis_[0] % 2 != parity_) {
+      for (int i = 0; i < 3; i++) {
+        grid_dimensions_[2 * i] -= box_length_;
+        num_boxes_axis_[i]++;
       }
+    }
 
-      // Temporarily save previous grid data
-      auto tmp_c1 = c1_;
-      auto tmp_gradients = gradients_;
-
-      c1_.clear();
-      c2_.clear();
-      gradients_.clear();
-
-      total_num_boxes_ =
-          num_boxes_axis_[0] * num_boxes_axis_[1] * num_boxes_axis_[2];
-
-      CopyOldData(tmp_c1, tmp_gradients, tmp_num_boxes_axis);
+    total_num_boxes_ =
+        num_boxes_axis_[0] * num_boxes_axis_[1] * num_boxes_axis_[2];
 
-      assert(total_num_boxes_ >= tmp_num_boxes_axis[0] * tmp_num_boxes_axis[1] *
-                                     tmp_num_boxes_axis[2] &&
-             "The diffusion grid tried to shrink! It can only become larger");
-    }
+    WithBuffers([&](auto& c1, auto& c2, auto& gradients) {
+      using Buffer = std::decay_t<decltype(c1)>;
+      // Take over the previous grid data without copying it and release
+      // the second buffer before the larger buffers are allocated
+      Buffer tmp_c1;
+      Buffer tmp_gradients;
+      tmp_c1.swap(c1);
+      tmp_gradients.swap(gradients);
+      Buffer().swap(c2);
+
+      CopyOldData(tmp_c1, tmp_gradients, tmp_num_boxes_axis, &c1, &c2,
+                  &gradients);
+    });
+    InitializeBlocks(true);
+    InitializeGradientCache();
+
+    assert(total_num_boxes_ >= tmp_num_boxes_axis[0] * tmp_num_boxes_axis[1] *
+                                   tmp_num_boxes_axis[2] &&
+           "The diffusion grid tried to shrink! It can only become larger");
   }
 
   /// Copies the concentration and gradients values to the new
@@ -228,15 +297,22 @@ class DiffusionGrid {
   ///
   /// The dimensions are doubled in this case from 2x2 to 4x4
   /// If the dimensions would be increased from 2x2 to 3x3, it will still
-  /// be increased to 4x4 in order for GetBoxIndex to function correctly
+  /// be increased to 4x4 in order for GetBoxIndex to function correctly.\n
+  /// The data is copied into `c1`, `c2` and `gradients`, which are resized
+  /// to the current number of boxes. The new buffers are initialized and
+  /// the data is copied in parallel. Therefore, memory pages are placed on
+  /// the NUMA nodes of the threads that initialize them (first touch).
   ///
-  void CopyOldData(const ParallelResizeVector<double>& old_c1,
-                   const ParallelResizeVector<double>& old_gradients,
-                   const std::array<size_t, 3>& old_num_boxes_axis) {
+  template <typename T>
+  void CopyOldData(const ParallelResizeVector<T>& old_c1,
+                   const ParallelResizeVector<T>& old_gradients,
+                   const std::array<size_t, 3>& old_num_boxes_axis,
+                   ParallelResizeVector<T>* c1, ParallelResizeVector<T>* c2,
+                   ParallelResizeVector<T>* gradients) {
     // Allocate more memory for the grid data arrays
-    c1_.resize(total_num_boxes_);
-    c2_.resize(total_num_boxes_);
-    gradients_.resize(3 * total_num_boxes_);
+    c1->resize(total_num_boxes_);
+    c2->resize(total_num_boxes_);
+    gradients->resize(3 * total_num_boxes_);
 
     auto incr_dim_x = num_boxes_axis_[0] - old_num_boxes_axis[0];
     auto incr_dim_y = num_boxes_axis_[1] - old_num_boxes_axis[1];
@@ -246,22 +322,23 @@ class DiffusionGrid {
     int off_y = incr_dim_y / 2;
     int off_z = incr_dim_z / 2;
 
-    int num_box_xy = num_boxes_axis_[0] * num_boxes_axis_[1];
-    int old_box_xy = old_num_boxes_axis[0] * old_num_boxes_axis[1];
-    int new_origin = off_z * (num_boxes_axis_[0] * num_boxes_axis_[1]) +
-                     off_y * num_boxes_axis_[0] + off_x;
-    for (size_t k = 0; k < old_num_boxes_axis[2]; k++) {
-      int offset = new_origin + k * num_box_xy;
-      for (size_t j = 0; j < old_num_boxes_axis[1]; j++) {
-        if (j != 0) {
-          offset += num_boxes_axis_[0];
-        }
+    const int64_t num_box_xy = num_boxes_axis_[0] * num_boxes_axis_[1];
+    const int64_t old_box_xy = old_num_boxes_axis[0] * old_num_boxes_axis[1];
+    const int64_t new_origin = off_z * num_box_xy +
+                               off_y * num_boxes_axis_[0] + off_x;
+    const int64_t old_ny = old_num_boxes_axis[1];
+    const int64_t old_nz = old_num_boxes_axis[2];
+#pragma omp parallel for collapse(2)
+    for (int64_t k = 0; k < old_nz; k++) {
+      for (int64_t j = 0; j < old_ny; j++) {
+        const int64_t offset =
+            new_origin + k * num_box_xy + j * num_boxes_axis_[0];
         for (size_t i = 0; i < old_num_boxes_axis[0]; i++) {
           auto idx = k * old_box_xy + j * old_num_boxes_axis[0] + i;
-          c1_[offset + i] = old_c1[idx];
-          gradients_[3 * (offset + i)] = old_gradients[3 * idx];
-          gradients_[3 * (offset + i) + 1] = old_gradients[3 * idx + 1];
-          gradients_[3 * (offset + i) + 2] = old_gradients[3 * idx + 2];
+          (*c1)[offset + i] = old_c1[idx];
+          (*gradients)[3 * (offset + i)] = old_gradients[3 * idx];
+          (*gradients)[3 * (offset + i) + 1] = old_gradients[3 * idx + 1];
+          (*gradients)[3 * (offset + i) + 2] = old_gradients[3 * idx + 2];
         }
       }
     }
@@ -272,83 +349,86 @@ class DiffusionGrid {
   /// space. This prevents building up concentration at the edges
   ///
   void DiffuseWithLeakingEdge() {
-    int nx = num_boxes_axis_[0];
-    int ny = num_boxes_axis_[1];
-    int nz = num_boxes_axis_[2];
+    ApplyDeposits();
+    WithBuffers([&](auto& c1, auto& c2, auto&) {
+      int nx = num_boxes_axis_[0];
+      int ny = num_boxes_axis_[1];
+      int nz = num_boxes_axis_[2];
 
 #define YBF 16
 #pragma omp parallel for collapse(2)
-    for (int yy = 0; yy < ny; yy += YBF) {
-      for (int z = 0; z < nz; z++) {
-        // To let the edges bleed we set some diffusion coefficients
-        // to zero. This prevents substance building up at the edges
-        auto dc_2_ = dc_;
-        int ymax = yy + YBF;
-        if (ymax >= ny) {
-          ymax = ny;
-        }
-        for (int y = yy; y < ymax; y++) {
-          dc_2_ = dc_;
-          int x;
-          int c, n, s, b, t;
-          x = 0;
-          c = x + y * nx + z * nx * ny;
-          if (y == 0) {
-            n = c;
-            dc_2_[4] = 0;
-          } else {
-            n = c - nx;
-          }
-          if (y == (ny - 1)) {
-            s = c;
-            dc_2_[3] = 0;
-          } else {
-            s = c + nx;
-          }
-          if (z == 0) {
-            b = c;
-            dc_2_[5] = 0;
-          } else {
-            b = c - nx * ny;
+      for (int yy = 0; yy < ny; yy += YBF) {
+        for (int z = 0; z < nz; z++) {
+          // To let the edges bleed we set some diffusion coefficients
+          // to zero. This prevents substance building up at the edges
+          auto dc_2_ = dc_;
+          int ymax = yy + YBF;
+          if (ymax >= ny) {
+            ymax = ny;
           }
-          if (z == (nz - 1)) {
-            t = c;
-            dc_2_[6] = 0;
-          } else {
-            t = c + nx * ny;
-          }
-          // x = 0; we leak out substances past this edge (so multiply by 0)
-          c2_[c] = (dc_2_[0] * c1_[c] + 0 * c1_[c] + dc_2_[2] * c1_[c + 1] +
-                    dc_2_[3] * c1_[s] + dc_2_[4] * c1_[n] + dc_2_[5] * c1_[b] +
-                    dc_2_[6] * c1_[t]) *
-                   (1 - mu_);
+          for (int y = yy; y < ymax; y++) {
+            dc_2_ = dc_;
+            int x;
+            int c, n, s, b, t;
+            x = 0;
+            c = x + y * nx + z * nx * ny;
+            if (y == 0) {
+              n = c;
+              dc_2_[4] = 0;
+            } else {
+              n = c - nx;
+            }
+            if (y == (ny - 1)) {
+              s = c;
+              dc_2_[3] = 0;
+            } else {
+              s = c + nx;
+            }
+            if (z == 0) {
+              b = c;
+              dc_2_[5] = 0;
+            } else {
+              b = c - nx * ny;
+            }
+            if (z == (nz - 1)) {
+              t = c;
+              dc_2_[6] = 0;
+            } else {
+              t = c + nx * ny;
+            }
+            // x = 0; leak out substances past this edge (so multiply by 0)
+            c2[c] = (dc_2_[0] * c1[c] + 0 * c1[c] + dc_2_[2] * c1[c + 1] +
+                     dc_2_[3] * c1[s] + dc_2_[4] * c1[n] + dc_2_[5] * c1[b] +
+                     dc_2_[6] * c1[t]) *
+                    (1 - mu_);
 #pragma omp simd
-          for (x = 1; x < nx - 1; x++) {
+            for (x = 1; x < nx - 1; x++) {
+              ++c;
+              ++n;
+              ++s;
+              ++b;
+              ++t;
+              c2[c] =
+                  (dc_2_[0] * c1[c] + dc_2_[1] * c1[c - 1] +
+                   dc_2_[2] * c1[c + 1] + dc_2_[3] * c1[s] + dc_2_[4] * c1[n] +
+                   dc_2_[5] * c1[b] + dc_2_[6] * c1[t]) *
+                  (1 - mu_);
+            }
             ++c;
             ++n;
             ++s;
             ++b;
             ++t;
-            c2_[c] =
-                (dc_2_[0] * c1_[c] + dc_2_[1] * c1_[c - 1] +
-                 dc_2_[2] * c1_[c + 1] + dc_2_[3] * c1_[s] + dc_2_[4] * c1_[n] +
-                 dc_2_[5] * c1_[b] + dc_2_[6] * c1_[t]) *
-                (1 - mu_);
-          }
-          ++c;
-          ++n;
-          ++s;
-          ++b;
-          ++t;
-          // x = nx-1; we leak out substances past this edge (so multiply by 0)
-          c2_[c] = (dc_2_[0] * c1_[c] + dc_2_[1] * c1_[c - 1] + 0 * c1_[c] +
-                    dc_2_[3] * c1_[s] + dc_2_[4] * c1_[n] + dc_2_[5] * c1_[b] +
-                    dc_2_[6] * c1_[t]) *
-                   (1 - mu_);
-        }  // tile ny
-      }    // tile nz
-    }      // block ny
-    c1_.swap(c2_);
+            // x = nx-1; leak out substances past this edge (so multiply by 0)
+            c2[c] = (dc_2_[0] * c1[c] + dc_2_[1] * c1[c - 1] + 0 * c1[c] +
+                     dc_2_[3] * c1[s] + dc_2_[4] * c1[n] + dc_2_[5] * c1[b] +
+                     dc_2_[6] * c1[t]) *
+                    (1 - mu_);
+          }  // tile ny
+        }    // tile nz
+      }      // block ny
+      c1.swap(c2);
+    });
   }
 
   /// Solves a 5-point stencil diffusion equation, with closed-edge
@@ -356,208 +436,170 @@ class DiffusionGrid {
   /// space. Keep in mind that the concentration can build up at the edges
   ///
   void DiffuseWithClosedEdge() {
-    auto nx = num_boxes_axis_[0];
-    auto ny = num_boxes_axis_[1];
-    auto nz = num_boxes_axis_[2];
+    ApplyDeposits();
+    WithBuffers([&](auto& c1, auto& c2, auto&) {
+      auto nx = num_boxes_axis_[0];
+      auto ny = num_boxes_axis_[1];
+      auto nz = num_boxes_axis_[2];
 
 #define YBF 16
 #pragma omp parallel for collapse(2)
-    for (size_t yy = 0; yy < ny; yy += YBF) {
-      for (size_t z = 0; z < nz; z++) {
-        size_t ymax = yy + YBF;
-        if (ymax >= ny) {
-          ymax = ny;
-        }
-        for (size_t y = yy; y < ymax; y++) {
-          size_t x;
-          int c, n, s, b, t;
-          x = 0;
-          c = x + y * nx + z * nx * ny;
-          n = (y == 0) ? c : c - nx;
-          s = (y == ny - 1) ? c : c + nx;
-          b = (z == 0) ? c : c - nx * ny;
-          t = (z == nz - 1) ? c : c + nx * ny;
-          c2_[c] = (dc_[0] * c1_[c] + dc_[1] * c1_[c] + dc_[2] * c1_[c + 1] +
-                    dc_[3] * c1_[s] + dc_[4] * c1_[n] + dc_[5] * c1_[b] +
-                    dc_[6] * c1_[t]) *
-                   (1 - mu_);
-#pragma omp simd
-          for (x = 1; x < nx - 1; x++) {
-            ++c;
-            ++n;
-            ++s;
-            ++b;
-            ++t;
-            c2_[c] = (dc_[0] * c1_[c] + dc_[1] * c1_[c - 1] +
-                      dc_[2] * c1_[c + 1] + dc_[3] * c1_[s] + dc_[4] * c1_[n] +
-                      dc_[5] * c1_[b] + dc_[6] * c1_[t]) *
-                     (1 - mu_);
+      for (size_t yy = 0; yy < ny; yy += YBF) {
+        for (size_t z = 0; z < nz; z++) {
+          size_t ymax = yy + YBF;
+          if (ymax >= ny) {
+            ymax = ny;
           }
-          ++c;
-          ++n;
-          ++s;
-          ++b;
-          ++t;
-          c2_[c] = (dc_[0] * c1_[c] + dc_[1] * c1_[c - 1] + dc_[2] * c1_[c] +
-                    dc_[3] * c1_[s] + dc_[4] * c1_[n] + dc_[5] * c1_[b] +
-                    dc_[6] * c1_[t]) *
-                   (1 - mu_);
-        }  // tile ny
-      }    // tile nz
-    }      // block ny
-    c1_.swap(c2_);
-  }
-
-  void DiffuseEuler() {
-    // check if diffusion coefficient and decay constant are 0
-    // i.e. if we don't need to calculate diffusion update
-    if (IsFixedSubstance()) {
-      return;
-    }
-
-    const auto nx = num_boxes_axis_[0];
-    const auto ny = num_boxes_axis_[1];
-    const auto nz = num_boxes_axis_[2];
-
-    const double ibl2 = 1 / (box_length_ * box_length_);
-    const double d = 1 - dc_[0];
-
-#define YBF 16
-#pragma omp parallel for collapse(2)
-    for (size_t yy = 0; yy < ny; yy += YBF) {
-      for (size_t z = 0; z < nz; z++) {
-        size_t ymax = yy + YBF;
-        if (ymax >= ny) {
-          ymax = ny;
-        }
-        for (size_t y = yy; y < ymax; y++) {
-          size_t x = 0;
-          int c, n, s, b, t;
-          c = x + y * nx + z * nx * ny;
+          for (size_t y = yy; y < ymax; y++) {
+            size_t x;
+            int c, n, s, b, t;
+            x = 0;
+            c = x + y * nx + z * nx * ny;
+            n = (y == 0) ? c : c - nx;
+            s = (y == ny - 1) ? c : c + nx;
+            b = (z == 0) ? c : c - nx * ny;
+            t = (z == nz - 1) ? c : c + nx * ny;
+            c2[c] = (dc_[0] * c1[c] + dc_[1] * c1[c] + dc_[2] * c1[c + 1] +
+                     dc_[3] * c1[s] + dc_[4] * c1[n] + dc_[5] * c1[b] +
+                     dc_[6] * c1[t]) *
+                    (1 - mu_);
 #pragma omp simd
-          for (x = 1; x < nx - 1; x++) {
+            for (x = 1; x < nx - 1; x++) {
+              ++c;
+              ++n;
+              ++s;
+              ++b;
+              ++t;
+              c2[c] = (dc_[0] * c1[c] + dc_[1] * c1[c - 1] +
+                       dc_[2] * c1[c + 1] + dc_[3] * c1[s] + dc_[4] * c1[n] +
+                       dc_[5] * c1[b] + dc_[6] * c1[t]) *
+                      (1 - mu_);
+            }
             ++c;
             ++n;
             ++s;
             ++b;
             ++t;
+            c2[c] = (dc_[0] * c1[c] + dc_[1] * c1[c - 1] + dc_[2] * c1[c] +
+                     dc_[3] * c1[s] + dc_[4] * c1[n] + dc_[5] * c1[b] +
+                     dc_[6] * c1[t]) *
+                    (1 - mu_);
+          }  // tile ny
+        }    // tile nz
+      }      // block ny
+      c1.swap(c2);
+    });
+  }
 
-            if (y == 0 || y == (ny - 1) || z == 0 || z == (nz - 1)) {
-              continue;
-            }
+  /// Solves the diffusion equation with the explicit Euler scheme. The boxes
+  /// at the border of the grid are not updated.\n
+  /// Calculates `steps` time steps. If `steps` is larger than one, the time
+  /// steps are temporally blocked (see `EulerSweep`).
+  void DiffuseEuler(uint64_t steps = 1) { EulerSweep(steps, false); }
+
+  /// Solves the diffusion equation with the explicit Euler scheme and
+  /// leaking-edge boundary conditions. Substances are allowed to leave the
+  /// simulation space: the concentration outside of the grid is zero.\n
+  /// Calculates `steps` time steps. If `steps` is larger than one, the time
+  /// steps are temporally blocked (see `EulerSweep`).
+  void DiffuseEulerLeakingEdge(uint64_t steps = 1) {
+    EulerSweep(steps, true);
+  }
 
-            n = c - nx;
-            s = c + nx;
-            b = c - nx * ny;
-            t = c + nx * ny;
-            c2_[c] = (c1_[c] +
-                      d * dt_ * (c1_[c - 1] - 2 * c1_[c] + c1_[c + 1]) * ibl2 +
-                      d * dt_ * (c1_[s] - 2 * c1_[c] + c1_[n]) * ibl2 +
-                      d * dt_ * (c1_[b] - 2 * c1_[c] + c1_[t]) * ibl2) *
-                     (1 - mu_);
-          }
-          ++c;
-          ++n;
-          ++s;
-          ++b;
-          ++t;
-        }  // tile ny
-      }    // tile nz
-    }      // block ny
-    c1_.swap(c2_);
-  }
-
-  void DiffuseEulerLeakingEdge() {
-    // check if diffusion coefficient and decay constant are 0
-    // i.e. if we don't need to calculate diffusion update
-    if (IsFixedSubstance()) {
+  /// Calculates one time step of the explicit Euler scheme and afterwards
+  /// the gradients for all `grids` in a single pass over the grid (same
+  /// result as calling `DiffuseEuler` or `DiffuseEulerLeakingEdge` followed
+  /// by `CalculateGradient` for each grid).\n
+  /// All grids must have the same number of boxes along each axis. The grids
+  /// are processed together in blocks of z-planes. The gradients of a block
+  /// are calculated two blocks behind its concentrations, while the
+  /// concentrations are still in cache. Thus, there is one parallel region
+  /// for all grids and the concentrations are only read once from memory.
+  static void DiffuseEulerFused(const std::vector<DiffusionGrid*>& grids,
+                                bool leaking_edge, bool calculate_gradients) {
+    if (grids.empty()) {
       return;
     }
+    const auto& num_boxes_axis = grids[0]->num_boxes_axis_;
+    for (auto* dg : grids) {
+      assert(dg->num_boxes_axis_ == num_boxes_axis &&
+             "Fused diffusion grids must have the same number of boxes");
+      dg->ApplyDeposits();
+    }
 
-    const auto nx = num_boxes_axis_[0];
-    const auto ny = num_boxes_axis_[1];
-    const auto nz = num_boxes_axis_[2];
-
-    const double ibl2 = 1 / (box_length_ * box_length_);
-    const double d = 1 - dc_[0];
-    std::array<int, 4> l;
-
-#define YBF 16
-#pragma omp parallel for collapse(2)
-    for (size_t yy = 0; yy < ny; yy += YBF) {
-      for (size_t z = 0; z < nz; z++) {
-        size_t ymax = yy + YBF;
-        if (ymax >= ny) {
-          ymax = ny;
-        }
-        for (size_t y = yy; y < ymax; y++) {
-          size_t x = 0;
-          int c, n, s, b, t;
-          c = x + y * nx + z * nx * ny;
-
-          l.fill(1);
-
-          if (y == 0) {
-            n = c;
-            l[0] = 0;
-          } else {
-            n = c - nx;
-          }
-
-          if (y == ny - 1) {
-            s = c;
-            l[1] = 0;
-          } else {
-            s = c + nx;
+    const int64_t nx = num_boxes_axis[0];
+    const int64_t ny = num_boxes_axis[1];
+    const int64_t nz = num_boxes_axis[2];
+    const int64_t num_grids = grids.size();
+    // zero lines of both storage types (see `UpdateEulerLine`)
+    const std::tuple<std::vector<double>, std::vector<float>> ghosts(
+        std::vector<double>(nx, 0), std::vector<float>(nx, 0));
+    // without leaking edges the border boxes keep their value
+    const int64_t border = leaking_edge ? 0 : 1;
+    // The gradient of plane z requires the concentrations of planes z - 1 to
+    // z + 1 (z + 2 at the border). Blocks with at least two planes ensure
+    // that these have been calculated two blocks later.
+    const int64_t planes_per_block = 4;
+    const int64_t num_blocks = (nz + planes_per_block - 1) / planes_per_block;
+
+#pragma omp parallel
+    for (int64_t block = 0; block < num_blocks + 2; block++) {
+      // concentrations of `block` and gradients of `block - 2`
+      const int64_t dz = block * planes_per_block;
+      const int64_t gz = (block - 2) * planes_per_block;
+      const int64_t diffusion_planes =
+          std::max<int64_t>(std::min(planes_per_block, nz - dz), 0);
+      const int64_t gradient_planes =
+          calculate_gradients && gz >= 0
+              ? std::max<int64_t>(std::min(planes_per_block, nz - gz), 0)
+              : 0;
+      const int64_t diffusion_lines = diffusion_planes * ny;
+      const int64_t gradient_lines = gradient_planes * ny;
+      const int64_t lines_per_grid = diffusion_lines + gradient_lines;
+
+      // work items of the same grid are adjacent
+#pragma omp for schedule(static)
+      for (int64_t i = 0; i < lines_per_grid * num_grids; i++) {
+        auto* dg = grids[i / lines_per_grid];
+        const int64_t line = i % lines_per_grid;
+        dg->WithBuffers([&](auto& c1, auto& c2, auto& gradients) {
+          using T = typename std::decay_t<decltype(c1)>::value_type;
+          if (line < diffusion_lines) {
+            const int64_t y = line % ny;
+            const int64_t z = dz + line / ny;
+            if (y >= border && y < ny - border && z >= border &&
+                z < nz - border) {
+              dg->UpdateEulerLine(c1.data(), c2.data(), y, z, leaking_edge,
+                                  std::get<std::vector<T>>(ghosts).data());
+            }
+          } else if (!dg->lazy_gradients_) {
+            const int64_t j = line - diffusion_lines;
+            dg->UpdateGradientLine(c2.data(), gradients.data(), j % ny,
+                                   gz + j / ny);
           }
+        });
+      }
+    }
 
-          if (z == 0) {
-            b = c;
-            l[2] = 0;
-          } else {
-            b = c - nx * ny;
-          }
+    for (auto* dg : grids) {
+      dg->WithBuffers([](auto& c1, auto& c2, auto&) { c1.swap(c2); });
+      if (calculate_gradients && dg->lazy_gradients_) {
+        dg->CalculateGradient();
+      } else if (calculate_gradients) {
+        dg->init_gradient_ = true;
+      }
+    }
+  }
 
-          if (z == nz - 1) {
-            t = c;
-            l[3] = 0;
-          } else {
-            t = c + nx * ny;
-          }
+  /// Solves the diffusion equation with the alternating direction implicit
+  /// scheme (see `DiffuseADI(bool)`) and closed-edge boundary conditions.
+  /// Substances are not allowed to leave the simulation space.
+  void DiffuseADI() { DiffuseADI(false); }
 
-          c2_[c] = (c1_[c] + d * dt_ * (0 - 2 * c1_[c] + c1_[c + 1]) * ibl2 +
-                    d * dt_ * (c1_[s] - 2 * c1_[c] + c1_[n]) * ibl2 +
-                    d * dt_ * (c1_[b] - 2 * c1_[c] + c1_[t]) * ibl2) *
-                   (1 - mu_);
-#pragma omp simd
-          for (x = 1; x < nx - 1; x++) {
-            ++c;
-            ++n;
-            ++s;
-            ++b;
-            ++t;
-            c2_[c] =
-                (c1_[c] +
-                 d * dt_ * (c1_[c - 1] - 2 * c1_[c] + c1_[c + 1]) * ibl2 +
-                 d * dt_ * (l[0] * c1_[s] - 2 * c1_[c] + l[1] * c1_[n]) * ibl2 +
-                 d * dt_ * (l[2] * c1_[b] - 2 * c1_[c] + l[3] * c1_[t]) *
-                     ibl2) *
-                (1 - mu_);
-          }
-          ++c;
-          ++n;
-          ++s;
-          ++b;
-          ++t;
-          c2_[c] = (c1_[c] + d * dt_ * (c1_[c - 1] - 2 * c1_[c] + 0) * ibl2 +
-                    d * dt_ * (c1_[s] - 2 * c1_[c] + c1_[n]) * ibl2 +
-                    d * dt_ * (c1_[b] - 2 * c1_[c] + c1_[t]) * ibl2) *
-                   (1 - mu_);
-        }  // tile ny
-      }    // tile nz
-    }      // block ny
-    c1_.swap(c2_);
-  }
+  /// Solves the diffusion equation with the alternating direction implicit
+  /// scheme (see `DiffuseADI(bool)`) and leaking-edge boundary conditions.
+  /// Substances are allowed to leave the simulation space.
+  void DiffuseADILeakingEdge() { DiffuseADI(true); }
 
   /// Calculates the gradient for each box in the diffusion grid.
   /// The gradient is calculated in each direction (x, y, z) as following:
@@ -566,8 +608,15 @@ class DiffusionGrid {
   ///
   /// where c(x) implies the concentration at position x
   ///
-  /// At the edges the gradient is the same as the box next to it
+  /// At the edges the gradient is the same as the box next to it\n
+  /// If the gradients are lazy (see `SetLazyGradients`), only the gradients
+  /// that have been cached by `GetGradient` are invalidated.
   void CalculateGradient() {
+    if (lazy_gradients_) {
+      InvalidateGradients();
+      init_gradient_ = true;
+      return;
+    }
     // check if gradient has been calculated once
     // and if diffusion coefficient and decay constant are 0
     // i.e. if we don't need to calculate gradient update
@@ -575,59 +624,32 @@ class DiffusionGrid {
       return;
     }
 
-    double gd = 1 / (box_length_ * 2);
-
-    auto nx = num_boxes_axis_[0];
-    auto ny = num_boxes_axis_[1];
-    auto nz = num_boxes_axis_[2];
-
-#pragma omp parallel for collapse(2)
-    for (size_t z = 0; z < nz; z++) {
-      for (size_t y = 0; y < ny; y++) {
-        for (size_t x = 0; x < nx; x++) {
-          int c, e, w, n, s, b, t;
-          c = x + y * nx + z * nx * ny;
-
-          if (x == 0) {
-            e = c;
-            w = c + 2;
-          } else if (x == nx - 1) {
-            e = c - 2;
-            w = c;
-          } else {
-            e = c - 1;
-            w = c + 1;
-          }
-
-          if (y == 0) {
-            n = c + 2 * nx;
-            s = c;
-          } else if (y == ny - 1) {
-            n = c;
-            s = c - 2 * nx;
-          } else {
-            n = c + nx;
-            s = c - nx;
+    WithBuffers([&](auto& c1, auto&, auto& gradients) {
+      if (IsSparse() && !updated_blocks_.empty()) {
+        // gradients of the other blocks are zero
+        const int64_t num_blocks = updated_blocks_.size();
+#pragma omp parallel for schedule(dynamic, 1)
+        for (int64_t i = 0; i < num_blocks; i++) {
+          std::array<int64_t, 6> r;
+          GetBlockRange(updated_blocks_[i], &r);
+          for (int64_t z = r[4]; z < r[5]; z++) {
+            for (int64_t y = r[2]; y < r[3]; y++) {
+              UpdateGradientLine(c1.data(), gradients.data(), y, z, r[0],
+                                 r[1]);
+            }
           }
-
-          if (z == 0) {
-            t = c + 2 * nx * ny;
-            b = c;
-          } else if (z == nz - 1) {
-            t = c;
-            b = c - 2 * nx * ny;
-          } else {
-            t = c + nx * ny;
-            b = c - nx * ny;
+        }
+      } else {
+        const int64_t ny = num_boxes_axis_[1];
+        const int64_t nz = num_boxes_axis_[2];
+#pragma omp parallel for collapse(2)
+        for (int64_t z = 0; z < nz; z++) {
+          for (int64_t y = 0; y < ny; y++) {
+            UpdateGradientLine(c1.data(), gradients.data(), y, z);
           }
-
-          // Let the gradient point from low to high concentration
-          gradients_[3 * c + 0] = (c1_[w] - c1_[e]) * gd;
-          gradients_[3 * c + 1] = (c1_[n] - c1_[s]) * gd;
-          gradients_[3 * c + 2] = (c1_[t] - c1_[b]) * gd;
         }
       }
-    }
+    });
     if (!init_gradient_) {
       init_gradient_ = true;
     }
@@ -639,36 +661,213 @@ class DiffusionGrid {
     IncreaseConcentrationBy(idx, amount);
   }
 
-  /// Increase the concentration at specified box with specified amount
+  /// Increase the concentration at specified box with specified amount.\n
+  /// Can be called concurrently from different threads (see
+  /// `SetSecretionMode`).
   void IncreaseConcentrationBy(size_t idx, double amount) {
     assert(idx < total_num_boxes_ &&
            "Cell position is out of diffusion grid bounds");
-    c1_[idx] += amount;
-    if (c1_[idx] > concentration_threshold_) {
-      c1_[idx] = concentration_threshold_;
+    if (GetSecretionMode() == Param::SecretionMode::kBuffered) {
+      auto tid = omp_get_thread_num();
+      assert(static_cast<size_t>(tid) < deposits_.size() &&
+             "Thread id exceeds number of threads in ThreadInfo");
+      auto& buckets = deposits_[tid];
+      buckets[idx * buckets.size() / total_num_boxes_].emplace_back(idx,
+                                                                    amount);
+      return;
+    }
+    WithBuffers([&](auto& c1, auto&, auto&) {
+      using T = typename std::decay_t<decltype(c1)>::value_type;
+      // concurrent deposits into the same box must not get lost
+      T* concentration = &c1[idx];
+      T expected;
+      T desired;
+      __atomic_load(concentration, &expected, __ATOMIC_RELAXED);
+      do {
+        desired = std::min(expected + amount, concentration_threshold_);
+      } while (!__atomic_compare_exchange(concentration, &expected, &desired,
+                                          true, __ATOMIC_RELAXED,
+                                          __ATOMIC_RELAXED));
+    });
+    ActivateBlock(idx);
+  }
+
+  /// Adds the deposits that have been buffered by `IncreaseConcentrationBy`
+  /// to the concentration. Each thread processes the deposits of all threads
+  /// into a disjoint range of boxes. Therefore, no synchronization is
+  /// required. Must not be called concurrently with
+  /// `IncreaseConcentrationBy`.\n
+  /// Called automatically before the concentration is updated.
+  void ApplyDeposits() {
+    if (deposits_.empty()) {
+      return;
+    }
+    const int64_t num_buckets = deposits_[0].size();
+    WithBuffers([&](auto& c1, auto&, auto&) {
+#pragma omp parallel for schedule(dynamic, 1)
+      for (int64_t b = 0; b < num_buckets; b++) {
+        for (auto& buckets : deposits_) {
+          for (auto& deposit : buckets[b]) {
+            auto& concentration = c1[deposit.first];
+            concentration = std::min(concentration + deposit.second,
+                                     concentration_threshold_);
+            ActivateBlock(deposit.first);
+          }
+          buckets[b].clear();
+        }
+      }
+    });
+  }
+
+  /// Selects the numerical scheme of this substance (see
+  /// `Param::diffusion_method_`). Grids that are created with
+  /// `ModelInitializer::DefineSubstance` use the value of the parameter.
+  void SetDiffusionMethod(Param::DiffusionMethod method) {
+    diffusion_method_ = method;
+  }
+
+  Param::DiffusionMethod GetDiffusionMethod() const {
+    return diffusion_method_;
+  }
+
+  /// Enables block-sparse updates of the explicit Euler scheme if
+  /// `threshold` is larger than zero
+  /// (see `Param::diffusion_sparsity_threshold_`).
+  /// The grid is divided into blocks of `kBlockLength`^3 boxes. Only active
+  /// blocks, i.e. blocks with concentrations above `threshold` or deposits
+  /// since the last update, and their neighbors are updated. Blocks that are
+  /// neither active nor adjacent to an active block are set to zero.
+  /// Grids that are created with `ModelInitializer::DefineSubstance` use the
+  /// value of the parameter. Has no effect on the ADI scheme.
+  void SetSparsityThreshold(double threshold) {
+    sparsity_threshold_ = threshold;
+    InitializeBlocks(true);
+  }
+
+  double GetSparsityThreshold() const { return sparsity_threshold_; }
+
+  bool IsSparse() const { return sparsity_threshold_ > 0; }
+
+  /// Returns the number of blocks of a sparse grid
+  uint64_t GetNumBlocks() const { return active_blocks_.size(); }
+
+  /// Returns the number of active blocks of a sparse grid
+  uint64_t GetNumActiveBlocks() const {
+    return std::count(active_blocks_.begin(), active_blocks_.end(), 1);
+  }
+
+  /// Stores the concentrations and gradients of this substance in single
+  /// precision (see `Param::diffusion_single_precision_`). All calculations
+  /// are carried out in double precision; only the stored values are
+  /// rounded. Existing data is converted.
+  /// Grids that are created with `ModelInitializer::DefineSubstance` use the
+  /// value of the parameter.
+  void SetSinglePrecision(bool single_precision) {
+    if (single_precision == single_precision_) {
+      return;
     }
+    ApplyDeposits();
+    if (single_precision) {
+      Convert(&c1_, &c1f_);
+      Convert(&c2_, &c2f_);
+      Convert(&gradients_, &gradientsf_);
+    } else {
+      Convert(&c1f_, &c1_);
+      Convert(&c2f_, &c2_);
+      Convert(&gradientsf_, &gradients_);
+    }
+    single_precision_ = single_precision;
+  }
+
+  bool IsSinglePrecision() const { return single_precision_; }
+
+  /// Sets the factor by which the number of boxes along each axis grows at
+  /// least if the grid has to grow (see `Update` and
+  /// `Param::diffusion_grid_growth_factor_`). With a factor of one, the grid
+  /// grows to the minimum size that covers the neighbor grid.
+  /// Grids that are created with `ModelInitializer::DefineSubstance` use the
+  /// value of the parameter.
+  void SetGrowthFactor(double factor) { growth_factor_ = factor; }
+
+  double GetGrowthFactor() const { return growth_factor_; }
+
+  /// If enabled, `CalculateGradient` does not calculate the gradients of all
+  /// boxes. Instead, `GetGradient` calculates the gradient of a box when it
+  /// is queried for the first time after `CalculateGradient` and caches it
+  /// until the next call to `CalculateGradient` (see
+  /// `Param::lazy_gradients_`). `GetAllGradients` only contains the
+  /// gradients of the boxes that have been queried.\n
+  /// Gradients must not depend on the order in which sim objects query and
+  /// secrete. Therefore, deposits are buffered while lazy gradients are
+  /// enabled, regardless of the secretion mode (see `SetSecretionMode`). The
+  /// concentrations do not change between two diffusion steps, and lazy
+  /// gradients are identical to the ones calculated by `CalculateGradient`.
+  /// Grids that are created with `ModelInitializer::DefineSubstance` use the
+  /// value of the parameter.
+  void SetLazyGradients(bool lazy) {
+    ApplyDeposits();
+    lazy_gradients_ = lazy;
+    init_gradient_ = false;
+    InitializeGradientCache();
+    InitializeDeposits();
+  }
+
+  bool HasLazyGradients() const { return lazy_gradients_; }
+
+  /// If enabled, the gradients are normalized when they are calculated
+  /// instead of every time they are queried with `GetGradient`. Thus,
+  /// `GetAllGradients` returns normalized gradients (see
+  /// `Param::normalize_gradients_`). Takes effect the next time the
+  /// gradients are calculated.
+  /// Grids that are created with `ModelInitializer::DefineSubstance` use the
+  /// value of the parameter.
+  void SetNormalizeGradients(bool normalize) {
+    normalize_gradients_ = normalize;
+    init_gradient_ = false;
+    InvalidateGradients();
+  }
+
+  bool HasNormalizedGradients() const { return normalize_gradients_; }
+
+  /// Defines how concurrent calls to `IncreaseConcentrationBy` are
+  /// synchronized (see `Param::secretion_mode_`). Deposits are always
+  /// buffered if lazy gradients are enabled (see `SetLazyGradients`).
+  void SetSecretionMode(Param::SecretionMode mode) {
+    ApplyDeposits();
+    secretion_mode_ = mode;
+    InitializeDeposits();
+  }
+
+  /// Returns the secretion mode that is in effect
+  Param::SecretionMode GetSecretionMode() const {
+    return lazy_gradients_ ? Param::SecretionMode::kBuffered : secretion_mode_;
   }
 
   /// Get the concentration at specified position
   double GetConcentration(const Double3& position) const {
-    return c1_[GetBoxIndex(position)];
+    auto idx = GetBoxIndex(position);
+    return single_precision_ ? c1f_[idx] : c1_[idx];
   }
 
-  /// Get the (normalized) gradient at specified position
-  void GetGradient(const Double3& position, Double3* gradient) const {
+  /// Get the (normalized) gradient at specified position.\n
+  /// If the gradients are lazy (see `SetLazyGradients`), the gradient of the
+  /// box is calculated and cached if this is the first query since the last
+  /// call to `CalculateGradient`. Can be called concurrently from different
+  /// threads.
+  void GetGradient(const Double3& position, Double3* gradient) {
     auto idx = GetBoxIndex(position);
     assert(idx < total_num_boxes_ &&
            "Cell position is out of diffusion grid bounds");
-    (*gradient)[0] = gradients_[3 * idx];
-    (*gradient)[1] = gradients_[3 * idx + 1];
-    (*gradient)[2] = gradients_[3 * idx + 2];
-    auto norm = std::sqrt((*gradient)[0] * (*gradient)[0] +
-                          (*gradient)[1] * (*gradient)[1] +
-                          (*gradient)[2] * (*gradient)[2]);
-    if (norm > 1e-10) {
-      (*gradient)[0] /= norm;
-      (*gradient)[1] /= norm;
-      (*gradient)[2] /= norm;
+    if (lazy_gradients_) {
+      GetLazyGradient(idx, &(*gradient)[0]);
+    } else {
+      for (uint64_t i = 0; i < 3; i++) {
+        (*gradient)[i] = single_precision_ ? gradientsf_[3 * idx + i]
+                                           : gradients_[3 * idx + i];
+      }
+    }
+    if (!normalize_gradients_) {
+      NormalizeGradient(&(*gradient)[0]);
     }
   }
 
@@ -692,15 +891,70 @@ class DiffusionGrid {
     return GetBoxIndex(box_coord);
   }
 
+  /// Returns the largest time step for which the explicit Euler scheme of
+  /// this substance is stable. Diffusion requires `D * dt / bl^2 < 1/6` and
+  /// decay requires `mu * dt < 1`.
+  double GetMaxStableTimeStep() const {
+    double max_dt = std::numeric_limits<double>::max();
+    const double d = 1 - dc_[0];
+    if (d > 0) {
+      max_dt = box_length_ * box_length_ / (6 * d);
+    }
+    if (mu_ > 0) {
+      max_dt = std::min(max_dt, 1 / mu_);
+    }
+    return max_dt;
+  }
+
+  /// Splits `time_interval` into the smallest number of equally long sub
+  /// steps that are stable (see `GetMaxStableTimeStep`) and sets the time
+  /// step of this diffusion grid accordingly.
+  /// @return the number of sub steps
+  uint64_t AdaptTimeStep(double time_interval) {
+    uint64_t sub_steps = 1;
+    auto max_dt = GetMaxStableTimeStep();
+    if (time_interval >= max_dt) {
+      sub_steps = static_cast<uint64_t>(time_interval / max_dt) + 1;
+    }
+    dt_ = time_interval / sub_steps;
+    return sub_steps;
+  }
+
+  void SetTimeStep(double dt) { dt_ = dt; }
+
+  double GetTimeStep() const { return dt_; }
+
+  /// If enabled, the time step is adapted to the stability criterion of this
+  /// substance (see `AdaptTimeStep`) instead of being checked once during
+  /// initialization.
+  void SetSubCycling(bool sub_cycling) { sub_cycling_ = sub_cycling; }
+
+  bool IsSubCycling() const { return sub_cycling_; }
+
   void SetDecayConstant(double mu) { mu_ = mu; }
 
   void SetConcentrationThreshold(double t) { concentration_threshold_ = t; }
 
   double GetConcentrationThreshold() const { return concentration_threshold_; }
 
-  const double* GetAllConcentrations() const { return c1_.data(); }
+  /// Returns the concentrations of all boxes. `T` must be the storage type
+  /// of this grid (`float` for single precision grids, see
+  /// `SetSinglePrecision`).
+  template <typename T = double>
+  const T* GetAllConcentrations() const {
+    assert((std::is_same<T, float>::value == single_precision_) &&
+           "T does not match the storage type of the diffusion grid");
+    return Select<T>(c1_, c1f_).data();
+  }
 
-  const double* GetAllGradients() const { return gradients_.data(); }
+  /// Returns the gradients of all boxes (x, y, z). `T` must be the storage
+  /// type of this grid (see `GetAllConcentrations`).
+  template <typename T = double>
+  const T* GetAllGradients() const {
+    assert((std::is_same<T, float>::value == single_precision_) &&
+           "T does not match the storage type of the diffusion grid");
+    return Select<T>(gradients_, gradientsf_).data();
+  }
 
   const std::array<size_t, 3>& GetNumBoxesArray() const {
     return num_boxes_axis_;
@@ -730,9 +984,15 @@ class DiffusionGrid {
 
   double GetBoxVolume() const { return box_volume_; }
 
+  /// Adds a function that initializes the concentration of this grid (see
+  /// `RunInitializers`). `function(x, y, z)` returns the concentration at
+  /// position (x, y, z). Initializers that also provide the batch interface
+  /// `FillRow(x0, dx, n, y, z, values)` initialize a whole grid line at
+  /// once: they store the concentrations at (x0 + i * dx, y, z) in
+  /// `values[i]` for `i` in [0, n) (see `substance_initializers.h`).
   template <typename F>
   void AddInitializer(F function) {
-    initializers_.push_back(function);
+    AddInitializer(function, 0);
   }
 
   // retrun true if substance concentration and gradient don't evolve over time
@@ -742,6 +1002,615 @@ class DiffusionGrid {
   }
 
  private:
+  /// Adds an initializer that provides the batch interface
+  template <typename F>
+  auto AddInitializer(F function, int) -> decltype(
+      function.FillRow(0.0, 0.0, uint64_t(0), 0.0, 0.0, nullptr), void()) {
+    initializers_.push_back([function](double x0, double dx, uint64_t n,
+                                       double y, double z,
+                                       double* values) mutable {
+      function.FillRow(x0, dx, n, y, z, values);
+    });
+  }
+
+  /// Adds an initializer that is evaluated box by box
+  template <typename F>
+  void AddInitializer(F function, long) {  // NOLINT
+    initializers_.push_back([function](double x0, double dx, uint64_t n,
+                                       double y, double z,
+                                       double* values) mutable {
+      for (uint64_t i = 0; i < n; i++) {
+        values[i] = function(x0 + i * dx, y, z);
+      }
+    });
+  }
+
+  /// Calls `f` with the concentration buffers and the gradients of the
+  /// storage type of this grid (see `SetSinglePrecision`)
+  template <typename F>
+  void WithBuffers(F&& f) {
+    if (single_precision_) {
+      f(c1f_, c2f_, gradientsf_);
+    } else {
+      f(c1_, c2_, gradients_);
+    }
+  }
+
+  /// Returns the argument whose element type is `T`
+  template <typename T>
+  static const ParallelResizeVector<T>& Select(
+      const ParallelResizeVector<double>& d,
+      const ParallelResizeVector<float>& f) {
+    return std::get<const ParallelResizeVector<T>&>(
+        std::forward_as_tuple(d, f));
+  }
+
+  /// Moves the content of `src` to `dst` and releases the memory of `src`
+  template <typename From, typename To>
+  static void Convert(ParallelResizeVector<From>* src,
+                      ParallelResizeVector<To>* dst) {
+    const int64_t size = src->size();
+    dst->resize(size);
+#pragma omp parallel for
+    for (int64_t i = 0; i < size; i++) {
+      (*dst)[i] = static_cast<To>((*src)[i]);
+    }
+    ParallelResizeVector<From>().swap(*src);
+  }
+
+  /// Calculates `steps` time steps of the explicit Euler scheme (see
+  /// `UpdateEulerLine`).\n
+  /// A single time step streams the whole grid through memory. Several time
+  /// steps are therefore calculated in one sweep along z (temporal
+  /// blocking): in each iteration, time step `k` is calculated for the plane
+  /// behind the plane of time step `k - 1`. Thus, only `steps + 2` planes of
+  /// each buffer are accessed at a time, which stay in cache. Time step `k`
+  /// is stored in `c2_` if `k` is odd and in `c1_` if it is even, which
+  /// yields the same result as `steps` separate updates.
+  void EulerSweep(uint64_t steps, bool leaking_edge) {
+    ApplyDeposits();
+    // check if diffusion coefficient and decay constant are 0
+    // i.e. if we don't need to calculate diffusion update
+    if (IsFixedSubstance() || steps == 0) {
+      return;
+    }
+    if (IsSparse()) {
+      for (uint64_t i = 0; i < steps; i++) {
+        SparseEulerStep(leaking_edge);
+      }
+      return;
+    }
+
+    const int64_t nx = num_boxes_axis_[0];
+    const int64_t ny = num_boxes_axis_[1];
+    const int64_t nz = num_boxes_axis_[2];
+    const int64_t nxy = nx * ny;
+    // without leaking edges the border boxes keep their value
+    const int64_t border = leaking_edge ? 0 : 1;
+
+    WithBuffers([&](auto& c1, auto& c2, auto&) {
+      using T = typename std::decay_t<decltype(c1)>::value_type;
+      const std::vector<T> ghost(nx, 0);
+      T* buffers[2] = {c1.data(), c2.data()};
+      if (steps == 1) {
+#pragma omp parallel for collapse(2)
+        for (int64_t z = border; z < nz - border; z++) {
+          for (int64_t y = border; y < ny - border; y++) {
+            UpdateEulerLine(buffers[0], buffers[1], y, z, leaking_edge,
+                            ghost.data());
+          }
+        }
+      } else {
+        const int64_t num_steps = steps;
+#pragma omp parallel
+        for (int64_t p = border; p < nz - border + num_steps - 1; p++) {
+          for (int64_t k = 1; k <= num_steps; k++) {
+            const int64_t z = p - (k - 1);
+            if (z < border || z >= nz - border) {
+              continue;
+            }
+            // barrier at the end of the loop: plane z of time step k is
+            // complete before it is used by time step k + 1
+#pragma omp for
+            for (int64_t y = border; y < ny - border; y++) {
+              UpdateEulerLine(buffers[(k - 1) % 2], buffers[k % 2], y, z,
+                              leaking_edge, ghost.data());
+            }
+          }
+        }
+      }
+      if (steps % 2 == 1) {
+        c1.swap(c2);
+      }
+    });
+  }
+
+  /// Calculates one time step of the explicit Euler scheme for grid line
+  /// (y, z): reads the concentrations from `src` and writes the result to
+  /// `dst`. The line is updated by one branch-free loop over x: out-of-grid
+  /// neighbors along y and z are read from the zero line `ghost` and the
+  /// border boxes along x are peeled off. Without leaking edges, the border
+  /// boxes along x are not updated.\n
+  /// Only the boxes in the range [x0, x1) are updated. The update is
+  /// calculated in double precision independent of the storage type `T`.
+  template <typename T>
+  void UpdateEulerLine(
+      const T* src, T* dst, int64_t y, int64_t z, bool leaking_edge,
+      const T* ghost, int64_t x0 = 0,
+      int64_t x1 = std::numeric_limits<int64_t>::max()) const {
+    const int64_t nx = num_boxes_axis_[0];
+    const int64_t ny = num_boxes_axis_[1];
+    const int64_t nz = num_boxes_axis_[2];
+    const int64_t nxy = nx * ny;
+    const double f = (1 - dc_[0]) * dt_ / (box_length_ * box_length_);
+    const double decay = 1 - mu_ * dt_;
+
+    const int64_t line = y * nx + z * nxy;
+    const T* c = src + line;
+    const T* n = y > 0 ? c - nx : ghost;
+    const T* s = y < ny - 1 ? c + nx : ghost;
+    const T* b = z > 0 ? c - nxy : ghost;
+    const T* t = z < nz - 1 ? c + nxy : ghost;
+    T* out = dst + line;
+    // the neighbors are accumulated in double precision
+    if (leaking_edge && x0 == 0) {
+      const double sum = static_cast<double>(c[1]) + n[0] + s[0] + b[0] + t[0];
+      out[0] = (c[0] + f * (sum - 6.0 * c[0])) * decay;
+    }
+    const int64_t end = std::min(x1, nx - 1);
+#pragma omp simd
+    for (int64_t x = std::max<int64_t>(x0, 1); x < end; x++) {
+      const double sum = static_cast<double>(c[x - 1]) + c[x + 1] + n[x] +
+                         s[x] + b[x] + t[x];
+      out[x] = (c[x] + f * (sum - 6.0 * c[x])) * decay;
+    }
+    if (leaking_edge && x1 >= nx) {
+      const int64_t x = nx - 1;
+      const double sum =
+          static_cast<double>(c[x - 1]) + n[x] + s[x] + b[x] + t[x];
+      out[x] = (c[x] + f * (sum - 6.0 * c[x])) * decay;
+    }
+  }
+
+  /// Calculates the gradients of grid line (y, z) from the concentrations
+  /// `c` (see `CalculateGradient`) and stores them in `gradients`. Only the
+  /// boxes in the range [x0, x1) are updated.
+  template <typename T>
+  void UpdateGradientLine(const T* c, T* gradients, int64_t y, int64_t z,
+                          int64_t x0 = 0,
+                          int64_t x1 = std::numeric_limits<int64_t>::max()) {
+    const int64_t nx = num_boxes_axis_[0];
+    const int64_t ny = num_boxes_axis_[1];
+    const int64_t nz = num_boxes_axis_[2];
+    const int64_t nxy = nx * ny;
+    const double gd = 1 / (box_length_ * 2);
+
+    const int64_t line = y * nx + z * nxy;
+    // neighbor lines along y and z; at the border, the gradient is the same
+    // as the one of the box next to it
+    int64_t n, s, b, t;
+    if (y == 0) {
+      n = line + 2 * nx;
+      s = line;
+    } else if (y == ny - 1) {
+      n = line;
+      s = line - 2 * nx;
+    } else {
+      n = line + nx;
+      s = line - nx;
+    }
+    if (z == 0) {
+      t = line + 2 * nxy;
+      b = line;
+    } else if (z == nz - 1) {
+      t = line;
+      b = line - 2 * nxy;
+    } else {
+      t = line + nxy;
+      b = line - nxy;
+    }
+
+    // Let the gradient point from low to high concentration
+    T* gradient = &gradients[3 * line];
+    if (x0 == 0) {
+      gradient[0] = (c[line + 2] - c[line]) * gd;
+    }
+    const int64_t end = std::min(x1, nx - 1);
+#pragma omp simd
+    for (int64_t x = std::max<int64_t>(x0, 1); x < end; x++) {
+      gradient[3 * x] = (c[line + x + 1] - c[line + x - 1]) * gd;
+    }
+    if (x1 >= nx) {
+      gradient[3 * (nx - 1)] = (c[line + nx - 1] - c[line + nx - 3]) * gd;
+    }
+    x1 = std::min(x1, nx);
+#pragma omp simd
+    for (int64_t x = x0; x < x1; x++) {
+      gradient[3 * x + 1] = (c[n + x] - c[s + x]) * gd;
+      gradient[3 * x + 2] = (c[t + x] - c[b + x]) * gd;
+    }
+    if (normalize_gradients_) {
+      for (int64_t x = x0; x < x1; x++) {
+        NormalizeGradient(&gradient[3 * x]);
+      }
+    }
+  }
+
+  /// Calculates the gradient of box `idx` from the concentrations `c` (same
+  /// result as `UpdateGradientLine`)
+  template <typename T>
+  void CalculateBoxGradient(const T* c, int64_t idx, double* gradient) const {
+    const int64_t nx = num_boxes_axis_[0];
+    const int64_t nxy = nx * num_boxes_axis_[1];
+    const int64_t coord[3] = {idx % nx, idx / nx % num_boxes_axis_[1],
+                              idx / nxy};
+    const int64_t stride[3] = {1, nx, nxy};
+    const double gd = 1 / (box_length_ * 2);
+    for (int i = 0; i < 3; i++) {
+      // at the border, the gradient is the same as the one of the box next to
+      // it
+      const int64_t n = num_boxes_axis_[i];
+      const int64_t low = std::max<int64_t>(std::min(coord[i] - 1, n - 3), 0);
+      const int64_t high = low + 2;
+      gradient[i] = (c[idx + (high - coord[i]) * stride[i]] -
+                     c[idx + (low - coord[i]) * stride[i]]) *
+                    gd;
+    }
+    if (normalize_gradients_) {
+      NormalizeGradient(gradient);
+    }
+  }
+
+  /// Divides `gradient` by its norm unless the norm is (almost) zero
+  template <typename T>
+  static void NormalizeGradient(T* gradient) {
+    double norm = std::sqrt(static_cast<double>(gradient[0]) * gradient[0] +
+                            static_cast<double>(gradient[1]) * gradient[1] +
+                            static_cast<double>(gradient[2]) * gradient[2]);
+    if (norm > 1e-10) {
+      gradient[0] /= norm;
+      gradient[1] /= norm;
+      gradient[2] /= norm;
+    }
+  }
+
+  /// Gradient cache state of a box that is being written by another thread
+  static constexpr uint32_t kGradientBusy =
+      std::numeric_limits<uint32_t>::max();
+
+  /// Allocates the buffers of deposits if they are buffered
+  /// (see `GetSecretionMode`)
+  void InitializeDeposits() {
+    deposits_.clear();
+    if (GetSecretionMode() == Param::SecretionMode::kBuffered) {
+      auto num_threads = ThreadInfo::GetInstance()->GetMaxThreads();
+      deposits_.resize(num_threads);
+      for (auto& buckets : deposits_) {
+        buckets.resize(num_threads);
+      }
+    }
+  }
+
+  /// Allocates the cache of lazy gradients (see `SetLazyGradients`)
+  void InitializeGradientCache() {
+    gradient_epoch_ = 1;
+    if (lazy_gradients_) {
+      gradient_stamps_.assign(total_num_boxes_, 0);
+    } else {
+      gradient_stamps_.clear();
+    }
+  }
+
+  /// Marks all cached lazy gradients as outdated
+  void InvalidateGradients() {
+    gradient_epoch_++;
+    if (gradient_epoch_ == kGradientBusy) {
+      InitializeGradientCache();
+    }
+  }
+
+  /// Returns the gradient of box `idx` from the cache of lazy gradients.
+  /// If it is outdated, it is calculated and cached. Only the thread that
+  /// claims the box in `gradient_stamps_` writes the cache; concurrent
+  /// queries calculate the gradient themselves until the cache is valid.
+  void GetLazyGradient(size_t idx, double* gradient) {
+    auto* stamp = &gradient_stamps_[idx];
+    uint32_t state = __atomic_load_n(stamp, __ATOMIC_ACQUIRE);
+    WithBuffers([&](auto& c1, auto&, auto& gradients) {
+      if (state == gradient_epoch_) {
+        for (uint64_t i = 0; i < 3; i++) {
+          gradient[i] = gradients[3 * idx + i];
+        }
+        return;
+      }
+      CalculateBoxGradient(c1.data(), idx, gradient);
+      if (state != kGradientBusy &&
+          __atomic_compare_exchange_n(stamp, &state, kGradientBusy, false,
+                                      __ATOMIC_ACQUIRE, __ATOMIC_RELAXED)) {
+        for (uint64_t i = 0; i < 3; i++) {
+          gradients[3 * idx + i] = gradient[i];
+        }
+        __atomic_store_n(stamp, gradient_epoch_, __ATOMIC_RELEASE);
+      }
+    });
+  }
+
+  /// Side length of the blocks of a sparse grid in boxes
+  static constexpr int64_t kBlockLength = 8;
+
+  /// Creates the blocks of a sparse grid. If `active` is false, the grid
+  /// must not contain any substance.
+  void InitializeBlocks(bool active) {
+    updated_blocks_.clear();
+    if (!IsSparse()) {
+      active_blocks_.clear();
+      return;
+    }
+    for (int i = 0; i < 3; i++) {
+      num_blocks_axis_[i] =
+          (num_boxes_axis_[i] + kBlockLength - 1) / kBlockLength;
+    }
+    active_blocks_.assign(
+        num_blocks_axis_[0] * num_blocks_axis_[1] * num_blocks_axis_[2],
+        active);
+  }
+
+  /// Marks the block of box `idx` active. Can be called concurrently.
+  void ActivateBlock(size_t idx) {
+    if (active_blocks_.empty()) {
+      return;
+    }
+    const size_t nx = num_boxes_axis_[0];
+    const size_t ny = num_boxes_axis_[1];
+    const size_t x = idx % nx;
+    const size_t y = (idx / nx) % ny;
+    const size_t z = idx / (nx * ny);
+    const size_t block =
+        x / kBlockLength +
+        (y / kBlockLength + z / kBlockLength * num_blocks_axis_[1]) *
+            num_blocks_axis_[0];
+    __atomic_store_n(&active_blocks_[block], 1, __ATOMIC_RELAXED);
+  }
+
+  /// Returns the boxes of `block` as [x0, x1, y0, y1, z0, z1)
+  void GetBlockRange(int64_t block, std::array<int64_t, 6>* range) const {
+    int64_t coord[3] = {block % num_blocks_axis_[0],
+                        block / num_blocks_axis_[0] % num_blocks_axis_[1],
+                        block / (num_blocks_axis_[0] * num_blocks_axis_[1])};
+    for (int i = 0; i < 3; i++) {
+      (*range)[2 * i] = coord[i] * kBlockLength;
+      (*range)[2 * i + 1] =
+          std::min<int64_t>((coord[i] + 1) * kBlockLength, num_boxes_axis_[i]);
+    }
+  }
+
+  /// Marks all blocks that are active or adjacent to an active block
+  /// (including diagonal neighbors) in `result`
+  void DilateActiveBlocks(std::vector<uint8_t>* result) {
+    const int64_t nbx = num_blocks_axis_[0];
+    const int64_t nby = num_blocks_axis_[1];
+    const int64_t nbz = num_blocks_axis_[2];
+    const int64_t nbxy = nbx * nby;
+    const auto& active = active_blocks_;
+    auto& tmp = block_buffer_;
+    result->resize(active.size());
+    tmp.resize(active.size());
+    // one pass per axis: x into result, y into tmp, z into result
+    for (int64_t b = 0; b < nbxy * nbz; b++) {
+      const int64_t x = b % nbx;
+      (*result)[b] = active[b] | (x > 0 && active[b - 1]) |
+                     (x < nbx - 1 && active[b + 1]);
+    }
+    for (int64_t b = 0; b < nbxy * nbz; b++) {
+      const int64_t y = b / nbx % nby;
+      tmp[b] = (*result)[b] | (y > 0 && (*result)[b - nbx]) |
+               (y < nby - 1 && (*result)[b + nbx]);
+    }
+    for (int64_t b = 0; b < nbxy * nbz; b++) {
+      const int64_t z = b / nbxy;
+      (*result)[b] = tmp[b] | (z > 0 && tmp[b - nbxy]) |
+                     (z < nbz - 1 && tmp[b + nbxy]);
+    }
+  }
+
+  /// Calculates one time step of the explicit Euler scheme for the active
+  /// blocks of a sparse grid and their neighbors (see
+  /// `SetSparsityThreshold`). Afterwards, the blocks are classified again.
+  /// Blocks that have been updated, but are not adjacent to an active block
+  /// any more, are set to zero in both buffers. Hence, blocks that are not
+  /// updated have the same (zero) concentration in both buffers.
+  void SparseEulerStep(bool leaking_edge) {
+    const int64_t nx = num_boxes_axis_[0];
+    const int64_t ny = num_boxes_axis_[1];
+    const int64_t nz = num_boxes_axis_[2];
+    // without leaking edges the border boxes keep their value
+    const int64_t border = leaking_edge ? 0 : 1;
+
+    DilateActiveBlocks(&update_flags_);
+    updated_blocks_.clear();
+    for (uint64_t b = 0; b < update_flags_.size(); b++) {
+      if (update_flags_[b]) {
+        updated_blocks_.push_back(b);
+      }
+    }
+    const int64_t num_blocks = updated_blocks_.size();
+
+    WithBuffers([&](auto& c1, auto& c2, auto& gradients) {
+      using T = typename std::decay_t<decltype(c1)>::value_type;
+      const std::vector<T> ghost(nx, 0);
+#pragma omp parallel for schedule(dynamic, 1)
+      for (int64_t i = 0; i < num_blocks; i++) {
+        const auto block = updated_blocks_[i];
+        std::array<int64_t, 6> r;
+        GetBlockRange(block, &r);
+        double max = 0;
+        for (int64_t z = std::max(r[4], border);
+             z < std::min(r[5], nz - border); z++) {
+          for (int64_t y = std::max(r[2], border);
+               y < std::min(r[3], ny - border); y++) {
+            UpdateEulerLine(c1.data(), c2.data(), y, z, leaking_edge,
+                            ghost.data(), r[0], r[1]);
+            const T* line = &c2[y * nx + z * nx * ny];
+            for (int64_t x = r[0]; x < r[1]; x++) {
+              max = std::max<double>(max, line[x]);
+            }
+          }
+        }
+        active_blocks_[block] = max > sparsity_threshold_;
+      }
+
+      // clear blocks that will not be updated in the next step
+      DilateActiveBlocks(&update_flags_);
+#pragma omp parallel for schedule(dynamic, 1)
+      for (int64_t i = 0; i < num_blocks; i++) {
+        const auto block = updated_blocks_[i];
+        if (update_flags_[block]) {
+          continue;
+        }
+        std::array<int64_t, 6> r;
+        GetBlockRange(block, &r);
+        for (int64_t z = r[4]; z < r[5]; z++) {
+          for (int64_t y = r[2]; y < r[3]; y++) {
+            const int64_t line = y * nx + z * nx * ny;
+            for (int64_t x = line + r[0]; x < line + r[1]; x++) {
+              c1[x] = 0;
+              c2[x] = 0;
+              gradients[3 * x] = 0;
+              gradients[3 * x + 1] = 0;
+              gradients[3 * x + 2] = 0;
+            }
+          }
+        }
+      }
+      c1.swap(c2);
+    });
+  }
+
+  /// Alternating direction implicit scheme in its locally one-dimensional
+  /// form: the implicit Euler method is applied to one axis at a time
+  ///
+  ///     (1 - r Dxx) u*      = u(t)
+  ///     (1 - r Dyy) u**     = u*
+  ///     (1 - r Dzz) u(t+dt) = u**
+  ///
+  /// where `r = D * dt / box_length^2` and `Dxx` denotes the second
+  /// difference along x. The scheme is stable for any time step, conserves
+  /// the amount of substance (closed edges) and does not produce negative
+  /// concentrations, even next to point sources. Each stage solves one
+  /// tridiagonal system per grid line with the Thomas algorithm. All lines
+  /// along an axis share the same matrix, which is therefore only factorized
+  /// once. Lines along y and z are processed plane by plane such that the
+  /// innermost loop accesses contiguous memory. Decay is integrated
+  /// exactly.\n
+  /// Closed edges mirror the concentration of the border box (zero flux),
+  /// leaking edges assume zero concentration outside of the grid.
+  void DiffuseADI(bool leaking_edge) {
+    ApplyDeposits();
+    // check if diffusion coefficient and decay constant are 0
+    // i.e. if we don't need to calculate diffusion update
+    if (IsFixedSubstance()) {
+      return;
+    }
+
+    const int64_t nx = num_boxes_axis_[0];
+    const int64_t ny = num_boxes_axis_[1];
+    const int64_t nz = num_boxes_axis_[2];
+    const int64_t nxy = nx * ny;
+
+    const double r = (1 - dc_[0]) * dt_ / (box_length_ * box_length_);
+    const double decay = std::exp(-mu_ * dt_);
+    // concentration outside of the grid relative to the border box
+    const double ghost = leaking_edge ? 0 : 1;
+
+    // LU factorization of the matrix (1 - r D) for a line of length n:
+    // only the reciprocal pivots need to be stored, because all off-diagonal
+    // elements are -r
+    auto factorize = [&](int64_t n) {
+      std::vector<double> inv_pivots(n);
+      double upper = 0;
+      for (int64_t i = 0; i < n; i++) {
+        double diagonal = 1 + r * (2 - ghost * ((i == 0) + (i == n - 1)));
+        inv_pivots[i] = 1 / (diagonal + r * upper);
+        upper = -r * inv_pivots[i];
+      }
+      return inv_pivots;
+    };
+    const auto inv_x = factorize(nx);
+    const auto inv_y = factorize(ny);
+    const auto inv_z = factorize(nz);
+
+    WithBuffers([&](auto& c1, auto& c2, auto&) {
+      // x sweep: forward and back substitution along each line
+#pragma omp parallel for collapse(2)
+      for (int64_t z = 0; z < nz; z++) {
+        for (int64_t y = 0; y < ny; y++) {
+          const int64_t line = y * nx + z * nxy;
+          double previous = 0;
+          for (int64_t x = 0; x < nx; x++) {
+            previous = (decay * c1[line + x] + r * previous) * inv_x[x];
+            c2[line + x] = previous;
+          }
+          for (int64_t x = nx - 2; x >= 0; x--) {
+            c2[line + x] += r * inv_x[x] * c2[line + x + 1];
+          }
+        }
+      }
+
+      // y sweep
+#pragma omp parallel for
+      for (int64_t z = 0; z < nz; z++) {
+        const int64_t plane = z * nxy;
+#pragma omp simd
+        for (int64_t x = 0; x < nx; x++) {
+          c2[plane + x] *= inv_y[0];
+        }
+        for (int64_t y = 1; y < ny; y++) {
+          const int64_t line = plane + y * nx;
+          const double inv = inv_y[y];
+#pragma omp simd
+          for (int64_t x = 0; x < nx; x++) {
+            c2[line + x] = (c2[line + x] + r * c2[line + x - nx]) * inv;
+          }
+        }
+        for (int64_t y = ny - 2; y >= 0; y--) {
+          const int64_t line = plane + y * nx;
+          const double factor = r * inv_y[y];
+#pragma omp simd
+          for (int64_t x = 0; x < nx; x++) {
+            c2[line + x] += factor * c2[line + x + nx];
+          }
+        }
+      }
+
+      // z sweep
+#pragma omp parallel for
+      for (int64_t y = 0; y < ny; y++) {
+        const int64_t row = y * nx;
+#pragma omp simd
+        for (int64_t x = 0; x < nx; x++) {
+          c2[row + x] *= inv_z[0];
+        }
+        for (int64_t z = 1; z < nz; z++) {
+          const int64_t line = row + z * nxy;
+          const double inv = inv_z[z];
+#pragma omp simd
+          for (int64_t x = 0; x < nx; x++) {
+            c2[line + x] = (c2[line + x] + r * c2[line + x - nxy]) * inv;
+          }
+        }
+        for (int64_t z = nz - 2; z >= 0; z--) {
+          const int64_t line = row + z * nxy;
+          const double factor = r * inv_z[z];
+#pragma omp simd
+          for (int64_t x = 0; x < nx; x++) {
+            c2[line + x] += factor * c2[line + x + nxy];
+          }
+        }
+      }
+      c1.swap(c2);
+    });
+  }
+
   /// The id of the substance of this grid
   int substance_ = 0;
   /// The name of the substance of this grid
@@ -756,12 +1625,19 @@ class DiffusionGrid {
   ParallelResizeVector<double> c2_ = {};
   /// The array of gradients (x, y, z)
   ParallelResizeVector<double> gradients_ = {};
+  /// Single precision counterparts of `c1_`, `c2_` and `gradients_`. Only
+  /// the buffers of the storage type of this grid are allocated.
+  ParallelResizeVector<float> c1f_ = {};
+  ParallelResizeVector<float> c2f_ = {};
+  ParallelResizeVector<float> gradientsf_ = {};
+  /// \see SetSinglePrecision
+  bool single_precision_ = false;
   /// The maximum concentration value that a box can have
   double concentration_threshold_ = 1e15;
   /// The diffusion coefficients [cc, cw, ce, cs, cn, cb, ct]
   std::array<double, 7> dc_ = {{0}};
-  /// The timestep resolution fhe diffusion grid
-  // TODO(ahmad): this probably needs to scale with Param::simulation_timestep
+  /// The timestep resolution fhe diffusion grid. Is set to a stable fraction
+  /// of `Param::simulation_time_step_` if the grid is sub-cycled.
   double dt_ = 1;
   /// The decay constant
   double mu_ = 0;
@@ -778,11 +1654,47 @@ class DiffusionGrid {
   /// If false, grid dimensions are even; if true, they are odd
   bool parity_ = false;
   /// A list of functions that initialize this diffusion grid
-  std::vector<std::function<double(double, double, double)>> initializers_ = {};
+  /// The signature is the one of the batch interface (see `AddInitializer`)
+  std::vector<
+      std::function<void(double, double, uint64_t, double, double, double*)>>
+      initializers_ = {};
   // turn to true after gradient initialization
   bool init_gradient_ = false;
-
-  BDM_CLASS_DEF_NV(DiffusionGrid, 1);
+  /// Derive the time step from the stability criterion (see `AdaptTimeStep`)
+  bool sub_cycling_ = false;  //!
+  /// \see SetDiffusionMethod
+  Param::DiffusionMethod diffusion_method_ =
+      Param::DiffusionMethod::kExplicitEuler;  //!
+  /// \see SetSparsityThreshold
+  double sparsity_threshold_ = 0;  //!
+  /// \see SetGrowthFactor
+  double growth_factor_ = 1;  //!
+  /// \see SetLazyGradients
+  bool lazy_gradients_ = false;  //!
+  /// \see SetNormalizeGradients
+  bool normalize_gradients_ = false;  //!
+  /// Lazy gradients: the gradient of a box is cached if its stamp is equal
+  /// to `gradient_epoch_`, which is incremented by `CalculateGradient`
+  std::vector<uint32_t> gradient_stamps_;  //!
+  uint32_t gradient_epoch_ = 1;  //!
+  /// The number of blocks of a sparse grid at each axis [x, y, z]
+  std::array<int64_t, 3> num_blocks_axis_ = {{0}};  //!
+  /// Flags of the active blocks of a sparse grid
+  std::vector<uint8_t> active_blocks_;  //!
+  /// Blocks that have been updated in the last time step
+  std::vector<uint32_t> updated_blocks_;  //!
+  /// Buffers to determine the blocks that need to be updated
+  std::vector<uint8_t> update_flags_;  //!
+  std::vector<uint8_t> block_buffer_;  //!
+  /// \see SetSecretionMode
+  Param::SecretionMode secretion_mode_ = Param::SecretionMode::kAtomic;  //!
+  /// Deposits that have not been added to `c1_` yet (buffered secretion
+  /// mode). `deposits_[t][b]` contains the deposits of thread `t` into the
+  /// `b`-th range of boxes.
+  std::vector<std::vector<std::vector<std::pair<size_t, double>>>>
+      deposits_;  //!
+
+  BDM_CLASS_DEF_NV(DiffusionGrid, 2);
 };
 
 }  // namespace bdm
@@ -14,6 +14,8 @@
 
 #include "core/execution_context/in_place_exec_ctxt.h"
 
+#include <algorithm>
+
 #include "core/grid.h"
 #include "core/resource_manager.h"
 #include "core/sim_object/sim_object.h"
@@ -24,8 +26,8 @@ InPlaceExecutionContext::InPlaceExecutionContext()
     : tinfo_(ThreadInfo::GetInstance()) {}
 
 InPlaceExecutionContext::~InPlaceExecutionContext() {
-  for (auto& el : new_sim_objects_) {
-    delete el.second;
+  for (uint64_t i = 0; i < num_new_sim_objects_; i++) {
+    delete new_sim_objects_[i];
   }
 }
 
@@ -45,7 +47,7 @@ void InPlaceExecutionContext::TearDownIterationAll(
     auto* ctxt = all_exec_ctxts[tid];
     int nid = tinfo_->GetNumaNode(tid);
     thread_offsets[tid] = new_so_per_numa[nid];
-    new_so_per_numa[nid] += ctxt->new_sim_objects_.size();
+    new_so_per_numa[nid] += ctxt->num_new_sim_objects_;
   }
 
   // reserve enough memory in ResourceManager
@@ -61,8 +63,12 @@ void InPlaceExecutionContext::TearDownIterationAll(
     auto* ctxt = all_exec_ctxts[i];
     int nid = tinfo_->GetNumaNode(i);
     uint64_t offset = thread_offsets[i] + numa_offsets[nid];
+    ctxt->new_sim_objects_.resize(ctxt->num_new_sim_objects_);
     rm->AddNewSimObjects(nid, offset, ctxt->new_sim_objects_);
     ctxt->new_sim_objects_.clear();
+    ctxt->num_new_sim_objects_ = 0;
+    ctxt->new_sim_object_index_.clear();
+    ctxt->num_indexed_sim_objects_ = 0;
   }
 
   // remove
@@ -80,108 +86,141 @@ void InPlaceExecutionContext::TearDownIterationAll(
 
 void InPlaceExecutionContext::Execute(
     SimObject* so, const std::vector<Operation>& operations) {
+  Execute(so, SoHandle(), operations);
+}
+
+void InPlaceExecutionContext::Execute(
+    SimObject* so, SoHandle soh, const std::vector<Operation>& operations) {
+  current_so_ = so;
+  current_soh_ = soh;
   auto* grid = Simulation::GetActive()->GetGrid();
   auto nb_mutex_builder = grid->GetNeighborMutexBuilder();
   if (nb_mutex_builder != nullptr) {
     auto mutex = nb_mutex_builder->GetMutex(so->GetBoxIdx());
     std::lock_guard<decltype(mutex)> guard(mutex);
-    neighbor_cache_.clear();
     for (auto& op : operations) {
       op(so);
     }
   } else {
-    neighbor_cache_.clear();
     for (auto& op : operations) {
       op(so);
     }
   }
+  current_so_ = nullptr;
 }
 
 void InPlaceExecutionContext::push_back(SimObject* new_so) {  // NOLINT
-  new_sim_objects_[new_so->GetUid()] = new_so;
+  // Only the owning thread appends. Other threads only read published
+  // elements. Therefore, the lock is only needed if the storage is
+  // reallocated.
+  auto size = num_new_sim_objects_.load(std::memory_order_relaxed);
+  if (size == new_sim_objects_.size()) {
+    std::lock_guard<Spinlock> guard(mutex_);
+    new_sim_objects_.resize(std::max<uint64_t>(2 * size, 64));
+  }
+  new_sim_objects_[size] = new_so;
+  num_new_sim_objects_.store(size + 1, std::memory_order_release);
 }
 
 void InPlaceExecutionContext::ForEachNeighbor(
     const std::function<void(const SimObject*)>& lambda,
     const SimObject& query) {
-  // use values in cache
-  if (neighbor_cache_.size() != 0) {
-    for (auto& pair : neighbor_cache_) {
-      lambda(pair.first);
-    }
+  auto* grid = Simulation::GetActive()->GetGrid();
+  auto for_each = [&](const SimObject* so, double) { lambda(so); };
+  if (&query == current_so_ &&
+      grid->ForEachCachedNeighbor(for_each, query, current_soh_)) {
     return;
   }
-
-  auto* grid = Simulation::GetActive()->GetGrid();
   grid->ForEachNeighbor(lambda, query);
 }
 
 void InPlaceExecutionContext::ForEachNeighbor(
     const std::function<void(const SimObject*, double)>& lambda,
     const SimObject& query) {
-  // use values in cache
-  if (neighbor_cache_.size() != 0) {
-    for (auto& pair : neighbor_cache_) {
-      lambda(pair.first, pair.second);
-    }
+  auto* grid = Simulation::GetActive()->GetGrid();
+  if (&query == current_so_ &&
+      grid->ForEachCachedNeighbor(lambda, query, current_soh_)) {
     return;
   }
-
-  // forward call to grid and populate cache
-  auto* grid = Simulation::GetActive()->GetGrid();
-  auto* param = Simulation::GetActive()->GetParam();
-  auto for_each = [&, this](const SimObject* so, double squared_distance) {
-    if (param->cache_neighbors_) {
-      this->neighbor_cache_.push_back(make_pair(so, squared_distance));
-    }
-    lambda(so, squared_distance);
-  };
-  grid->ForEachNeighbor(for_each, query);
+  grid->ForEachNeighbor(lambda, query);
 }
 
 void InPlaceExecutionContext::ForEachNeighborWithinRadius(
     const std::function<void(const SimObject*)>& lambda, const SimObject& query,
     double squared_radius) {
-  // use values in cache
-  if (neighbor_cache_.size() != 0) {
-    for (auto& pair : neighbor_cache_) {
-      if (pair.second < squared_radius) {
-        lambda(pair.first);
-      }
-    }
-    return;
-  }
-
-  // forward call to grid and populate cache
   auto* grid = Simulation::GetActive()->GetGrid();
-  auto* param = Simulation::GetActive()->GetParam();
-  auto for_each = [&, this](const SimObject* so, double squared_distance) {
-    if (param->cache_neighbors_) {
-      this->neighbor_cache_.push_back(make_pair(so, squared_distance));
-    }
+  auto for_each = [&](const SimObject* so, double squared_distance) {
     if (squared_distance < squared_radius) {
       lambda(so);
     }
   };
+  if (&query == current_so_ &&
+      grid->ForEachCachedNeighbor(for_each, query, current_soh_)) {
+    return;
+  }
   grid->ForEachNeighbor(for_each, query);
 }
 
 SimObject* InPlaceExecutionContext::GetSimObject(SoUid uid) {
-  auto* so = GetCachedSimObject(uid);
+  auto* sim = Simulation::GetActive();
+  auto* rm = sim->GetResourceManager();
+  auto* so = rm->GetSimObject(uid);
   if (so != nullptr) {
     return so;
   }
 
+  // new sim objects are not stored in the ResourceManager yet
+  so = GetCachedSimObject(uid);
+  if (so != nullptr) {
+    return so;
+  }
+  for (auto* ctxt : sim->GetAllExecCtxts()) {
+    so = ctxt != this ? ctxt->GetCachedSimObject(uid) : nullptr;
+    if (so != nullptr) {
+      return so;
+    }
+  }
+  return nullptr;
+}
+
+SimObject* InPlaceExecutionContext::GetSimObject(
+    SoUid uid, std::atomic<uint64_t>* cache) {
   auto* sim = Simulation::GetActive();
   auto* rm = sim->GetResourceManager();
-  so = rm->GetSimObject(uid);
+  // layout of cache: generation (16 bit), numa node (16 bit), element
+  // index (32 bit)
+  uint64_t generation = ResourceManager::GetLayoutGeneration() & 0xFFFF;
+
+  uint64_t cached = cache->load(std::memory_order_relaxed);
+  SoHandle cached_handle(static_cast<SoHandle::NumaNode_t>(cached >> 32),
+                         static_cast<SoHandle::ElementIdx_t>(cached));
+  if (cached >> 48 == generation && rm->ContainsSoHandle(cached_handle)) {
+    auto* so = rm->GetSimObjectWithSoHandle(cached_handle);
+    // The uid check detects handles of a different simulation and of an
+    // earlier generation with the same lower 16 bits.
+    if (so->GetUid() == uid) {
+      return so;
+    }
+  }
+
+  SoHandle soh;
+  auto* so = rm->GetSimObject(uid, &soh);
   if (so != nullptr) {
+    cache->store(generation << 48 |
+                     static_cast<uint64_t>(soh.GetNumaNode()) << 32 |
+                     soh.GetElementIdx(),
+                 std::memory_order_relaxed);
     return so;
   }
 
-  // sim object must be cached in another InPlaceExecutionContext
+  // new sim objects are not stored in the ResourceManager yet and can
+  // therefore not be cached
+  so = GetCachedSimObject(uid);
+  if (so != nullptr) {
+    return so;
+  }
   for (auto* ctxt : sim->GetAllExecCtxts()) {
-    so = ctxt->GetCachedSimObject(uid);
+    so = ctxt != this ? ctxt->GetCachedSimObject(uid) : nullptr;
     if (so != nullptr) {
       return so;
     }
@@ -202,14 +241,23 @@ void InPlaceExecutionContext::DisableNeighborGuard() {
 }
 
 SimObject* InPlaceExecutionContext::GetCachedSimObject(SoUid uid) {
-  SimObject* ret_val = nullptr;
-  auto search_it = new_sim_objects_.find(uid);
-  if (search_it != new_sim_objects_.end()) {
-    ret_val = search_it->second;
+  auto size = num_new_sim_objects_.load(std::memory_order_acquire);
+  if (size == 0) {
+    return nullptr;
+  }
+  std::lock_guard<Spinlock> guard(mutex_);
+  // update index
+  for (; num_indexed_sim_objects_ < size;
+       num_indexed_sim_objects_++) {
+    auto* so = new_sim_objects_[num_indexed_sim_objects_];
+    new_sim_object_index_[so->GetUid()] = so;
   }
-  return ret_val;
-}
 
-// TODO(lukas) Add tests for caching mechanism in ForEachNeighbor*
+  auto search_it = new_sim_object_index_.find(uid);
+  if (search_it != new_sim_object_index_.end()) {
+    return search_it->second;
+  }
+  return nullptr;
+}
 
 }  // namespace bdm
@@ -15,13 +15,16 @@
 #ifndef CORE_EXECUTION_CONTEXT_IN_PLACE_EXEC_CTXT_H_
 #define CORE_EXECUTION_CONTEXT_IN_PLACE_EXEC_CTXT_H_
 
-#include <tbb/concurrent_unordered_map.h>
+#include <atomic>
 #include <functional>
+#include <unordered_map>
 #include <utility>
 #include <vector>
 
 #include "core/operation/operation.h"
+#include "core/sim_object/so_handle.h"
 #include "core/sim_object/so_uid.h"
+#include "core/util/spinlock.h"
 #include "core/util/thread_info.h"
 
 namespace bdm {
@@ -67,6 +70,12 @@ class InPlaceExecutionContext {
   /// in the argument
   void Execute(SimObject* so, const std::vector<Operation>& operations);
 
+  /// Same as `Execute(so, operations)`, but `soh` is the SoHandle of `so`.
+  /// Neighbor queries of `so` use it to access the neighbor cache directly
+  /// (see `Grid::ForEachCachedNeighbor`).
+  void Execute(SimObject* so, SoHandle soh,
+               const std::vector<Operation>& operations);
+
   void push_back(SimObject* new_so);  // NOLINT
 
   void ForEachNeighbor(const std::function<void(const SimObject*)>& lambda,
@@ -83,10 +92,32 @@ class InPlaceExecutionContext {
 
   SimObject* GetSimObject(SoUid uid);
 
+  /// Same as `GetSimObject(uid)`, but uses the SoHandle stored in `cache` if
+  /// it has been obtained in the current layout generation of the
+  /// ResourceManager. Otherwise, the sim object is looked up by `uid` and the
+  /// cache is updated.\n
+  /// `cache` packs the SoHandle and the lower 16 bits of the layout
+  /// generation into one word. Therefore, it can be used by several threads
+  /// concurrently without observing a torn handle/generation pair. A matching
+  /// generation after a wraparound is detected by comparing the uid.
+  /// \see ResourceManager::GetLayoutGeneration
+  SimObject* GetSimObject(SoUid uid, std::atomic<uint64_t>* cache);
+
   const SimObject* GetConstSimObject(SoUid uid);
 
   void RemoveFromSimulation(SoUid uid);
 
+  /// Applies `lambda` to each sim object that has been added during this
+  /// iteration and that has not been committed to the ResourceManager yet.
+  /// This function is not thread-safe.
+  template <typename TLambda>
+  void ForEachNewSimObject(const TLambda& lambda) const {
+    auto size = num_new_sim_objects_.load(std::memory_order_acquire);
+    for (uint64_t i = 0; i < size; i++) {
+      lambda(new_sim_objects_[i]);
+    }
+  }
+
   /// If a sim objects modifies other simulation objects while it is updated,
   /// race conditions can occur using this execution context. This function
   /// turns the protection mechanism off to improve performance. This is safe
@@ -96,17 +127,35 @@ class InPlaceExecutionContext {
  private:
   ThreadInfo* tinfo_;
 
+  /// Sim object that is currently executed and its SoHandle (invalid if it
+  /// is unknown)
+  SimObject* current_so_ = nullptr;
+  SoHandle current_soh_;
+
   /// Contains unique ids of sim objects that will be removed at the end of each
   /// iteration.
   std::vector<SoUid> remove_;
 
-  /// Pointer to new sim objects
-  tbb::concurrent_unordered_map<SoUid, SimObject*> new_sim_objects_;
-
-  /// prevent race conditions for cached SimObjects
-  std::atomic_flag mutex_ = ATOMIC_FLAG_INIT;
-
-  std::vector<std::pair<const SimObject*, double>> neighbor_cache_;
+  /// Pointer to new sim objects in the order they have been added.\n
+  /// Only the first `num_new_sim_objects_` elements are valid. The remaining
+  /// elements are reserved for subsequent insertions.
+  std::vector<SimObject*> new_sim_objects_;
+  /// Number of new sim objects. Only modified by the owning thread and
+  /// published with release semantics after the element has been written.
+  std::atomic<uint64_t> num_new_sim_objects_ = {0};
+
+  /// Maps the uids of new sim objects to their pointer.\n
+  /// Only required by `GetCachedSimObject`. Therefore, it is built lazily
+  /// and contains the first `num_indexed_sim_objects_` elements of
+  /// `new_sim_objects_`.
+  std::unordered_map<SoUid, SimObject*> new_sim_object_index_;
+  uint64_t num_indexed_sim_objects_ = 0;
+
+  /// Prevents reallocations of `new_sim_objects_` while it is read, and
+  /// protects `new_sim_object_index_` (`GetCachedSimObject` can be called
+  /// from other threads). `push_back` only acquires it if
+  /// `new_sim_objects_` has to grow.
+  Spinlock mutex_;
 
   SimObject* GetCachedSimObject(SoUid uid);
 };
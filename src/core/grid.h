@@ -26,6 +26,7 @@
 #include <limits>
 #include <memory>
 #include <mutex>
+#include <numeric>
 #ifdef LINUX
 #include <parallel/algorithm>
 #endif  // LINUX
@@ -41,6 +42,7 @@
 #include "core/container/sim_object_vector.h"
 #include "core/param/param.h"
 #include "core/resource_manager.h"
+#include "core/shape.h"
 #include "core/util/log.h"
 #include "core/util/spinlock.h"
 
@@ -91,10 +93,9 @@ class CircularBuffer {
 
 /// A class that represents Cartesian 3D grid
 class Grid {
-  // DisplacementOpCuda needs access to some Grid private members to reconstruct
-  // the grid on GPU (same for DisplacementOpOpenCL)
-  friend class DisplacementOpCuda;
-  friend class DisplacementOpOpenCL;
+  // DisplacementSoaData needs access to some Grid private members to flatten
+  // the grid for the GPU kernels and DisplacementOpSoa
+  friend class DisplacementSoaData;
 
  public:
   /// A single unit cube of the grid
@@ -269,6 +270,7 @@ class Grid {
   void ClearGrid() {
     box_length_ = 1;
     largest_object_size_ = 0;
+    contains_only_cells_ = true;
     num_boxes_axis_ = {{0}};
     num_boxes_xy_ = 0;
     int32_t inf = std::numeric_limits<int32_t>::max();
@@ -281,6 +283,7 @@ class Grid {
   /// Updates the grid, as simulation objects may have moved, added or deleted
   void UpdateGrid() {
     auto* rm = Simulation::GetActive()->GetResourceManager();
+    auto* param = Simulation::GetActive()->GetParam();
 
     if (rm->GetNumSimObjects() != 0) {
       ClearGrid();
@@ -345,14 +348,14 @@ class Grid {
 
       // Assign simulation objects to boxes
       rm->ApplyOnAllElementsParallelDynamic(
-          1000, [this](SimObject* sim_object, SoHandle soh) {
+          param->scheduling_batch_size_,
+          [this](SimObject* sim_object, SoHandle soh) {
             const auto& position = sim_object->GetPosition();
             auto idx = this->GetBoxIndex(position);
             auto box = this->GetBoxPointer(idx);
             box->AddObject(soh, &successors_, this);
             sim_object->SetBoxIdx(idx);
           });
-      auto* param = Simulation::GetActive()->GetParam();
       if (param->bound_space_) {
         int min = param->min_bound_;
         int max = param->max_bound_;
@@ -362,10 +365,14 @@ class Grid {
       if (nb_mutex_builder_ != nullptr) {
         nb_mutex_builder_->Update();
       }
+
+      if (param->cache_neighbors_) {
+        UpdateNeighborCache();
+      } else {
+        neighbor_cache_generation_ = 0;
+      }
     } else {
       // There are no sim objects in this simulation
-      auto* param = Simulation::GetActive()->GetParam();
-
       bool uninitialized = boxes_.size() == 0;
       if (uninitialized && param->bound_space_) {
         // Simulation has never had any simulation objects
@@ -493,6 +500,115 @@ class Grid {
     }
   }
 
+  /// Builds the neighbor cache (see `Param::cache_neighbors_`).\n
+  /// For each simulation object, the cache stores the SoHandles of all
+  /// other simulation objects in its Moore neighborhood together with their
+  /// squared distance. These are the same simulation objects the
+  /// `ForEachNeighbor*` functions iterate over. The cache is stored in a
+  /// compressed sparse row format and is built in parallel. Squared
+  /// distances reflect the positions at the time of this call.\n
+  /// Is called at the end of `UpdateGrid` if `Param::cache_neighbors_` is
+  /// enabled. The cache becomes invalid once the layout of the
+  /// ResourceManager changes (see `ResourceManager::GetLayoutGeneration`).
+  void UpdateNeighborCache() {
+    auto* rm = Simulation::GetActive()->GetResourceManager();
+    auto* param = Simulation::GetActive()->GetParam();
+    auto numa_nodes = ThreadInfo::GetInstance()->GetNumaNodes();
+    neighbor_cache_offsets_.resize(numa_nodes);
+    neighbor_cache_handles_.resize(numa_nodes);
+    neighbor_cache_distances_.resize(numa_nodes);
+
+    // count neighbors
+    for (int n = 0; n < numa_nodes; n++) {
+      neighbor_cache_offsets_[n].resize(rm->GetNumSimObjects(n) + 1);
+      neighbor_cache_offsets_[n][0] = 0;
+    }
+    rm->ApplyOnAllElementsParallelDynamic(
+        param->scheduling_batch_size_,
+        [this](SimObject* sim_object, SoHandle soh) {
+          // Moore neighborhood includes the sim object itself
+          neighbor_cache_offsets_[soh.GetNumaNode()][soh.GetElementIdx() + 1] =
+              GetNumSimObjectsInMooreNeighborhood(sim_object->GetBoxIdx()) - 1;
+        });
+
+    // prefix sum
+    for (int n = 0; n < numa_nodes; n++) {
+      auto& offsets = neighbor_cache_offsets_[n];
+      std::partial_sum(offsets.begin(), offsets.end(), offsets.begin());
+      if (neighbor_cache_handles_[n].size() < offsets.back()) {
+        neighbor_cache_handles_[n].resize(offsets.back());
+        neighbor_cache_distances_[n].resize(offsets.back());
+      }
+    }
+
+    // fill
+    rm->ApplyOnAllElementsParallelDynamic(
+        param->scheduling_batch_size_,
+        [this, rm](SimObject* sim_object, SoHandle soh) {
+          auto nid = soh.GetNumaNode();
+          auto& handles = neighbor_cache_handles_[nid];
+          auto& distances = neighbor_cache_distances_[nid];
+          uint64_t i = neighbor_cache_offsets_[nid][soh.GetElementIdx()];
+          const auto& position = sim_object->GetPosition();
+
+          FixedSizeVector<const Box*, 27> neighbor_boxes;
+          GetMooreBoxes(&neighbor_boxes, sim_object->GetBoxIdx());
+          NeighborIterator ni(neighbor_boxes, timestamp_);
+          while (!ni.IsAtEnd()) {
+            auto neighbor_soh = *ni;
+            ++ni;
+            if (neighbor_soh == soh) {
+              continue;
+            }
+            const auto& neighbor_position =
+                rm->GetSimObjectWithSoHandle(neighbor_soh)->GetPosition();
+            const double dx = neighbor_position[0] - position[0];
+            const double dy = neighbor_position[1] - position[1];
+            const double dz = neighbor_position[2] - position[2];
+            handles[i] = neighbor_soh;
+            distances[i] = dx * dx + dy * dy + dz * dz;
+            i++;
+          }
+          assert(i == neighbor_cache_offsets_[nid][soh.GetElementIdx() + 1] &&
+                 "Number of cached neighbors does not match the count");
+        });
+
+    neighbor_cache_generation_ = ResourceManager::GetLayoutGeneration();
+  }
+
+  /// Applies the given lambda to each cached neighbor of `query`
+  /// (see `UpdateNeighborCache`). `lambda` is called with the neighbor and
+  /// its squared distance to `query`.
+  /// @param soh SoHandle of `query`. Identifies the row in the cache.
+  /// @return false if the cache does not contain `query` (e.g. because the
+  ///         cache is disabled or outdated or `query` has been added during
+  ///         this iteration). In this case, `lambda` has not been called.
+  template <typename TLambda>
+  bool ForEachCachedNeighbor(const TLambda& lambda, const SimObject& query,
+                             SoHandle soh) const {
+    if (neighbor_cache_generation_ != ResourceManager::GetLayoutGeneration()) {
+      return false;
+    }
+    auto nid = soh.GetNumaNode();
+    auto idx = static_cast<uint64_t>(soh.GetElementIdx());
+    if (nid >= neighbor_cache_offsets_.size() ||
+        idx + 1 >= neighbor_cache_offsets_[nid].size()) {
+      return false;
+    }
+    auto* rm = Simulation::GetActive()->GetResourceManager();
+    if (rm->GetSimObjectWithSoHandle(soh) != &query) {
+      return false;
+    }
+
+    const auto& handles = neighbor_cache_handles_[nid];
+    const auto& distances = neighbor_cache_distances_[nid];
+    auto end = neighbor_cache_offsets_[nid][idx + 1];
+    for (auto i = neighbor_cache_offsets_[nid][idx]; i < end; i++) {
+      lambda(rm->GetSimObjectWithSoHandle(handles[i]), distances[i]);
+    }
+    return true;
+  }
+
   /// @brief      Applies the given lambda to each neighbor or the specified
   ///             simulation object.
   ///
@@ -594,6 +710,35 @@ class Grid {
     }
   }
 
+  /// Applies `lambda` to each neighbor of `query` in its Moore neighborhood.
+  /// Besides the neighbor, `lambda` receives its SoHandle and its squared
+  /// distance to `query`.
+  template <typename TLambda>
+  void ForEachNeighborWithHandle(const TLambda& lambda,
+                                 const SimObject& query) const {
+    const auto& position = query.GetPosition();
+    auto idx = query.GetBoxIdx();
+
+    FixedSizeVector<const Box*, 27> neighbor_boxes;
+    GetMooreBoxes(&neighbor_boxes, idx);
+
+    auto* rm = Simulation::GetActive()->GetResourceManager();
+
+    NeighborIterator ni(neighbor_boxes, timestamp_);
+    while (!ni.IsAtEnd()) {
+      auto soh = *ni;
+      ++ni;
+      auto* sim_object = rm->GetSimObjectWithSoHandle(soh);
+      if (sim_object != &query) {
+        const auto& neighbor_position = sim_object->GetPosition();
+        const double dx = neighbor_position[0] - position[0];
+        const double dy = neighbor_position[1] - position[1];
+        const double dz = neighbor_position[2] - position[2];
+        lambda(sim_object, soh, dx * dx + dy * dy + dz * dz);
+      }
+    }
+  }
+
   /// @brief      Return the box index in the one dimensional array of the box
   ///             that contains the position
   ///
@@ -610,9 +755,31 @@ class Grid {
     return GetBoxIndex(box_coord);
   }
 
+  /// Returns the number of simulation objects inside the box `box_idx` and
+  /// its surrounding boxes (Moore neighborhood). This is an upper bound for
+  /// the number of neighbors that have to be considered for simulation
+  /// objects inside box `box_idx`.
+  uint64_t GetNumSimObjectsInMooreNeighborhood(size_t box_idx) const {
+    FixedSizeVector<const Box*, 27> neighbor_boxes;
+    GetMooreBoxes(&neighbor_boxes, box_idx);
+    uint64_t num_sim_objects = 0;
+    for (size_t i = 0; i < neighbor_boxes.size(); i++) {
+      if (!neighbor_boxes[i]->IsEmpty(timestamp_)) {
+        num_sim_objects += neighbor_boxes[i]->length_;
+      }
+    }
+    return num_sim_objects;
+  }
+
   /// Gets the size of the largest object in the grid
   double GetLargestObjectSize() const { return largest_object_size_; }
 
+  /// Returns true if all simulation objects in the grid derive from `Cell`
+  /// (see `SimObject::IsCell`). Allows mechanics implementations to skip the
+  /// shape dispatch for each pair of neighbors and to access the data members
+  /// of `Cell` directly (see `Cell::CalculateDisplacement`).
+  bool ContainsOnlyCells() const { return contains_only_cells_; }
+
   const std::array<int32_t, 6>& GetDimensions() const {
     return grid_dimensions_;
   }
@@ -761,6 +928,8 @@ class Grid {
   Adjacency adjacency_;
   /// The size of the largest object in the simulation
   double largest_object_size_ = 0;
+  /// True if all simulation objects in the simulation derive from `Cell`
+  bool contains_only_cells_ = false;
   /// Cube which contains all simulation objects
   /// {x_min, x_max, y_min, y_max, z_min, z_max}
   std::array<int32_t, 6> grid_dimensions_;
@@ -774,6 +943,18 @@ class Grid {
   /// stores pairs of <box morton code,  box pointer> sorted by morton code.
   ParallelResizeVector<std::pair<uint32_t, const Box*>> zorder_sorted_boxes_;
 
+  /// Neighbor cache in compressed sparse row format (one entry per NUMA
+  /// node). The neighbors of the sim object with SoHandle `(n, i)` are stored
+  /// at `neighbor_cache_handles_[n][j]` with
+  /// `neighbor_cache_offsets_[n][i] <= j < neighbor_cache_offsets_[n][i + 1]`
+  /// \see UpdateNeighborCache
+  std::vector<std::vector<uint64_t>> neighbor_cache_offsets_;
+  std::vector<std::vector<SoHandle>> neighbor_cache_handles_;
+  std::vector<std::vector<double>> neighbor_cache_distances_;
+  /// ResourceManager layout generation at the time the neighbor cache has
+  /// been built. Zero if there is no valid cache.
+  uint64_t neighbor_cache_generation_ = 0;
+
   /// Holds instance of NeighborMutexBuilder if it is enabled.
   /// If `DisableNeighborMutexes` has been called this member set to nullptr.
   std::unique_ptr<NeighborMutexBuilder> nb_mutex_builder_ =
@@ -804,6 +985,7 @@ class Grid {
   /// simulation objects
   void CalculateGridDimensions(std::array<double, 6>* ret_grid_dimensions) {
     auto* rm = Simulation::GetActive()->GetResourceManager();
+    auto* param = Simulation::GetActive()->GetParam();
 
     const auto max_threads = omp_get_max_threads();
     // allocate version for each thread - avoid false sharing by padding them
@@ -817,37 +999,42 @@ class Grid {
     std::vector<std::array<double, 8>> zmax(max_threads, {{-Math::kInfinity}});
 
     std::vector<std::array<double, 8>> largest(max_threads, {{0}});
-
-    rm->ApplyOnAllElementsParallelDynamic(1000, [&](SimObject* so, SoHandle) {
-      auto tid = omp_get_thread_num();
-      const auto& position = so->GetPosition();
-      // x
-      if (position[0] < xmin[tid][0]) {
-        xmin[tid][0] = position[0];
-      }
-      if (position[0] > xmax[tid][0]) {
-        xmax[tid][0] = position[0];
-      }
-      // y
-      if (position[1] < ymin[tid][0]) {
-        ymin[tid][0] = position[1];
-      }
-      if (position[1] > ymax[tid][0]) {
-        ymax[tid][0] = position[1];
-      }
-      // z
-      if (position[2] < zmin[tid][0]) {
-        zmin[tid][0] = position[2];
-      }
-      if (position[2] > zmax[tid][0]) {
-        zmax[tid][0] = position[2];
-      }
-      // larget object
-      auto diameter = so->GetDiameter();
-      if (diameter > largest[tid][0]) {
-        largest[tid][0] = diameter;
-      }
-    });
+    std::vector<std::array<bool, 64>> only_cells(max_threads, {{true}});
+
+    rm->ApplyOnAllElementsParallelDynamic(
+        param->scheduling_batch_size_, [&](SimObject* so, SoHandle) {
+          auto tid = omp_get_thread_num();
+          const auto& position = so->GetPosition();
+          // x
+          if (position[0] < xmin[tid][0]) {
+            xmin[tid][0] = position[0];
+          }
+          if (position[0] > xmax[tid][0]) {
+            xmax[tid][0] = position[0];
+          }
+          // y
+          if (position[1] < ymin[tid][0]) {
+            ymin[tid][0] = position[1];
+          }
+          if (position[1] > ymax[tid][0]) {
+            ymax[tid][0] = position[1];
+          }
+          // z
+          if (position[2] < zmin[tid][0]) {
+            zmin[tid][0] = position[2];
+          }
+          if (position[2] > zmax[tid][0]) {
+            zmax[tid][0] = position[2];
+          }
+          // larget object
+          auto diameter = so->GetDiameter();
+          if (diameter > largest[tid][0]) {
+            largest[tid][0] = diameter;
+          }
+          if (!so->IsCell()) {
+            only_cells[tid][0] = false;
+          }
+        });
 
     // reduce partial results into global one
     double& gxmin = (*ret_grid_dimensions)[0];
@@ -882,6 +1069,7 @@ class Grid {
       if (largest[tid][0] > largest_object_size_) {
         largest_object_size_ = largest[tid][0];
       }
+      contains_only_cells_ &= only_cells[tid][0];
     }
   }
 
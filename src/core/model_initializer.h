@@ -171,6 +171,13 @@ struct ModelInitializer {
     DiffusionGrid* d_grid =
         new DiffusionGrid(substance_id, substance_name, diffusion_coeff,
                           decay_constant, resolution);
+    auto* param = sim->GetParam();
+    d_grid->SetDiffusionMethod(param->diffusion_method_);
+    d_grid->SetSparsityThreshold(param->diffusion_sparsity_threshold_);
+    d_grid->SetSinglePrecision(param->diffusion_single_precision_);
+    d_grid->SetGrowthFactor(param->diffusion_grid_growth_factor_);
+    d_grid->SetLazyGradients(param->lazy_gradients_);
+    d_grid->SetNormalizeGradients(param->normalize_gradients_);
     rm->AddDiffusionGrid(d_grid);
   }
 
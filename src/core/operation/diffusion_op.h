@@ -15,6 +15,7 @@
 #ifndef CORE_OPERATION_DIFFUSION_OP_H_
 #define CORE_OPERATION_DIFFUSION_OP_H_
 
+#include <algorithm>
 #include <string>
 #include <utility>
 #include <vector>
@@ -24,6 +25,7 @@
 #include "core/grid.h"
 #include "core/param/param.h"
 #include "core/resource_manager.h"
+#include "core/scheduler.h"
 #include "core/simulation.h"
 
 namespace bdm {
@@ -40,6 +42,8 @@ class DiffusionOp {
     auto* grid = sim->GetGrid();
     auto* param = sim->GetParam();
 
+    // grids that are updated together after the loop
+    std::vector<DiffusionGrid*> fused;
     rm->ApplyOnAllDiffusionGrids([&](DiffusionGrid* dg) {
       // Update the diffusion grid dimension if the neighbor grid dimensions
       // have changed. If the space is bound, we do not need to update the
@@ -52,16 +56,58 @@ class DiffusionOp {
         dg->Update(grid->GetDimensionThresholds());
       }
 
-      if (param->leaking_edges_) {
-        dg->DiffuseEulerLeakingEdge();
+      if (dg->GetDiffusionMethod() == Param::DiffusionMethod::kADI) {
+        // The implicit scheme is stable for any time step. Therefore, the
+        // grid is advanced by one simulation time step in a single update.
+        dg->SetTimeStep(sim->GetScheduler()->GetSimulationTimeStep());
+        if (param->leaking_edges_) {
+          dg->DiffuseADILeakingEdge();
+        } else {
+          dg->DiffuseADI();
+        }
       } else {
-        dg->DiffuseEuler();
+        // Sub-cycled grids are advanced by one simulation time step using as
+        // many stable sub steps as required. Otherwise, a single update with
+        // the grid's own time step is performed.
+        uint64_t sub_steps = 1;
+        if (dg->IsSubCycling()) {
+          sub_steps =
+              dg->AdaptTimeStep(sim->GetScheduler()->GetSimulationTimeStep());
+        }
+        if (param->fuse_diffusion_grids_ && sub_steps == 1 &&
+            !dg->IsFixedSubstance() && !dg->IsSparse()) {
+          fused.push_back(dg);
+          return;
+        }
+        // calculate up to `block_size` sub steps in one sweep
+        const uint64_t block_size =
+            std::max<uint64_t>(param->diffusion_temporal_block_size_, 1);
+        for (uint64_t i = 0; i < sub_steps; i += block_size) {
+          auto steps = std::min(block_size, sub_steps - i);
+          if (param->leaking_edges_) {
+            dg->DiffuseEulerLeakingEdge(steps);
+          } else {
+            dg->DiffuseEuler(steps);
+          }
+        }
       }
 
       if (param->calculate_gradients_) {
         dg->CalculateGradient();
       }
     });
+
+    // grids with the same number of boxes are updated in a single pass
+    auto begin = fused.begin();
+    while (begin != fused.end()) {
+      const auto num_boxes = (*begin)->GetNumBoxesArray();
+      auto end = std::partition(begin, fused.end(), [&](DiffusionGrid* dg) {
+        return dg->GetNumBoxesArray() == num_boxes;
+      });
+      DiffusionGrid::DiffuseEulerFused({begin, end}, param->leaking_edges_,
+                                       param->calculate_gradients_);
+      begin = end;
+    }
   }
 };
 
@@ -18,6 +18,7 @@
 #include <type_traits>
 
 #include "core/operation/displacement_op_cpu.h"
+#include "core/operation/displacement_op_soa.h"
 #ifdef USE_CUDA
 #include "core/operation/displacement_op_cuda.h"
 #endif
@@ -43,15 +44,30 @@ class DisplacementOp {
 
   ~DisplacementOp() {}
 
+  /// Returns true if the displacement is calculated for each sim object
+  /// separately (`DisplacementOpCpu`). Otherwise, `operator()()` calculates
+  /// the displacement of all sim objects at once.
   bool UseCpu() const {
     auto* param = Simulation::GetActive()->GetParam();
     return force_cpu_implementation_ ||
-           (!param->use_gpu_ && !param->use_opencl_);
+           (!param->use_gpu_ && !param->use_opencl_ && !UseSoa());
+  }
+
+  /// Returns true if the data-parallel CPU implementation is used
+  /// (see `Param::use_soa_mechanics_`)
+  bool UseSoa() const {
+    auto* sim = Simulation::GetActive();
+    auto* param = sim->GetParam();
+    return !force_cpu_implementation_ && param->use_soa_mechanics_ &&
+           !param->use_gpu_ && !param->use_opencl_ &&
+           sim->GetGrid()->ContainsOnlyCells();
   }
 
   void operator()() {
     auto* param = Simulation::GetActive()->GetParam();
-    if (param->use_gpu_ && !force_cpu_implementation_) {
+    if (UseSoa()) {
+      soa_();
+    } else if (param->use_gpu_ && !force_cpu_implementation_) {
 #if defined(USE_OPENCL) && !defined(__ROOTCLING__)
       if (param->use_opencl_) {
         opencl_();
@@ -74,7 +90,8 @@ class DisplacementOp {
   /// if this condition is detected. In this case `force_cpu_implementation_`
   /// will be set to true.
   bool force_cpu_implementation_ = false;
-  DisplacementOpCpu cpu_;
+  DisplacementOpCpu<> cpu_;
+  DisplacementOpSoa soa_;
 #ifdef USE_CUDA
   DisplacementOpCuda cuda_;  // NOLINT
 #endif
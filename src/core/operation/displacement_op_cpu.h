@@ -18,21 +18,54 @@
 #include <array>
 #include <cmath>
 #include <limits>
+#include <type_traits>
+#include <typeinfo>
 #include <vector>
 
+#include "core/default_force.h"
 #include "core/grid.h"
 #include "core/operation/bound_space_op.h"
 #include "core/param/param.h"
 #include "core/scheduler.h"
+#include "core/sim_object/cell.h"
 #include "core/sim_object/sim_object.h"
 #include "core/simulation.h"
+#include "core/util/log.h"
 #include "core/util/math.h"
+#include "core/util/time_step_controller.h"
 
 namespace bdm {
 
+/// Calculates and applies the displacement of simulation objects caused by
+/// mechanical forces.\n
+/// The force model is a template parameter and is therefore inlined into the
+/// neighbor loop (see `DefaultForce` for the required interface).
+/// A custom force model can be used by replacing the displacement operation:
+///
+///     struct RepulsiveForce { ... };
+///     auto* op = scheduler->GetOperation("displacement");
+///     *op = Operation("displacement", op->frequency_,
+///                     DisplacementOpCpu<RepulsiveForce>());
+///
+/// A replaced displacement operation is always executed on the CPU, even if
+/// the SoA or GPU backend has been selected, since these only support
+/// `DefaultForce`.
+///
+/// With a custom force model, the displacement is calculated by the templated
+/// `CalculateDisplacement(force, squared_radius, dt)` of the sim object
+/// instead of the virtual `SimObject::CalculateDisplacement`. The supported
+/// sim object types must therefore be listed explicitly after the force model
+/// (default: `Cell`). The dynamic type of each sim object must match one of
+/// them exactly; derived classes must be listed separately. Other sim objects
+/// are rejected with a fatal error.
+///
+///     using experimental::neuroscience::NeuriteElement;
+///     DisplacementOpCpu<RepulsiveForce, Cell, NeuriteElement>()
+template <typename TForce = DefaultForce, typename... TSimObjects>
 class DisplacementOpCpu {
  public:
   DisplacementOpCpu() {}
+  explicit DisplacementOpCpu(const TForce& force) : force_(force) {}
   ~DisplacementOpCpu() {}
 
   void operator()(SimObject* sim_object) {
@@ -52,14 +85,17 @@ class DisplacementOpCpu {
       auto* grid = sim->GetGrid();
       auto search_radius = grid->GetLargestObjectSize();
       squared_radius_ = search_radius * search_radius;
-      auto current_time =
-          (current_iteration + 1) * param->simulation_time_step_;
-      delta_time_ = current_time - last_time_run_;
-      last_time_run_ = current_time;
+      // The displacement operation might not be executed every time step
+      // (see `Operation::frequency_`). Therefore, the integration step must
+      // cover the time until its next execution.
+      delta_time_ = scheduler->GetOperationTimeStep("displacement");
     }
 
-    const auto& displacement =
-        sim_object->CalculateDisplacement(squared_radius_, delta_time_);
+    const auto& displacement = CalculateDisplacement(sim_object);
+    if (param->adaptive_time_step_) {
+      scheduler->GetTimeStepController()->ObserveDisplacement(
+          displacement * displacement);
+    }
     sim_object->ApplyDisplacement(displacement);
     if (param->bound_space_) {
       ApplyBoundingBox(sim_object, param->min_bound_, param->max_bound_);
@@ -67,10 +103,45 @@ class DisplacementOpCpu {
   }
 
  private:
+  TForce force_;
   double squared_radius_ = 0;
-  double last_time_run_ = 0;
   double delta_time_ = 0;
   uint64_t last_iteration_ = std::numeric_limits<uint64_t>::max();
+
+  template <typename... T>
+  struct TypeList {};
+
+  /// Sim object types that support the custom force model
+  using SimObjectTypes =
+      typename std::conditional<sizeof...(TSimObjects) == 0, TypeList<Cell>,
+                                TypeList<TSimObjects...>>::type;
+
+  Double3 CalculateDisplacement(SimObject* sim_object) {
+    if (std::is_same<TForce, DefaultForce>::value) {
+      return sim_object->CalculateDisplacement(squared_radius_, delta_time_);
+    }
+    return CalculateDisplacement(sim_object, SimObjectTypes());
+  }
+
+  template <typename TSimObject, typename... TRest>
+  Double3 CalculateDisplacement(SimObject* sim_object,
+                                TypeList<TSimObject, TRest...>) {
+    if (typeid(*sim_object) == typeid(TSimObject)) {
+      return static_cast<TSimObject*>(sim_object)
+          ->CalculateDisplacement(force_, squared_radius_, delta_time_);
+    }
+    return CalculateDisplacement(sim_object, TypeList<TRest...>());
+  }
+
+  Double3 CalculateDisplacement(SimObject* sim_object, TypeList<>) {
+    Log::Fatal("DisplacementOpCpu",
+               "\nCustom force models are not supported for sim objects of "
+               "type ",
+               sim_object->GetTypeName(),
+               ". Add the type to the template arguments of "
+               "DisplacementOpCpu.");
+    return {0, 0, 0};
+  }
 };
 
 }  // namespace bdm
@@ -21,6 +21,7 @@
 #include "core/gpu/opencl_state.h"
 #include "core/grid.h"
 #include "core/operation/bound_space_op.h"
+#include "core/operation/displacement_soa_data.h"
 #include "core/shape.h"
 #include "core/sim_object/cell.h"
 #include "core/util/thread_info.h"
@@ -34,12 +35,6 @@ class DisplacementOpOpenCL {
   DisplacementOpOpenCL() {}
   ~DisplacementOpOpenCL() {}
 
-  void IsNonSphericalObjectPresent(const SimObject* so, bool* answer) {
-    if (so->GetShape() != Shape::kSphere) {
-      *answer = true;
-    }
-  }
-
   void operator()() {
     auto* sim = Simulation::GetActive();
     auto* grid = sim->GetGrid();
@@ -55,106 +50,50 @@ class DisplacementOpOpenCL {
       return;
     }
 
-    uint32_t num_objects = rm->GetNumSimObjects();
-
     auto* ocl_state = OpenCLState::GetInstance();
     auto context = ocl_state->GetOpenCLContext();
     auto queue = ocl_state->GetOpenCLCommandQueue();
     auto programs = ocl_state->GetOpenCLProgramList();
 
-    // Cannot use Double3 here, because the `data()` function returns a const
-    // pointer to the underlying array, whereas the CUDA kernal will cast it to
-    // a void pointer. The conversion of `const double *` to `void *` is
-    // illegal.
-    std::vector<std::array<cl_double, 3>> cell_movements(num_objects);
-    std::vector<std::array<cl_double, 3>> cell_positions(num_objects);
-    std::vector<cl_double> cell_diameters(num_objects);
-    std::vector<cl_double> cell_adherence(num_objects);
-    std::vector<std::array<cl_double, 3>> cell_tractor_force(num_objects);
-    std::vector<cl_uint> cell_boxid(num_objects);
-    std::vector<cl_double> mass(num_objects);
-    std::vector<cl_uint> starts;
-    std::vector<cl_ushort> lengths;
-    std::vector<cl_uint> successors(num_objects);
-    cl_uint box_length;
-    std::array<cl_uint, 3> num_boxes_axis;
-    std::array<cl_int, 3> grid_dimensions;
+    data_.Update();
+    uint32_t num_objects = data_.num_objects_;
+    std::vector<cl_double> cell_movements(3 * num_objects);
     cl_double squared_radius =
         grid->GetLargestObjectSize() * grid->GetLargestObjectSize();
 
-    bool is_non_spherical_object = false;
-
-    rm->ApplyOnAllElements([&](SimObject* so, SoHandle soh) {
-      // Check if there are any non-spherical objects in our simulation, because
-      // GPU accelerations currently supports only sphere-sphere interactions
-      IsNonSphericalObjectPresent(so, &is_non_spherical_object);
-      if (is_non_spherical_object) {
-        Log::Fatal("DisplacementOpOpenCL",
-                   "\nWe detected a non-spherical object during the GPU "
-                   "execution. This is currently not supported.");
-        return;
-      }
-      auto* cell = bdm_static_cast<Cell*>(so);
-      auto idx = soh.GetElementIdx();
-      mass[idx] = cell->GetMass();
-      cell_diameters[idx] = cell->GetDiameter();
-      cell_adherence[idx] = cell->GetAdherence();
-      cell_boxid[idx] = cell->GetBoxIdx();
-      cell_tractor_force[idx][0] = cell->GetTractorForce()[0];
-      cell_tractor_force[idx][1] = cell->GetTractorForce()[1];
-      cell_tractor_force[idx][2] = cell->GetTractorForce()[2];
-      cell_positions[idx][0] = cell->GetPosition()[0];
-      cell_positions[idx][1] = cell->GetPosition()[1];
-      cell_positions[idx][2] = cell->GetPosition()[2];
-    });
-
-    uint16_t numa_node = 0;  // GPU code only supports 1 NUMA domain currently
-    for (size_t i = 0; i < grid->successors_.size(numa_node); i++) {
-      auto sh = SoHandle(numa_node, i);
-      successors[i] = grid->successors_[sh].GetElementIdx();
-    }
-
-    starts.resize(grid->boxes_.size());
-    lengths.resize(grid->boxes_.size());
-    size_t i = 0;
-    for (auto& box : grid->boxes_) {
-      starts[i] = box.start_.GetElementIdx();
-      lengths[i] = box.length_;
-      i++;
-    }
-    grid->GetGridInfo(&box_length, &num_boxes_axis, &grid_dimensions);
-
     // Allocate GPU buffers
     cl::Buffer positions_arg(*context, CL_MEM_READ_ONLY | CL_MEM_USE_HOST_PTR,
                              num_objects * 3 * sizeof(cl_double),
-                             cell_positions.data()->data());
+                             data_.positions_.data());
     cl::Buffer diameters_arg(*context, CL_MEM_READ_ONLY | CL_MEM_USE_HOST_PTR,
                              num_objects * sizeof(cl_double),
-                             cell_diameters.data());
+                             data_.diameters_.data());
     cl::Buffer tractor_force_arg(
         *context, CL_MEM_READ_ONLY | CL_MEM_USE_HOST_PTR,
-        num_objects * 3 * sizeof(cl_double), cell_tractor_force.data()->data());
+        num_objects * 3 * sizeof(cl_double), data_.tractor_force_.data());
     cl::Buffer adherence_arg(*context, CL_MEM_READ_ONLY | CL_MEM_USE_HOST_PTR,
                              num_objects * sizeof(cl_double),
-                             cell_adherence.data());
+                             data_.adherence_.data());
     cl::Buffer box_id_arg(*context, CL_MEM_READ_ONLY | CL_MEM_USE_HOST_PTR,
-                          num_objects * sizeof(cl_uint), cell_boxid.data());
+                          num_objects * sizeof(cl_uint), data_.box_id_.data());
     cl::Buffer mass_arg(*context, CL_MEM_READ_ONLY | CL_MEM_USE_HOST_PTR,
-                        num_objects * sizeof(cl_double), mass.data());
+                        num_objects * sizeof(cl_double), data_.mass_.data());
     cl::Buffer cell_movements_arg(
         *context, CL_MEM_READ_WRITE | CL_MEM_USE_HOST_PTR,
-        num_objects * 3 * sizeof(cl_double), cell_movements.data()->data());
+        num_objects * 3 * sizeof(cl_double), cell_movements.data());
     cl::Buffer starts_arg(*context, CL_MEM_READ_ONLY | CL_MEM_USE_HOST_PTR,
-                          starts.size() * sizeof(cl_uint), starts.data());
+                          data_.starts_.size() * sizeof(cl_uint),
+                          data_.starts_.data());
     cl::Buffer lengths_arg(*context, CL_MEM_READ_ONLY | CL_MEM_USE_HOST_PTR,
-                           lengths.size() * sizeof(cl_short), lengths.data());
+                           data_.lengths_.size() * sizeof(cl_short),
+                           data_.lengths_.data());
     cl::Buffer successors_arg(*context, CL_MEM_READ_ONLY | CL_MEM_USE_HOST_PTR,
-                              successors.size() * sizeof(cl_uint),
-                              successors.data());
+                              data_.successors_.size() * sizeof(cl_uint),
+                              data_.successors_.data());
     cl::Buffer nba_arg(*context, CL_MEM_READ_ONLY | CL_MEM_USE_HOST_PTR,
-                       3 * sizeof(cl_uint), num_boxes_axis.data());
+                       3 * sizeof(cl_uint), data_.num_boxes_axis_.data());
     cl::Buffer gd_arg(*context, CL_MEM_READ_ONLY | CL_MEM_USE_HOST_PTR,
-                      3 * sizeof(cl_int), grid_dimensions.data());
+                      3 * sizeof(cl_int), data_.grid_dimensions_.data());
 
     // Create the kernel object from our program
     // TODO(ahmad): generalize the program selection, in case we have more than
@@ -176,7 +115,7 @@ class DisplacementOpOpenCL {
     collide.setArg(10, starts_arg);
     collide.setArg(11, lengths_arg);
     collide.setArg(12, successors_arg);
-    collide.setArg(13, box_length);
+    collide.setArg(13, data_.box_length_);
     collide.setArg(14, nba_arg);
     collide.setArg(15, gd_arg);
     collide.setArg(16, cell_movements_arg);
@@ -201,7 +140,7 @@ class DisplacementOpOpenCL {
     try {
       queue->enqueueReadBuffer(cell_movements_arg, CL_TRUE, 0,
                                num_objects * 3 * sizeof(cl_double),
-                               cell_movements.data()->data());
+                               cell_movements.data());
     } catch (const cl::Error& err) {
       Log::Error("DisplacementOpOpenCL", err.what(), "(", err.err(), ") = ",
                  ocl_state->GetErrorString(err.err()));
@@ -211,19 +150,23 @@ class DisplacementOpOpenCL {
     // set new positions after all updates have been calculated
     // otherwise some cells would see neighbors with already updated positions
     // which would lead to inconsistencies
-    rm->ApplyOnAllElements([&](SimObject* so, SoHandle soh) {
-      auto* cell = dynamic_cast<Cell*>(so);
-      auto idx = soh.GetElementIdx();
+#pragma omp parallel for
+    for (uint64_t i = 0; i < num_objects; i++) {
+      auto* so = rm->GetSimObjectWithSoHandle(data_.handles_[i]);
+      auto* cell = bdm_static_cast<Cell*>(so);
       Double3 new_pos;
-      new_pos[0] = cell_movements[idx][0];
-      new_pos[1] = cell_movements[idx][1];
-      new_pos[2] = cell_movements[idx][2];
+      new_pos[0] = cell_movements[3 * i];
+      new_pos[1] = cell_movements[3 * i + 1];
+      new_pos[2] = cell_movements[3 * i + 2];
       cell->UpdatePosition(new_pos);
       if (param->bound_space_) {
         ApplyBoundingBox(so, param->min_bound_, param->max_bound_);
       }
-    });
+    }
   }
+
+ private:
+  DisplacementSoaData data_;
 };
 
 }  // namespace bdm
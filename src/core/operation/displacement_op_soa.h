@@ -0,0 +1,148 @@
+// -----------------------------------------------------------------------------
+//
+// Copyright (C) The BioDynaMo Project.
+// All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+//
+// See the LICENSE file distributed with this work for details.
+// See the NOTICE file distributed with this work for additional information
+// regarding copyright ownership.
+//
+// -----------------------------------------------------------------------------
+
+#ifndef CORE_OPERATION_DISPLACEMENT_OP_SOA_H_
+#define CORE_OPERATION_DISPLACEMENT_OP_SOA_H_
+
+#include <cmath>
+#include <vector>
+
+#include "core/default_force.h"
+#include "core/operation/bound_space_op.h"
+#include "core/operation/displacement_soa_data.h"
+#include "core/param/param.h"
+#include "core/resource_manager.h"
+#include "core/scheduler.h"
+#include "core/simulation.h"
+#include "core/util/time_step_controller.h"
+
+namespace bdm {
+
+/// Data-parallel CPU implementation of the mechanical interactions between
+/// spheres (see `Param::use_soa_mechanics_`).\n
+/// Operates on the flattened data layout of the GPU kernels
+/// (`DisplacementSoaData`). Since sim objects are sorted by grid box, the
+/// neighbors in the Moore neighborhood of a sim object are stored in nine
+/// contiguous ranges, which are processed with the vectorized
+/// `DefaultForce` kernel. As on the GPU, all displacements are calculated
+/// based on the positions at the beginning of the operation before they are
+/// applied.
+class DisplacementOpSoa {
+ public:
+  void operator()() {
+    auto* sim = Simulation::GetActive();
+    auto* grid = sim->GetGrid();
+    auto* param = sim->GetParam();
+    auto* rm = sim->GetResourceManager();
+    auto* scheduler = sim->GetScheduler();
+
+    data_.Update();
+    const double squared_radius =
+        grid->GetLargestObjectSize() * grid->GetLargestObjectSize();
+    const double dt = scheduler->GetOperationTimeStep("displacement");
+    const auto num_objects = data_.num_objects_;
+    movements_.resize(3 * num_objects);
+
+#pragma omp parallel for schedule(dynamic, 256)
+    for (uint64_t i = 0; i < num_objects; i++) {
+      if (data_.run_displacement_[i]) {
+        CalculateDisplacement(i, squared_radius, dt, param);
+      }
+    }
+
+    // set new positions after all updates have been calculated
+    // otherwise some cells would see neighbors with already updated positions
+    // which would lead to inconsistencies
+    auto* controller = scheduler->GetTimeStepController();
+#pragma omp parallel for
+    for (uint64_t i = 0; i < num_objects; i++) {
+      if (!data_.run_displacement_[i]) {
+        continue;
+      }
+      Double3 displacement = {movements_[3 * i], movements_[3 * i + 1],
+                              movements_[3 * i + 2]};
+      if (param->adaptive_time_step_) {
+        controller->ObserveDisplacement(displacement * displacement);
+      }
+      auto* so = rm->GetSimObjectWithSoHandle(data_.handles_[i]);
+      so->ApplyDisplacement(displacement);
+      if (param->bound_space_) {
+        ApplyBoundingBox(so, param->min_bound_, param->max_bound_);
+      }
+    }
+  }
+
+  const DisplacementSoaData& GetData() const { return data_; }
+
+ private:
+  DisplacementSoaData data_;
+  std::vector<double> movements_;
+
+  /// Same calculation as `Cell::CalculateDisplacement`. The result is stored
+  /// in `movements_`.
+  void CalculateDisplacement(uint64_t idx, double squared_radius, double dt,
+                             const Param* param) {
+    const double* positions = data_.positions_.data();
+    const double* diameters = data_.diameters_.data();
+    const Double3 position = {positions[3 * idx], positions[3 * idx + 1],
+                              positions[3 * idx + 2]};
+
+    SphereForceAccumulator<> accumulator(position, diameters[idx]);
+    const uint64_t nx = data_.num_boxes_axis_[0];
+    const uint64_t nxy = nx * data_.num_boxes_axis_[1];
+    // sim objects are never placed in the outermost layer of boxes.
+    // Therefore, all boxes of the Moore neighborhood exist.
+    const uint64_t box = data_.box_id_[idx];
+    for (int64_t z = -1; z <= 1; z++) {
+      for (int64_t y = -1; y <= 1; y++) {
+        // boxes (x - 1, y, z) to (x + 1, y, z) are stored contiguously
+        const uint64_t first_box = box + z * nxy + y * nx - 1;
+        const uint64_t last_box = first_box + 2;
+        const uint64_t begin = data_.starts_[first_box];
+        const uint64_t end = data_.starts_[last_box] + data_.lengths_[last_box];
+        for (uint64_t j = begin; j < end; j++) {
+          double dx = positions[3 * j] - position[0];
+          double dy = positions[3 * j + 1] - position[1];
+          double dz = positions[3 * j + 2] - position[2];
+          if (j != idx && dx * dx + dy * dy + dz * dz < squared_radius) {
+            accumulator.Add({positions[3 * j], positions[3 * j + 1],
+                             positions[3 * j + 2]},
+                            diameters[j]);
+          }
+        }
+      }
+    }
+    const auto& force = accumulator.GetForce();
+
+    Double3 movement = {data_.tractor_force_[3 * idx] * dt,
+                        data_.tractor_force_[3 * idx + 1] * dt,
+                        data_.tractor_force_[3 * idx + 2] * dt};
+    double norm_of_force = std::sqrt(force * force);
+    if (norm_of_force > data_.adherence_[idx]) {
+      double mh = dt / data_.mass_[idx];
+      movement += force * mh;
+      if (norm_of_force * mh > param->simulation_max_displacement_) {
+        movement.Normalize();
+        movement *= param->simulation_max_displacement_;
+      }
+    }
+    for (uint64_t d = 0; d < 3; d++) {
+      movements_[3 * idx + d] = movement[d];
+    }
+  }
+};
+
+}  // namespace bdm
+
+#endif  // CORE_OPERATION_DISPLACEMENT_OP_SOA_H_
@@ -0,0 +1,204 @@
+// -----------------------------------------------------------------------------
+//
+// Copyright (C) The BioDynaMo Project.
+// All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+//
+// See the LICENSE file distributed with this work for details.
+// See the NOTICE file distributed with this work for additional information
+// regarding copyright ownership.
+//
+// -----------------------------------------------------------------------------
+
+#ifndef CORE_OPERATION_DISPLACEMENT_SOA_DATA_H_
+#define CORE_OPERATION_DISPLACEMENT_SOA_DATA_H_
+
+#include <array>
+#include <cassert>
+#include <cstdint>
+#include <vector>
+
+#include "core/grid.h"
+#include "core/resource_manager.h"
+#include "core/sim_object/cell.h"
+#include "core/sim_object/so_handle.h"
+#include "core/simulation.h"
+#include "core/util/log.h"
+#include "core/util/type.h"
+
+namespace bdm {
+
+/// Flattens the data required to calculate the mechanical interactions
+/// between spheres into contiguous arrays (structure of arrays).\n
+/// The layout is the one expected by the GPU kernels and is shared by
+/// `DisplacementOpCuda`, `DisplacementOpOpenCL` and `DisplacementOpSoa`.
+/// Sim objects are stored in the order of their grid box. Therefore, the
+/// members of box `b` occupy the index range
+/// `[starts_[b], starts_[b] + lengths_[b])` and boxes that are adjacent
+/// along the x-axis form one contiguous range. `successors_` is kept for the
+/// linked-list traversal of the GPU kernels and simply points to the next
+/// index.\n
+/// The box assignment (`handles_`, `box_id_`, `starts_`, `lengths_`,
+/// `successors_`) is only marshaled again if the grid geometry or the layout
+/// of the ResourceManager has changed, or a sim object has moved to another
+/// box since the last call to `Update`. The attributes of the sim objects
+/// (e.g. `positions_`) are copied in every call. Buffers keep their capacity
+/// between calls.
+class DisplacementSoaData {
+ public:
+  /// Number of sim objects in the flat arrays
+  uint32_t num_objects_ = 0;
+  /// Positions of the sim objects: x, y and z of object `i` are stored at
+  /// `3 * i`, `3 * i + 1` and `3 * i + 2`
+  std::vector<double> positions_;
+  std::vector<double> diameters_;
+  std::vector<double> adherence_;
+  /// Tractor forces (same layout as `positions_`)
+  std::vector<double> tractor_force_;
+  std::vector<double> mass_;
+  /// Copy of `SimObject::RunDisplacement()`
+  std::vector<uint8_t> run_displacement_;
+  /// Grid box of each sim object
+  std::vector<uint32_t> box_id_;
+  /// SoHandle of the sim object stored at each index
+  std::vector<SoHandle> handles_;
+  /// Index of the next sim object in the same box
+  std::vector<uint32_t> successors_;
+  /// Index of the first sim object in each box
+  std::vector<uint32_t> starts_;
+  /// Number of sim objects in each box
+  std::vector<uint16_t> lengths_;
+  uint32_t box_length_ = 0;
+  std::array<uint32_t, 3> num_boxes_axis_ = {{0}};
+  std::array<int32_t, 3> grid_dimensions_ = {{0}};
+  /// Number of sim objects whose box assignment has been marshaled during
+  /// the last call to `Update`
+  uint32_t num_marshaled_boxes_ = 0;
+
+  /// Marshals the data of all sim objects of the active simulation.
+  /// All sim objects must derive from `Cell` (see `SimObject::IsCell`).
+  /// Returns true if the box assignment has been marshaled again.
+  bool Update() {
+    auto* sim = Simulation::GetActive();
+    auto* grid = sim->GetGrid();
+    auto* rm = sim->GetResourceManager();
+
+    bool update_boxes = !BoxesUpToDate(grid, rm);
+    num_marshaled_boxes_ = 0;
+    if (update_boxes) {
+      UpdateBoxes(grid, rm);
+      num_marshaled_boxes_ = num_objects_;
+    }
+
+    positions_.resize(3 * num_objects_);
+    diameters_.resize(num_objects_);
+    adherence_.resize(num_objects_);
+    tractor_force_.resize(3 * num_objects_);
+    mass_.resize(num_objects_);
+    run_displacement_.resize(num_objects_);
+
+    bool non_cell_object = false;
+#pragma omp parallel for reduction(|| : non_cell_object)
+    for (uint64_t i = 0; i < num_objects_; i++) {
+      auto* so = rm->GetSimObjectWithSoHandle(handles_[i]);
+      if (!so->IsCell()) {
+        non_cell_object = true;
+        continue;
+      }
+      auto* cell = bdm_static_cast<Cell*>(so);
+      const auto& position = cell->GetPosition();
+      const auto& tractor_force = cell->GetTractorForce();
+      for (uint64_t d = 0; d < 3; d++) {
+        positions_[3 * i + d] = position[d];
+        tractor_force_[3 * i + d] = tractor_force[d];
+      }
+      diameters_[i] = cell->GetDiameter();
+      adherence_[i] = cell->GetAdherence();
+      mass_[i] = cell->GetMass();
+      run_displacement_[i] = cell->RunDisplacement();
+    }
+    if (non_cell_object) {
+      Log::Fatal("DisplacementSoaData",
+                 "\nWe detected a sim object that does not derive from Cell. "
+                 "The flattened data layout only supports interactions "
+                 "between cells.");
+    }
+    return update_boxes;
+  }
+
+ private:
+  /// State at the last update of the box assignment
+  const Grid* grid_ = nullptr;
+  uint64_t layout_generation_ = 0;
+
+  /// Returns true if the box assignment of the last call to `UpdateBoxes` is
+  /// still valid. `Grid::UpdateGrid` rebuilds the boxes in every step.
+  /// Therefore, the box of each sim object is compared instead.
+  bool BoxesUpToDate(Grid* grid, ResourceManager* rm) const {
+    if (grid != grid_ ||
+        ResourceManager::GetLayoutGeneration() != layout_generation_ ||
+        rm->GetNumSimObjects() != num_objects_) {
+      return false;
+    }
+    uint32_t box_length;
+    std::array<uint32_t, 3> num_boxes_axis;
+    std::array<int32_t, 3> grid_dimensions;
+    grid->GetGridInfo(&box_length, &num_boxes_axis, &grid_dimensions);
+    if (box_length != box_length_ || num_boxes_axis != num_boxes_axis_ ||
+        grid_dimensions != grid_dimensions_) {
+      return false;
+    }
+    bool moved = false;
+#pragma omp parallel for reduction(|| : moved)
+    for (uint64_t i = 0; i < num_objects_; i++) {
+      auto* so = rm->GetSimObjectWithSoHandle(handles_[i]);
+      moved = moved || so->GetBoxIdx() != box_id_[i];
+    }
+    return !moved;
+  }
+
+  void UpdateBoxes(Grid* grid, ResourceManager* rm) {
+    grid_ = grid;
+    layout_generation_ = ResourceManager::GetLayoutGeneration();
+    num_objects_ = rm->GetNumSimObjects();
+    grid->GetGridInfo(&box_length_, &num_boxes_axis_, &grid_dimensions_);
+
+    // boxes that have not been filled during the last grid update are empty
+    const uint64_t num_boxes = grid->boxes_.size();
+    lengths_.resize(num_boxes);
+    starts_.resize(num_boxes);
+#pragma omp parallel for
+    for (uint64_t b = 0; b < num_boxes; b++) {
+      auto& box = grid->boxes_[b];
+      lengths_[b] = box.IsEmpty(grid->timestamp_) ? 0 : box.length_;
+    }
+    uint32_t sum = 0;
+    for (uint64_t b = 0; b < num_boxes; b++) {
+      starts_[b] = sum;
+      sum += lengths_[b];
+    }
+    assert(sum == num_objects_ &&
+           "The grid does not contain all sim objects of the resource "
+           "manager.");
+
+    handles_.resize(num_objects_);
+    box_id_.resize(num_objects_);
+    successors_.resize(num_objects_);
+#pragma omp parallel for schedule(dynamic, 1024)
+    for (uint64_t b = 0; b < num_boxes; b++) {
+      auto current = grid->boxes_[b].start_;
+      for (uint32_t i = starts_[b]; i < starts_[b] + lengths_[b]; i++) {
+        handles_[i] = current;
+        box_id_[i] = b;
+        successors_[i] = i + 1;
+        current = grid->successors_[current];
+      }
+    }
+  }
+};
+
+}  // namespace bdm
+
+#endif  // CORE_OPERATION_DISPLACEMENT_SOA_DATA_H_
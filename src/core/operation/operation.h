@@ -36,6 +36,12 @@ struct Operation {
 
   void operator()(SimObject* so) const;
 
+  /// Returns true if this operation executes a functor of type `T`
+  template <typename T>
+  bool ExecutesFunctor() const {
+    return function_.template target<T>() != nullptr;
+  }
+
   /// Specifies how often this operation will be executed.\n
   /// 1: every timestep\n
   /// 2: every second timestep\n
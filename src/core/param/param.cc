@@ -57,9 +57,17 @@ void Param::AssignFromConfig(const std::shared_ptr<cpptoml::table>& config) {
   BDM_ASSIGN_CONFIG_VALUE(backup_file_, "simulation.backup_file");
   BDM_ASSIGN_CONFIG_VALUE(restore_file_, "simulation.restore_file");
   BDM_ASSIGN_CONFIG_VALUE(backup_interval_, "simulation.backup_interval");
+  BDM_ASSIGN_CONFIG_VALUE(backup_async_, "simulation.backup_async");
   BDM_ASSIGN_CONFIG_VALUE(simulation_time_step_, "simulation.time_step");
   BDM_ASSIGN_CONFIG_VALUE(simulation_max_displacement_,
                           "simulation.max_displacement");
+  BDM_ASSIGN_CONFIG_VALUE(adaptive_time_step_, "simulation.adaptive_time_step");
+  BDM_ASSIGN_CONFIG_VALUE(simulation_min_time_step_,
+                          "simulation.min_time_step");
+  BDM_ASSIGN_CONFIG_VALUE(simulation_max_time_step_,
+                          "simulation.max_time_step");
+  BDM_ASSIGN_CONFIG_VALUE(biology_module_frequency_,
+                          "simulation.biology_module_frequency");
   BDM_ASSIGN_CONFIG_VALUE(run_mechanical_interactions_,
                           "simulation.run_mechanical_interactions");
   BDM_ASSIGN_CONFIG_VALUE(bound_space_, "simulation.bound_space");
@@ -68,6 +76,51 @@ void Param::AssignFromConfig(const std::shared_ptr<cpptoml::table>& config) {
   BDM_ASSIGN_CONFIG_VALUE(leaking_edges_, "simulation.leaking_edges");
   BDM_ASSIGN_CONFIG_VALUE(calculate_gradients_,
                           "simulation.calculate_gradients");
+  BDM_ASSIGN_CONFIG_VALUE(lazy_gradients_, "simulation.lazy_gradients");
+  BDM_ASSIGN_CONFIG_VALUE(normalize_gradients_,
+                          "simulation.normalize_gradients");
+  BDM_ASSIGN_CONFIG_VALUE(diffusion_sub_cycling_,
+                          "simulation.diffusion_sub_cycling");
+  BDM_ASSIGN_CONFIG_VALUE(diffusion_temporal_block_size_,
+                          "simulation.diffusion_temporal_block_size");
+  BDM_ASSIGN_CONFIG_VALUE(fuse_diffusion_grids_,
+                          "simulation.fuse_diffusion_grids");
+  BDM_ASSIGN_CONFIG_VALUE(diffusion_sparsity_threshold_,
+                          "simulation.diffusion_sparsity_threshold");
+  BDM_ASSIGN_CONFIG_VALUE(diffusion_single_precision_,
+                          "simulation.diffusion_single_precision");
+  BDM_ASSIGN_CONFIG_VALUE(diffusion_grid_growth_factor_,
+                          "simulation.diffusion_grid_growth_factor");
+  //   diffusion_method_
+  if (config->contains_qualified("simulation.diffusion_method")) {
+    auto method =
+        config->get_qualified_as<std::string>("simulation.diffusion_method");
+    if (method) {
+      if (*method == "euler") {
+        diffusion_method_ = DiffusionMethod::kExplicitEuler;
+      } else if (*method == "adi") {
+        diffusion_method_ = DiffusionMethod::kADI;
+      } else {
+        Log::Fatal("Param::AssignFromConfig",
+                   "Unknown value for simulation.diffusion_method: ", *method);
+      }
+    }
+  }
+  //   secretion_mode_
+  if (config->contains_qualified("simulation.secretion_mode")) {
+    auto mode =
+        config->get_qualified_as<std::string>("simulation.secretion_mode");
+    if (mode) {
+      if (*mode == "atomic") {
+        secretion_mode_ = SecretionMode::kAtomic;
+      } else if (*mode == "buffered") {
+        secretion_mode_ = SecretionMode::kBuffered;
+      } else {
+        Log::Fatal("Param::AssignFromConfig",
+                   "Unknown value for simulation.secretion_mode: ", *mode);
+      }
+    }
+  }
   // visualization group
   BDM_ASSIGN_CONFIG_VALUE(visualization_engine_, "visualization.adaptor");
   BDM_ASSIGN_CONFIG_VALUE(live_visualization_, "visualization.live");
@@ -77,6 +130,8 @@ void Param::AssignFromConfig(const std::shared_ptr<cpptoml::table>& config) {
                           "visualization.export_interval");
   BDM_ASSIGN_CONFIG_VALUE(visualization_export_generate_pvsm_,
                           "visualization.export_generate_pvsm");
+  BDM_ASSIGN_CONFIG_VALUE(visualization_export_async_,
+                          "visualization.export_async");
 
   //   visualize_sim_objects_
   auto visualize_sim_objects_tarr =
@@ -148,6 +203,26 @@ void Param::AssignFromConfig(const std::shared_ptr<cpptoml::table>& config) {
   // performance group
   BDM_ASSIGN_CONFIG_VALUE(scheduling_batch_size_,
                           "performance.scheduling_batch_size");
+  BDM_ASSIGN_CONFIG_VALUE(autotune_scheduling_batch_size_,
+                          "performance.autotune_scheduling_batch_size");
+  //   scheduling_cost_model_
+  if (config->contains_qualified("performance.scheduling_cost_model")) {
+    auto model = config->get_qualified_as<std::string>(
+        "performance.scheduling_cost_model");
+    if (model) {
+      if (*model == "uniform") {
+        scheduling_cost_model_ = SchedulingCostModel::kUniform;
+      } else if (*model == "neighbors") {
+        scheduling_cost_model_ = SchedulingCostModel::kNeighbors;
+      } else if (*model == "measured") {
+        scheduling_cost_model_ = SchedulingCostModel::kMeasured;
+      } else {
+        Log::Fatal("Param::AssignFromConfig",
+                   "Unknown value for performance.scheduling_cost_model: ",
+                   *model);
+      }
+    }
+  }
   BDM_ASSIGN_CONFIG_VALUE(detect_static_sim_objects_,
                           "performance.detect_static_sim_objects");
   BDM_ASSIGN_CONFIG_VALUE(cache_neighbors_, "performance.cache_neighbors");
@@ -166,6 +241,7 @@ void Param::AssignFromConfig(const std::shared_ptr<cpptoml::table>& config) {
   BDM_ASSIGN_CONFIG_VALUE(use_gpu_, "experimental.use_gpu");
   BDM_ASSIGN_CONFIG_VALUE(use_opencl_, "experimental.use_opencl");
   BDM_ASSIGN_CONFIG_VALUE(opencl_debug_, "experimental.opencl_debug");
+  BDM_ASSIGN_CONFIG_VALUE(use_soa_mechanics_, "experimental.use_soa_mechanics");
   BDM_ASSIGN_CONFIG_VALUE(preferred_gpu_, "experimental.preferred_gpu");
 }
 
@@ -98,6 +98,18 @@ struct Param {
   ///     backup_interval = 1800  # backup every half an hour
   uint32_t backup_interval_ = 1800;
 
+  /// Write backups asynchronously. The simulation state is snapshotted by
+  /// forking the process (copy-on-write) and the child process writes the
+  /// backup file while the simulation continues. If the previous backup is
+  /// still being written when the next one is due, the new backup is delayed
+  /// until the previous one has finished.\n
+  /// Default Value: `false`\n
+  /// TOML config file:
+  ///
+  ///     [simulation]
+  ///     backup_async = false
+  bool backup_async_ = false;
+
   /// Time between two simulation steps, in hours.
   /// Default value: `0.01`\n
   /// TOML config file:
@@ -115,6 +127,49 @@ struct Param {
   ///     max_displacement = 3.0
   double simulation_max_displacement_ = 3.0;
 
+  /// Adapt the time step of each simulation step to the mechanical
+  /// interactions. After each step, the time step is increased or decreased
+  /// such that the largest displacement of the next step is approximately
+  /// half of `simulation_max_displacement_` (see `TimeStepController`).
+  /// Steps in which the displacement operation is not executed keep the
+  /// time step. `simulation_time_step_` is used for the first step. Biology
+  /// modules and diffusion use the adapted time step as well. Use
+  /// `Scheduler::SimulateUntil` to simulate a given time span.\n
+  /// Only supported by the CPU implementation of the displacement operation.\n
+  /// Default value: `false`\n
+  /// TOML config file:
+  ///
+  ///     [simulation]
+  ///     adaptive_time_step = false
+  bool adaptive_time_step_ = false;
+
+  /// Lower bound of the adaptive time step (see `adaptive_time_step_`).\n
+  /// Default value: `0.0001`\n
+  /// TOML config file:
+  ///
+  ///     [simulation]
+  ///     min_time_step = 0.0001
+  double simulation_min_time_step_ = 0.0001;
+
+  /// Upper bound of the adaptive time step (see `adaptive_time_step_`).\n
+  /// Default value: `1.0`\n
+  /// TOML config file:
+  ///
+  ///     [simulation]
+  ///     max_time_step = 1.0
+  double simulation_max_time_step_ = 1.0;
+
+  /// Number of simulation steps between two executions of the biology
+  /// modules. Biology modules integrate with the correspondingly coarser time
+  /// step `simulation_time_step_ * biology_module_frequency_`
+  /// (see `Scheduler::GetBiologyModuleTimeStep`).\n
+  /// Default value: `1` (biology modules are executed every time step)\n
+  /// TOML config file:
+  ///
+  ///     [simulation]
+  ///     biology_module_frequency = 1
+  uint32_t biology_module_frequency_ = 1;
+
   /// Calculate mechanical interactions between simulation objects.\n
   /// Default value: `true`\n
   /// TOML config file:
@@ -167,6 +222,143 @@ struct Param {
   ///     calculate_gradients = true
   bool calculate_gradients_ = true;
 
+  /// Calculate the gradient of a box only when it is queried with
+  /// `DiffusionGrid::GetGradient` instead of calculating the gradients of
+  /// all boxes in every step. Gradients are cached until the concentrations
+  /// are updated. Speeds up simulations in which only a small fraction of
+  /// the boxes is queried. Deposits into substances with lazy gradients are
+  /// always buffered (see `secretion_mode_`), such that the gradients do not
+  /// depend on the order of queries and deposits. Can be changed for
+  /// individual substances with `DiffusionGrid::SetLazyGradients`.\n
+  /// Default value: `false`\n
+  /// TOML config file:
+  ///
+  ///     [simulation]
+  ///     lazy_gradients = false
+  bool lazy_gradients_ = false;
+
+  /// Normalize the gradients when they are calculated instead of every time
+  /// they are queried with `DiffusionGrid::GetGradient`. The gradients of
+  /// the diffusion grids (and their visualization) are normalized in this
+  /// case. Can be changed for individual substances with
+  /// `DiffusionGrid::SetNormalizeGradients`.\n
+  /// Default value: `false`\n
+  /// TOML config file:
+  ///
+  ///     [simulation]
+  ///     normalize_gradients = false
+  bool normalize_gradients_ = false;
+
+  /// Sub-cycle the diffusion solver. If enabled, each diffusion grid is
+  /// advanced by `simulation_time_step_` every simulation step, using the
+  /// smallest number of equally long sub steps for which the explicit scheme
+  /// of the substance is stable (see `DiffusionGrid::AdaptTimeStep`).
+  /// If disabled, each diffusion grid performs exactly one update with time
+  /// step 1 per simulation step.\n
+  /// Default value: `false`\n
+  /// TOML config file:
+  ///
+  ///     [simulation]
+  ///     diffusion_sub_cycling = false
+  bool diffusion_sub_cycling_ = false;
+
+  /// Number of sub steps of a sub-cycled diffusion grid that are calculated
+  /// in one sweep over the grid (temporal blocking, see
+  /// `DiffusionGrid::EulerSweep`). Reduces the memory traffic of large
+  /// diffusion grids. A value of one disables temporal blocking.\n
+  /// Default value: `1`\n
+  /// TOML config file:
+  ///
+  ///     [simulation]
+  ///     diffusion_temporal_block_size = 1
+  uint64_t diffusion_temporal_block_size_ = 1;
+
+  /// Update all diffusion grids with the same number of boxes in a single
+  /// pass (see `DiffusionGrid::DiffuseEulerFused`) instead of one pass per
+  /// grid. Applies to explicit Euler grids that require a single update per
+  /// simulation step. Reduces memory traffic and the number of parallel
+  /// regions for simulations with many substances.\n
+  /// Default value: `false`\n
+  /// TOML config file:
+  ///
+  ///     [simulation]
+  ///     fuse_diffusion_grids = false
+  bool fuse_diffusion_grids_ = false;
+
+  /// Default sparsity threshold of the diffusion grids. If larger than zero,
+  /// explicit Euler grids only update the blocks of boxes that contain
+  /// concentrations above this threshold or have received substance since
+  /// the last update, as well as their neighbors. Concentrations at most as
+  /// large as the threshold are discarded if they are not next to such a
+  /// block. Speeds up substances that are confined to a small region of the
+  /// simulation space. Can be changed for individual substances with
+  /// `DiffusionGrid::SetSparsityThreshold`.\n
+  /// Default value: `0` (all boxes are updated)\n
+  /// TOML config file:
+  ///
+  ///     [simulation]
+  ///     diffusion_sparsity_threshold = 0
+  double diffusion_sparsity_threshold_ = 0;
+
+  /// Default precision in which the diffusion grids store concentrations and
+  /// gradients. If true, values are stored as `float`, which halves the
+  /// memory footprint and bandwidth of the diffusion grids. All calculations
+  /// are still carried out in double precision. Visualization exports
+  /// single precision grids as `float` arrays. Can be changed for individual
+  /// substances with `DiffusionGrid::SetSinglePrecision`.\n
+  /// Default value: `false`\n
+  /// TOML config file:
+  ///
+  ///     [simulation]
+  ///     diffusion_single_precision = false
+  bool diffusion_single_precision_ = false;
+
+  /// Minimum factor by which the number of boxes along each axis of a
+  /// diffusion grid increases if the grid has to grow, because the
+  /// simulation objects occupy a larger space. Values larger than one pad
+  /// the grid, such that subsequent growth does not require to reallocate
+  /// and copy the grid. Can be changed for individual substances with
+  /// `DiffusionGrid::SetGrowthFactor`.\n
+  /// Default value: `1` (grow to the minimum size)\n
+  /// TOML config file:
+  ///
+  ///     [simulation]
+  ///     diffusion_grid_growth_factor = 1
+  double diffusion_grid_growth_factor_ = 1;
+
+  /// Default numerical scheme of the diffusion grids. Can be changed for
+  /// individual substances with `DiffusionGrid::SetDiffusionMethod`.\n
+  /// `euler`: explicit Euler scheme. Only stable for small time steps (see
+  /// `diffusion_sub_cycling_`).\n
+  /// `adi`: alternating direction implicit scheme (locally one-dimensional
+  /// implicit Euler). Unconditionally stable. Each diffusion grid is advanced
+  /// by `simulation_time_step_` in a single step per simulation step.\n
+  /// Default value: `euler`\n
+  /// TOML config file:
+  ///
+  ///     [simulation]
+  ///     diffusion_method = "euler"
+  enum DiffusionMethod { kExplicitEuler, kADI };
+  DiffusionMethod diffusion_method_ = DiffusionMethod::kExplicitEuler;
+
+  /// Defines how concurrent calls to `DiffusionGrid::IncreaseConcentrationBy`
+  /// (e.g. secretion from biology modules) are synchronized.\n
+  /// `atomic`: each deposit is added to the concentration with an atomic
+  /// compare-and-swap operation and is visible immediately.\n
+  /// `buffered`: deposits are collected in per-thread buffers and added to
+  /// the concentration in parallel before the next diffusion step. Avoids
+  /// contention if many threads secrete into the same boxes, but deposits
+  /// are not visible before the diffusion operation has been executed.
+  /// Substances with lazy gradients always use `buffered` (see
+  /// `lazy_gradients_`).\n
+  /// Default value: `atomic`\n
+  /// TOML config file:
+  ///
+  ///     [simulation]
+  ///     secretion_mode = "atomic"
+  enum SecretionMode { kAtomic, kBuffered };
+  SecretionMode secretion_mode_ = SecretionMode::kAtomic;
+
   // visualization values ------------------------------------------------------
 
   /// Name of the visualization engine to use for visualizaing BioDynaMo
@@ -221,6 +413,19 @@ struct Param {
   ///     export_generate_pvsm = true
   bool visualization_export_generate_pvsm_ = true;
 
+  /// If `export_visualization_` is set to true and `live_visualization_` is
+  /// set to false, this parameter specifies if the export is pipelined with
+  /// the simulation. The visualized data members are copied into a staging
+  /// buffer in parallel. Afterwards, the VTK data structures are built and
+  /// written to file on a separate thread while the simulation continues
+  /// with the next time step.\n
+  /// Default value: `false`\n
+  /// TOML config file:
+  ///
+  ///     [visualization]
+  ///     export_async = false
+  bool visualization_export_async_ = false;
+
   /// Specifies which simulation objects should be visualized. \n
   /// Every simulation object defines the minimum set of data members which
   /// are required to visualize it. (e.g. Cell: `position_` and `diameter_`).\n
@@ -285,10 +490,47 @@ struct Param {
   ///     scheduling_batch_size = 1000
   uint64_t scheduling_batch_size_ = 1000;
 
+  /// Adapt the batch size of the scheduler at runtime. If enabled,
+  /// `scheduling_batch_size_` is only used as initial value. The batch size is
+  /// tuned separately for each set of operations that is executed in one pass
+  /// over all simulation objects and for each NUMA node (see
+  /// `BatchSizeTuner`). The chosen values are part of the statistics output
+  /// (see `statistics_`).\n
+  /// Default value: `false`\n
+  /// TOML config file:
+  ///
+  ///     [performance]
+  ///     autotune_scheduling_batch_size = false
+  bool autotune_scheduling_batch_size_ = false;
+
+  /// Cost model that is used to balance the work of one pass over all
+  /// simulation objects between threads.
+  /// {"uniform", "neighbors", "measured"}\n
+  /// `uniform`: all batches contain the same number of simulation objects.\n
+  /// `neighbors`: the cost of a simulation object is estimated by the number
+  /// of simulation objects in the surrounding boxes of the grid. Suitable for
+  /// simulations with large density differences.\n
+  /// `measured`: the cost of a simulation object is the average runtime of its
+  /// type measured during the previous execution of the same operations.\n
+  /// Batch boundaries are determined with a prefix sum over the estimated
+  /// costs such that all batches contain the same amount of work (see
+  /// `ResourceManager::ApplyOnAllElementsParallelCostWeighted`).\n
+  /// Default value: `"uniform"`\n
+  /// TOML config file:
+  ///
+  ///     [performance]
+  ///     scheduling_cost_model = "uniform"
+  enum SchedulingCostModel { kUniform, kNeighbors, kMeasured };
+  SchedulingCostModel scheduling_cost_model_ = SchedulingCostModel::kUniform;
+
   /// Calculation of the displacement (mechanical interaction) is an
   /// expensive operation. If simulation objects do not move or grow,
   /// displacement calculation is ommited if detect_static_sim_objects is turned
-  /// on. However, the detection mechanism introduces an overhead. For dynamic
+  /// on. In this case, the scheduler keeps a list of active sim objects
+  /// across simulation steps and executes the displacement operation only
+  /// for them (see `SimObject::RunDisplacement`). A sim object becomes active
+  /// if it or a neighbor in contact moved, grew or divided.
+  /// However, the detection mechanism introduces an overhead. For dynamic
   /// simulations where sim objects move and grow, the overhead outweighs the
   /// benefits.\n
   /// Default value: `false`\n
@@ -300,7 +542,14 @@ struct Param {
 
   /// Neighbors of a simulation object can be cached so to avoid consecutive
   /// searches. This of course only makes sense if there is more than one
-  /// `ForEachNeighbor*` operation.\n
+  /// `ForEachNeighbor*` call per simulation object and iteration.\n
+  /// The cache is built in parallel once per iteration after the grid has
+  /// been updated and is shared by all operations and biology modules.
+  /// It stores the neighbors together with their squared distance at the time
+  /// the cache was built (i.e. position changes during the iteration are not
+  /// reflected). Removing sim objects from the ResourceManager invalidates
+  /// the cache. For invalid caches and for sim objects that have been added
+  /// after the cache was built, neighbors are retrieved from the grid.\n
   /// Default value: `false`\n
   /// TOML config file:
   ///
@@ -376,6 +625,17 @@ struct Param {
   ///     opencl_debug_ = false
   bool opencl_debug_ = false;
 
+  /// Calculate the mechanical interactions on the CPU with a data-parallel
+  /// implementation that uses the same flattened data layout as the GPU
+  /// kernels (see `DisplacementOpSoa`). Only used if all simulation objects
+  /// derive from `Cell` and `use_gpu_` is disabled. Otherwise, the default CPU
+  /// implementation is used.\n
+  /// Default value: `false`\n
+  /// TOML config file:
+  ///     [experimental]
+  ///     use_soa_mechanics = false
+  bool use_soa_mechanics_ = false;
+
   /// Set the index of the preferred GPU you wish to use.
   /// Default value: `0`\n
   /// TOML config file:
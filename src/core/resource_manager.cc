@@ -13,10 +13,28 @@
 // -----------------------------------------------------------------------------
 
 #include "core/resource_manager.h"
+#include <chrono>
+#include <numeric>
 #include "core/grid.h"
 
 namespace bdm {
 
+namespace {
+
+/// Splits `size` sim objects into batches of `chunk` sim objects.
+/// Batch `i` contains the sim objects `[(*batches)[i], (*batches)[i + 1])`
+void GetUniformBatches(uint64_t size, uint64_t chunk,
+                       std::vector<uint64_t>* batches) {
+  batches->clear();
+  batches->reserve(size / chunk + 2);
+  for (uint64_t start = 0; start < size; start += chunk) {
+    batches->push_back(start);
+  }
+  batches->push_back(size);
+}
+
+}  // namespace
+
 void ResourceManager::ApplyOnAllElementsParallel(
     const std::function<void(SimObject*)>& function) {
 #pragma omp parallel
@@ -41,22 +59,147 @@ void ResourceManager::ApplyOnAllElementsParallel(
 
 void ResourceManager::ApplyOnAllElementsParallelDynamic(
     uint64_t chunk, const std::function<void(SimObject*, SoHandle)>& function) {
+  std::vector<uint64_t> numa_chunks(thread_info_->GetNumaNodes(), chunk);
+  ApplyOnAllElementsParallelDynamic(numa_chunks, function);
+}
+
+void ResourceManager::ApplyOnAllElementsParallelDynamic(
+    const std::vector<uint64_t>& numa_chunks,
+    const std::function<void(SimObject*, SoHandle)>& function,
+    std::vector<SchedulingStatistics>* statistics) {
+  auto numa_nodes = thread_info_->GetNumaNodes();
+  auto chunks = GetBatchSizes(numa_chunks);
+
+  std::vector<std::vector<uint64_t>> batches(numa_nodes);
+  for (int n = 0; n < numa_nodes; n++) {
+    GetUniformBatches(sim_objects_[n].size(), chunks[n], &batches[n]);
+  }
+
+  ApplyOnBatchesParallelDynamic(batches, function, statistics);
+}
+
+void ResourceManager::ApplyOnAllElementsParallelCostWeighted(
+    const std::vector<uint64_t>& numa_chunks,
+    const std::function<void(SimObject*, SoHandle)>& function,
+    const std::function<double(SimObject*)>& cost,
+    std::vector<SchedulingStatistics>* statistics) {
+  // Costs are accumulated for groups of consecutive sim objects
+  // (micro batches), which determine the granularity of the batch boundaries.
+  // This limits the memory footprint of the prefix sum.
+  constexpr uint64_t kMicroBatchesPerBatch = 8;
+
+  auto numa_nodes = thread_info_->GetNumaNodes();
+  auto chunks = GetBatchSizes(numa_chunks);
+
+  std::vector<uint64_t> micro_batch_sizes(numa_nodes);
+  std::vector<std::vector<double>> micro_batch_costs(numa_nodes);
+  for (int n = 0; n < numa_nodes; n++) {
+    micro_batch_sizes[n] =
+        std::max<uint64_t>(chunks[n] / kMicroBatchesPerBatch, 1);
+    auto size = sim_objects_[n].size();
+    auto correction = size % micro_batch_sizes[n] == 0 ? 0 : 1;
+    micro_batch_costs[n].resize(size / micro_batch_sizes[n] + correction);
+  }
+
+  // estimate the costs of each micro batch on the threads of the NUMA node
+  // that stores it
+#pragma omp parallel
+  {
+    auto tid = omp_get_thread_num();
+    auto nid = thread_info_->GetNumaNode(tid);
+    auto threads_in_numa = thread_info_->GetThreadsInNumaNode(nid);
+    auto& numa_sos = sim_objects_[nid];
+    auto& costs = micro_batch_costs[nid];
+    auto micro_batch_size = micro_batch_sizes[nid];
+
+    auto correction = costs.size() % threads_in_numa == 0 ? 0 : 1;
+    auto chunk = costs.size() / threads_in_numa + correction;
+    auto start = thread_info_->GetNumaThreadId(tid) * chunk;
+    auto end = std::min(costs.size(), start + chunk);
+
+    for (uint64_t m = start; m < end; m++) {
+      double micro_batch_cost = 0;
+      auto so_end = std::min(numa_sos.size(), (m + 1) * micro_batch_size);
+      for (uint64_t i = m * micro_batch_size; i < so_end; i++) {
+        micro_batch_cost += cost(numa_sos[i]);
+      }
+      costs[m] = micro_batch_cost;
+    }
+  }
+
+  // prefix sum over micro batches; place the batch boundaries where the
+  // accumulated cost reaches a multiple of the cost per batch
+  std::vector<std::vector<uint64_t>> batches(numa_nodes);
+  for (int n = 0; n < numa_nodes; n++) {
+    uint64_t size = sim_objects_[n].size();
+    auto& costs = micro_batch_costs[n];
+    auto& numa_batches = batches[n];
+    auto num_batches = size / chunks[n] + (size % chunks[n] == 0 ? 0 : 1);
+    double total_cost = std::accumulate(costs.begin(), costs.end(), 0.0);
+    if (total_cost <= 0) {
+      GetUniformBatches(size, chunks[n], &numa_batches);
+      continue;
+    }
+    double cost_per_batch = total_cost / num_batches;
+
+    numa_batches.reserve(num_batches + 1);
+    numa_batches.push_back(0);
+    double prefix = 0;
+    for (uint64_t m = 0; m < costs.size(); m++) {
+      prefix += costs[m];
+      auto boundary = std::min(size, (m + 1) * micro_batch_sizes[n]);
+      if (prefix >= cost_per_batch * numa_batches.size() &&
+          boundary != numa_batches.back() && boundary != size) {
+        numa_batches.push_back(boundary);
+      }
+    }
+    if (numa_batches.back() != size) {
+      numa_batches.push_back(size);
+    }
+  }
+
+  ApplyOnBatchesParallelDynamic(batches, function, statistics);
+}
+
+std::vector<uint64_t> ResourceManager::GetBatchSizes(
+    const std::vector<uint64_t>& numa_chunks) const {
   // adapt chunk size
-  auto num_so = GetNumSimObjects();
-  uint64_t factor = (num_so / thread_info_->GetMaxThreads()) / chunk;
-  chunk = (num_so / thread_info_->GetMaxThreads()) / (factor + 1);
-  chunk = chunk >= 1 ? chunk : 1;
+  auto numa_nodes = thread_info_->GetNumaNodes();
+  std::vector<uint64_t> chunks(numa_nodes);
+  for (int n = 0; n < numa_nodes; n++) {
+    chunks[n] = GetBatchSize(sim_objects_[n].size(),
+                             thread_info_->GetThreadsInNumaNode(n),
+                             numa_chunks[n]);
+  }
+  return chunks;
+}
+
+uint64_t ResourceManager::GetBatchSize(uint64_t num_sim_objects,
+                                       int threads_in_numa, uint64_t chunk) {
+  // NUMA nodes without threads (e.g. OMP_NUM_THREADS=1 on a multi-socket
+  // machine) are processed by threads of other nodes (work stealing)
+  uint64_t so_per_thread = num_sim_objects / std::max(threads_in_numa, 1);
+  chunk = std::max<uint64_t>(chunk, 1);
+  uint64_t factor = so_per_thread / chunk;
+  chunk = so_per_thread / (factor + 1);
+  return chunk >= 1 ? chunk : 1;
+}
+
+void ResourceManager::ApplyOnBatchesParallelDynamic(
+    const std::vector<std::vector<uint64_t>>& batches,
+    const std::function<void(SimObject*, SoHandle)>& function,
+    std::vector<SchedulingStatistics>* statistics) {
+  using Clock = std::chrono::high_resolution_clock;
+  auto numa_nodes = thread_info_->GetNumaNodes();
+  auto max_threads = omp_get_max_threads();
 
   // use dynamic scheduling
   // Unfortunately openmp's built in functionality can't be used, since
   // threads belong to different numa domains and thus operate on
   // different containers
-  auto numa_nodes = thread_info_->GetNumaNodes();
-  auto max_threads = omp_get_max_threads();
   std::vector<uint64_t> num_chunks_per_numa(numa_nodes);
   for (int n = 0; n < numa_nodes; n++) {
-    auto correction = sim_objects_[n].size() % chunk == 0 ? 0 : 1;
-    num_chunks_per_numa[n] = sim_objects_[n].size() / chunk + correction;
+    num_chunks_per_numa[n] = batches[n].size() - 1;
   }
 
   std::vector<std::atomic<uint64_t>*> counters(max_threads, nullptr);
@@ -83,6 +226,16 @@ void ResourceManager::ApplyOnAllElementsParallelDynamic(
     max_counters[thread_cnt] = end;
   }
 
+  // scheduling statistics (thread -> numa node)
+  const bool gather_statistics = statistics != nullptr;
+  std::vector<std::vector<int64_t>> finish_times;
+  std::vector<std::vector<uint64_t>> stolen_chunks;
+  if (gather_statistics) {
+    finish_times.resize(max_threads, std::vector<int64_t>(numa_nodes, 0));
+    stolen_chunks.resize(max_threads, std::vector<uint64_t>(numa_nodes, 0));
+  }
+  auto start_time = Clock::now();
+
 #pragma omp parallel
   {
     auto tid = omp_get_thread_num();
@@ -92,7 +245,6 @@ void ResourceManager::ApplyOnAllElementsParallelDynamic(
     // firstprivate(chunk, numa_node_) with some openmp versions clause)
     auto p_numa_nodes = thread_info_->GetNumaNodes();
     auto p_max_threads = omp_get_max_threads();
-    auto p_chunk = chunk;
     assert(thread_info_->GetNumaNode(tid) == numa_node_of_cpu(sched_getcpu()));
 
     // dynamic scheduling
@@ -104,6 +256,7 @@ void ResourceManager::ApplyOnAllElementsParallelDynamic(
     // is finished the thread looks for tasks on other domains
     for (int n = 0; n < p_numa_nodes; n++) {
       int current_nid = (nid + n) % p_numa_nodes;
+      auto& numa_batches = batches[current_nid];
       for (int thread_cnt = 0; thread_cnt < p_max_threads; thread_cnt++) {
         uint64_t current_tid = (tid + thread_cnt) % p_max_threads;
         if (current_nid != thread_info_->GetNumaNode(current_tid)) {
@@ -111,18 +264,29 @@ void ResourceManager::ApplyOnAllElementsParallelDynamic(
         }
 
         auto& numa_sos = sim_objects_[current_nid];
+        uint64_t processed = 0;
         uint64_t old_count = (*(counters[current_tid]))++;
         while (old_count < max_counters[current_tid]) {
-          start = old_count * p_chunk;
-          end =
-              std::min(static_cast<uint64_t>(numa_sos.size()), start + p_chunk);
+          start = numa_batches[old_count];
+          end = numa_batches[old_count + 1];
 
           for (uint64_t i = start; i < end; ++i) {
             function(numa_sos[i], SoHandle(current_nid, i));
           }
 
+          processed++;
           old_count = (*(counters[current_tid]))++;
         }
+
+        if (gather_statistics && processed != 0) {
+          if (current_tid != static_cast<uint64_t>(tid)) {
+            stolen_chunks[tid][current_nid] += processed;
+          }
+          finish_times[tid][current_nid] =
+              std::chrono::duration_cast<std::chrono::nanoseconds>(
+                  Clock::now() - start_time)
+                  .count();
+        }
       }  // work stealing loop numa_nodes_
     }    // work stealing loop  threads
   }
@@ -130,9 +294,25 @@ void ResourceManager::ApplyOnAllElementsParallelDynamic(
   for (auto* counter : counters) {
     delete counter;
   }
+
+  if (gather_statistics) {
+    statistics->assign(numa_nodes, SchedulingStatistics());
+    for (int n = 0; n < numa_nodes; n++) {
+      auto& stats = (*statistics)[n];
+      stats.num_sim_objects = sim_objects_[n].size();
+      stats.batches = num_chunks_per_numa[n];
+      for (int t = 0; t < max_threads; t++) {
+        stats.stolen_batches += stolen_chunks[t][n];
+        stats.runtime = std::max(stats.runtime, finish_times[t][n]);
+      }
+    }
+  }
 }
 
+std::atomic<uint64_t> ResourceManager::layout_generation_;
+
 void ResourceManager::SortAndBalanceNumaNodes() {
+  layout_generation_++;
   // balance simulation objects per numa node according to the number of
   // threads associated with each numa domain
   auto numa_nodes = thread_info_->GetNumaNodes();
@@ -19,6 +19,7 @@
 #include <sched.h>
 #include <tbb/concurrent_unordered_map.h>
 #include <algorithm>
+#include <atomic>
 #include <cmath>
 #include <limits>
 #include <memory>
@@ -43,71 +44,17 @@
 
 #include "core/diffusion_grid.h"
 #include "core/sim_object/sim_object.h"
+#include "core/sim_object/so_handle.h"
 #include "core/sim_object/so_uid.h"
 #include "core/simulation.h"
 #include "core/util/numa.h"
 #include "core/util/root.h"
+#include "core/util/scheduling_statistics.h"
 #include "core/util/thread_info.h"
 #include "core/util/type.h"
 
 namespace bdm {
 
-/// Unique identifier of a simulation object. Acts as a type erased pointer.
-/// Has the same type for every simulation object. \n
-/// Points to the storage location of a sim object inside ResourceManager.\n
-/// The id is split into two parts: Numa node, element index.
-/// The first one is used to obtain the numa storage, and the second specifies
-/// the element within this vector.
-class SoHandle {
- public:
-  using NumaNode_t = uint16_t;
-  using ElementIdx_t = uint32_t;
-
-  constexpr SoHandle() noexcept
-      : numa_node_(std::numeric_limits<NumaNode_t>::max()),
-        element_idx_(std::numeric_limits<ElementIdx_t>::max()) {}
-
-  explicit SoHandle(ElementIdx_t element_idx)
-      : numa_node_(0), element_idx_(element_idx) {}
-
-  SoHandle(NumaNode_t numa_node, ElementIdx_t element_idx)
-      : numa_node_(numa_node), element_idx_(element_idx) {}
-
-  NumaNode_t GetNumaNode() const { return numa_node_; }
-  ElementIdx_t GetElementIdx() const { return element_idx_; }
-  void SetElementIdx(ElementIdx_t element_idx) { element_idx_ = element_idx; }
-
-  bool operator==(const SoHandle& other) const {
-    return numa_node_ == other.numa_node_ && element_idx_ == other.element_idx_;
-  }
-
-  bool operator!=(const SoHandle& other) const { return !(*this == other); }
-
-  bool operator<(const SoHandle& other) const {
-    if (numa_node_ == other.numa_node_) {
-      return element_idx_ < other.element_idx_;
-    } else {
-      return numa_node_ < other.numa_node_;
-    }
-  }
-
-  friend std::ostream& operator<<(std::ostream& stream,
-                                  const SoHandle& handle) {
-    stream << "Numa node: " << handle.numa_node_
-           << " element idx: " << handle.element_idx_;
-    return stream;
-  }
-
- private:
-  NumaNode_t numa_node_;
-
-  /// changed element index to uint32_t after issues with std::atomic with
-  /// size 16 -> max element_idx: 4.294.967.296
-  ElementIdx_t element_idx_;
-
-  BDM_CLASS_DEF_NV(SoHandle, 1);
-};
-
 /// ResourceManager stores simulation objects and diffusion grids and provides
 /// methods to add, remove, and access them. Sim objects are uniquely identified
 /// by their SoUid, and SoHandle. A SoHandle might change during the simulation.
@@ -124,6 +71,7 @@ class ResourceManager {
                  "Call to numa_available failed with return code: ", ret);
     }
     sim_objects_.resize(numa_num_configured_nodes());
+    layout_generation_++;
   }
 
   virtual ~ResourceManager() {
@@ -158,6 +106,7 @@ class ResourceManager {
   }
 
   void RestoreUidSoMap() {
+    layout_generation_++;
     // rebuild uid_soh_map_
     uid_soh_map_.clear();
     for (unsigned n = 0; n < sim_objects_.size(); ++n) {
@@ -177,10 +126,36 @@ class ResourceManager {
     return sim_objects_[soh.GetNumaNode()][soh.GetElementIdx()];
   }
 
+  /// Same as `GetSimObject(uid)`, but additionally returns the SoHandle of
+  /// the sim object (if it exists).
+  SimObject* GetSimObject(SoUid uid, SoHandle* soh) {
+    auto search_it = uid_soh_map_.find(uid);
+    if (search_it == uid_soh_map_.end()) {
+      return nullptr;
+    }
+    *soh = search_it->second;
+    return sim_objects_[soh->GetNumaNode()][soh->GetElementIdx()];
+  }
+
   SimObject* GetSimObjectWithSoHandle(SoHandle soh) {
     return sim_objects_[soh.GetNumaNode()][soh.GetElementIdx()];
   }
 
+  /// Returns true if `soh` points to a storage location inside this
+  /// ResourceManager.
+  bool ContainsSoHandle(SoHandle soh) const {
+    return soh.GetNumaNode() < sim_objects_.size() &&
+           soh.GetElementIdx() < sim_objects_[soh.GetNumaNode()].size();
+  }
+
+  /// Returns the layout generation. It is incremented whenever a change
+  /// might invalidate the SoHandle of an existing sim object (removal,
+  /// NUMA balancing, restore, ...). SoHandles obtained while the generation
+  /// did not change are still valid. Adding sim objects does not change the
+  /// generation, because it does not move existing sim objects.\n
+  /// The generation is shared between all ResourceManager instances.
+  static uint64_t GetLayoutGeneration() { return layout_generation_; }
+
   SoHandle GetSoHandle(SoUid uid) { return uid_soh_map_[uid]; }
 
   void AddDiffusionGrid(DiffusionGrid* dgrid) {
@@ -296,6 +271,32 @@ class ResourceManager {
       uint64_t chunk,
       const std::function<void(SimObject*, SoHandle)>& function);
 
+  /// Apply a function on all elements.\n
+  /// Same as `ApplyOnAllElementsParallelDynamic(chunk, function)`, but with a
+  /// separate batch size for each NUMA node.
+  /// \param numa_chunks batch size for each NUMA node
+  /// \param statistics if not a nullptr, scheduling statistics for each NUMA
+  ///        node are stored in it (used for batch size autotuning; see
+  ///        `BatchSizeTuner`)
+  void ApplyOnAllElementsParallelDynamic(
+      const std::vector<uint64_t>& numa_chunks,
+      const std::function<void(SimObject*, SoHandle)>& function,
+      std::vector<SchedulingStatistics>* statistics = nullptr);
+
+  /// Apply a function on all elements.\n
+  /// Same as `ApplyOnAllElementsParallelDynamic(numa_chunks, function,
+  /// statistics)`, but each batch contains sim objects with approximately the
+  /// same total cost instead of the same number of sim objects. Batch
+  /// boundaries are determined with a prefix sum over the estimated costs of
+  /// the sim objects of each NUMA node. Therefore, each thread initially gets
+  /// the same amount of work even if the cost per sim object is not uniform.
+  /// \param cost estimated computational cost of a sim object
+  void ApplyOnAllElementsParallelCostWeighted(
+      const std::vector<uint64_t>& numa_chunks,
+      const std::function<void(SimObject*, SoHandle)>& function,
+      const std::function<double(SimObject*)>& cost,
+      std::vector<SchedulingStatistics>* statistics = nullptr);
+
   /// Reserves enough memory to hold `capacity` number of simulation objects for
   /// each numa domain.
   void Reserve(size_t capacity) {
@@ -327,6 +328,7 @@ class ResourceManager {
   /// sim_object references pointing into the ResourceManager. SoPointer are
   /// not affected.
   void Clear() {
+    layout_generation_++;
     uid_soh_map_.clear();
     for (auto& numa_sos : sim_objects_) {
       for (auto* so : numa_sos) {
@@ -358,13 +360,12 @@ class ResourceManager {
   /// not overlap!
   virtual void AddNewSimObjects(
       typename SoHandle::NumaNode_t numa_node, uint64_t offset,
-      const tbb::concurrent_unordered_map<SoUid, SimObject*>& new_sim_objects) {
-    uint64_t i = 0;
-    for (auto& pair : new_sim_objects) {
-      auto uid = pair.first;
+      const std::vector<SimObject*>& new_sim_objects) {
+    std::copy(new_sim_objects.begin(), new_sim_objects.end(),
+              sim_objects_[numa_node].begin() + offset);
+    for (uint64_t i = 0; i < new_sim_objects.size(); i++) {
+      auto uid = new_sim_objects[i]->GetUid();
       uid_soh_map_[uid] = SoHandle(numa_node, offset + i);
-      sim_objects_[numa_node][offset + i] = pair.second;
-      i++;
     }
   }
 
@@ -373,6 +374,7 @@ class ResourceManager {
   /// sim_object references pointing into the ResourceManager. SoPointer are
   /// not affected.
   void Remove(SoUid uid) {
+    layout_generation_++;
     // remove from map
     auto it = uid_soh_map_.find(uid);
     if (it != uid_soh_map_.end()) {
@@ -395,9 +397,30 @@ class ResourceManager {
   }
 
  protected:
+  /// Number of batches per NUMA node with uniform size `numa_chunks`, adapted
+  /// such that all threads of a NUMA node get the same number of batches
+  std::vector<uint64_t> GetBatchSizes(
+      const std::vector<uint64_t>& numa_chunks) const;
+
+  /// Batch size of one NUMA node with `threads_in_numa` threads and
+  /// `num_sim_objects` sim objects for the requested batch size `chunk`
+  static uint64_t GetBatchSize(uint64_t num_sim_objects, int threads_in_numa,
+                               uint64_t chunk);
+
+  /// Dynamic scheduling with work stealing of the given batches.
+  /// \param batches batch boundaries for each NUMA node. Batch `i` of NUMA
+  ///        node `n` contains the sim objects with index
+  ///        `[batches[n][i], batches[n][i + 1])`
+  /// \see ApplyOnAllElementsParallelDynamic
+  void ApplyOnBatchesParallelDynamic(
+      const std::vector<std::vector<uint64_t>>& batches,
+      const std::function<void(SimObject*, SoHandle)>& function,
+      std::vector<SchedulingStatistics>* statistics);
 
   /// Maps an SoUid to its storage location in `sim_objects_` \n
   tbb::concurrent_unordered_map<SoUid, SoHandle> uid_soh_map_;  //!
+  /// \see GetLayoutGeneration
+  static std::atomic<uint64_t> layout_generation_;  //!
   /// Pointer container for all simulation objects
   std::vector<std::vector<SimObject*>> sim_objects_;
   /// Maps a diffusion grid ID to the pointer to the diffusion grid
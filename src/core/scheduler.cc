@@ -12,8 +12,15 @@
 //
 // -----------------------------------------------------------------------------
 
+#include <algorithm>
 #include <chrono>
+#include <sstream>
 #include <string>
+#include <typeindex>
+#include <typeinfo>
+#include <unordered_map>
+#include <utility>
+#include <vector>
 
 #include "core/execution_context/in_place_exec_ctxt.h"
 #include "core/gpu/gpu_helper.h"
@@ -26,12 +33,37 @@
 #include "core/scheduler.h"
 #include "core/simulation.h"
 #include "core/simulation_backup.h"
+#include "core/util/batch_size_tuner.h"
+#include "core/util/cylinder_interaction_counter.h"
 #include "core/util/log.h"
+#include "core/util/time_step_controller.h"
 #include "core/visualization/root/adaptor.h"
 #include "core/visualization/visualization_adaptor.h"
 
 namespace bdm {
 
+namespace {
+
+/// Applies `function` in parallel on the sim objects with the given
+/// SoHandles.
+template <typename TFunction>
+void ApplyOnSimObjects(const std::vector<SoHandle>& handles,
+                       const TFunction& function) {
+  auto* sim = Simulation::GetActive();
+  auto* rm = sim->GetResourceManager();
+  const int64_t size = handles.size();
+  const int64_t chunk = std::max<int64_t>(
+      1, std::min<int64_t>(sim->GetParam()->scheduling_batch_size_,
+                           size / omp_get_max_threads()));
+#pragma omp parallel for schedule(dynamic, chunk)
+  for (int64_t i = 0; i < size; i++) {
+    auto soh = handles[i];
+    function(rm->GetSimObjectWithSoHandle(soh), soh);
+  }
+}
+
+}  // namespace
+
 Scheduler::Scheduler() {
   auto* param = Simulation::GetActive()->GetParam();
   backup_ = new SimulationBackup(param->backup_file_, param->restore_file_);
@@ -43,6 +75,10 @@ Scheduler::Scheduler() {
   bound_space_ = new BoundSpace();
   displacement_ = new DisplacementOp();
   diffusion_ = new DiffusionOp();
+  batch_size_tuner_ = new BatchSizeTuner(param->scheduling_batch_size_);
+  time_step_controller_ = new TimeStepController();
+  cylinder_interaction_counter_ = new CylinderInteractionCounter();
+  time_step_ = param->simulation_time_step_;
 
   // initialise operations_
   auto first_op =
@@ -72,8 +108,24 @@ Scheduler::~Scheduler() {
   delete diffusion_;
   auto* param = Simulation::GetActive()->GetParam();
   if (param->statistics_) {
+    if (param->autotune_scheduling_batch_size_) {
+      batch_size_tuner_->AddDescriptions(&gStatistics);
+    }
+    uint64_t rejected = 0;
+    uint64_t evaluated = 0;
+    cylinder_interaction_counter_->GetCounts(&rejected, &evaluated);
+    if (rejected + evaluated != 0) {
+      std::stringstream description;
+      description << "cylinder interactions: " << rejected
+                  << " rejected by bounding box test, " << evaluated
+                  << " evaluated";
+      gStatistics.AddDescription(description.str());
+    }
     std::cout << gStatistics << std::endl;
   }
+  delete batch_size_tuner_;
+  delete time_step_controller_;
+  delete cylinder_interaction_counter_;
 }
 
 void Scheduler::Simulate(uint64_t steps) {
@@ -83,15 +135,59 @@ void Scheduler::Simulate(uint64_t steps) {
 
   Initialize();
   for (unsigned step = 0; step < steps; step++) {
-    Execute();
+    SimulateStep();
+  }
+}
 
-    total_steps_++;
-    Backup();
+void Scheduler::SimulateUntil(double time) {
+  Initialize();
+  // tolerate rounding errors in the sum of the time steps
+  while (time - simulated_time_ > 1e-9 * time_step_) {
+    SimulateStep();
   }
 }
 
 uint64_t Scheduler::GetSimulatedSteps() const { return total_steps_; }
 
+double Scheduler::GetSimulatedTime() const { return simulated_time_; }
+
+double Scheduler::GetSimulationTimeStep() const { return time_step_; }
+
+double Scheduler::GetBiologyModuleTimeStep() const {
+  auto* param = Simulation::GetActive()->GetParam();
+  return time_step_ * param->biology_module_frequency_;
+}
+
+double Scheduler::GetOperationTimeStep(const std::string& op_name) const {
+  if (op_name == "biology modules") {
+    return GetBiologyModuleTimeStep();
+  }
+  for (auto& op : operations_) {
+    if (op_name == op.name_) {
+      return time_step_ * op.frequency_;
+    }
+  }
+  return time_step_;
+}
+
+void Scheduler::SimulateStep() {
+  auto* param = Simulation::GetActive()->GetParam();
+  if (param->adaptive_time_step_) {
+    time_step_controller_->StartStep();
+  }
+
+  Execute();
+
+  simulated_time_ += time_step_;
+  total_steps_++;
+  if (param->adaptive_time_step_) {
+    time_step_ = time_step_controller_->GetNextTimeStep(
+        time_step_, param->simulation_max_displacement_,
+        param->simulation_min_time_step_, param->simulation_max_time_step_);
+  }
+  Backup();
+}
+
 void Scheduler::AddOperation(const Operation& op) {
   auto it = operations_.end() - 2;
   operations_.insert(it, op);
@@ -147,26 +243,329 @@ void Scheduler::Execute() {
 
   // update all sim objects: run all CPU operations
   const auto& scheduled_ops = GetScheduleOps();
-  rm->ApplyOnAllElementsParallelDynamic(
-      param->scheduling_batch_size_, [&](SimObject* so, SoHandle) {
-        sim->GetExecutionContext()->Execute(so, scheduled_ops);
-      });
+  if (param->detect_static_sim_objects_) {
+    ExecuteOnActiveSimObjects(scheduled_ops);
+  } else {
+    // rebuild the active sim objects if the detection is enabled later on
+    active_generation_ = 0;
+    active_sim_objects_.clear();
+    ApplyOnAllElementsParallelDynamic(
+        scheduled_ops, [&](SimObject* so, SoHandle soh) {
+          sim->GetExecutionContext()->Execute(so, soh, scheduled_ops);
+        });
+  }
 
-  // update all sim objects: hardware accelerated operations
-  if (param->run_mechanical_interactions_ && !displacement_->UseCpu()) {
-    Timing::Time("displacement (GPU/FPGA)", *displacement_);
+  // update all sim objects: data-parallel and hardware accelerated operations
+  if (param->run_mechanical_interactions_ && !UseCpuDisplacement()) {
+    auto* op = GetOperation("displacement");
+    if (op == nullptr || total_steps_ % op->frequency_ == 0) {
+      Timing::Time("displacement (SoA/GPU/FPGA)", *displacement_);
+    }
   }
 
   // finish updating sim objects
+  std::vector<SoUid> new_active_uids;
+  if (param->detect_static_sim_objects_) {
+    new_active_uids = ResetActiveSimObjects();
+  }
   Timing::Time("Tear down exec context", [&]() {
     const auto& all_exec_ctxts = sim->GetAllExecCtxts();
     all_exec_ctxts[0]->TearDownIterationAll(all_exec_ctxts);
   });
+  if (param->detect_static_sim_objects_) {
+    UpdateActiveSimObjects(new_active_uids);
+  }
 
   // update all substances (DiffusionGrids)
   Timing::Time("diffusion", *diffusion_);
 }
 
+void Scheduler::ExecuteOnActiveSimObjects(
+    const std::vector<Operation>& scheduled_ops) {
+  auto* sim = Simulation::GetActive();
+  auto* rm = sim->GetResourceManager();
+  auto* grid = sim->GetGrid();
+
+  // Sim objects have been added or reordered since the last step without
+  // updating the active sim objects.
+  if (active_generation_ != ResourceManager::GetLayoutGeneration() ||
+      active_num_sim_objects_ != rm->GetNumSimObjects()) {
+    CollectActiveSimObjects();
+  }
+
+  // operation "first": only sim objects whose flag has been set in the last
+  // step are displaced in this step. The flag of all other sim objects has
+  // already been reset.
+  active_sim_objects_.swap(next_active_sim_objects_);
+  next_active_sim_objects_.clear();
+  next_active_uids_.clear();
+  ApplyOnSimObjects(active_sim_objects_, [](SimObject* so, SoHandle) {
+    so->UpdateRunDisplacement();
+  });
+
+  // Split the operations at the displacement. `mechanics` contains the
+  // displacement and all subsequent operations. The order of operations of
+  // each sim object is the same as in the default execution.
+  std::vector<Operation> before;
+  std::vector<Operation> mechanics;
+  for (auto& op : scheduled_ops) {
+    if (op.name_ == "first" || op.name_ == "last") {
+      continue;
+    }
+    if (op.name_ == "displacement" || !mechanics.empty()) {
+      mechanics.push_back(op);
+    } else {
+      before.push_back(op);
+    }
+  }
+  std::vector<Operation> others = before;
+  if (!mechanics.empty()) {
+    others.insert(others.end(), mechanics.begin() + 1, mechanics.end());
+  }
+
+  // Sim objects that moved, grew or divided in this step
+  std::vector<std::vector<SoHandle>> changed(omp_get_max_threads());
+
+  // One pass over all sim objects. Static sim objects execute all
+  // operations except the displacement. Active sim objects only execute the
+  // operations before the displacement.
+  ApplyOnAllElementsParallelDynamic(others, [&](SimObject* so, SoHandle soh) {
+    auto* ctxt = sim->GetExecutionContext();
+    if (!mechanics.empty() && so->RunDisplacement()) {
+      if (!before.empty()) {
+        ctxt->Execute(so, soh, before);
+      }
+      return;
+    }
+    ctxt->Execute(so, soh, others);
+    if (so->GetRunDisplacementForAllNextTs()) {
+      changed[omp_get_thread_num()].push_back(soh);
+    }
+  });
+
+  if (!mechanics.empty()) {
+    ApplyOnSimObjects(active_sim_objects_, [&](SimObject* so, SoHandle soh) {
+      sim->GetExecutionContext()->Execute(so, soh, mechanics);
+      if (so->GetRunDisplacementForAllNextTs()) {
+        changed[omp_get_thread_num()].push_back(soh);
+      }
+    });
+  }
+
+  // operation "last": set the flag for the next step of the changed sim
+  // objects and of their neighbors in contact. Each sim object is added
+  // once to the active sim objects of the next step.
+  std::vector<SoHandle> all_changed;
+  for (auto& thread_changed : changed) {
+    all_changed.insert(all_changed.end(), thread_changed.begin(),
+                       thread_changed.end());
+  }
+  std::vector<std::vector<std::pair<SoHandle, SoUid>>> next(
+      omp_get_max_threads());
+  ApplyOnSimObjects(all_changed, [&](SimObject* so, SoHandle soh) {
+    auto& thread_next = next[omp_get_thread_num()];
+    so->SetRunDisplacementForAllNextTs(false);
+    if (so->MarkRunDisplacementNextTimestep()) {
+      thread_next.emplace_back(soh, so->GetUid());
+    }
+    grid->ForEachNeighborWithHandle(
+        [&](const SimObject* neighbor, SoHandle neighbor_soh,
+            double squared_distance) {
+          double distance = so->GetDiameter() + neighbor->GetDiameter();
+          if (squared_distance < distance * distance &&
+              neighbor->MarkRunDisplacementNextTimestep()) {
+            thread_next.emplace_back(neighbor_soh, neighbor->GetUid());
+          }
+        },
+        *so);
+  });
+  for (auto& thread_next : next) {
+    for (auto& el : thread_next) {
+      next_active_sim_objects_.push_back(el.first);
+      next_active_uids_.push_back(el.second);
+    }
+  }
+  active_generation_ = ResourceManager::GetLayoutGeneration();
+}
+
+void Scheduler::CollectActiveSimObjects() {
+  auto* sim = Simulation::GetActive();
+  auto* rm = sim->GetResourceManager();
+  std::vector<std::vector<std::pair<SoHandle, SoUid>>> active(
+      omp_get_max_threads());
+  rm->ApplyOnAllElementsParallelDynamic(
+      sim->GetParam()->scheduling_batch_size_,
+      [&](SimObject* so, SoHandle soh) {
+        so->ResetRunDisplacement();
+        if (so->GetRunDisplacementNextTimestep()) {
+          active[omp_get_thread_num()].emplace_back(soh, so->GetUid());
+        }
+      });
+  next_active_sim_objects_.clear();
+  next_active_uids_.clear();
+  for (auto& thread_active : active) {
+    for (auto& el : thread_active) {
+      next_active_sim_objects_.push_back(el.first);
+      next_active_uids_.push_back(el.second);
+    }
+  }
+}
+
+std::vector<SoUid> Scheduler::ResetActiveSimObjects() {
+  ApplyOnSimObjects(active_sim_objects_, [](SimObject* so, SoHandle) {
+    so->ResetRunDisplacement();
+  });
+
+  std::vector<SoUid> new_active_uids;
+  for (auto* ctxt : Simulation::GetActive()->GetAllExecCtxts()) {
+    ctxt->ForEachNewSimObject([&](SimObject* so) {
+      if (so->GetRunDisplacementNextTimestep()) {
+        new_active_uids.push_back(so->GetUid());
+      } else {
+        so->ResetRunDisplacement();
+      }
+    });
+  }
+  return new_active_uids;
+}
+
+void Scheduler::UpdateActiveSimObjects(
+    const std::vector<SoUid>& new_active_uids) {
+  auto* rm = Simulation::GetActive()->GetResourceManager();
+
+  // Sim objects have been removed. Update the SoHandles and drop the removed
+  // sim objects.
+  if (active_generation_ != ResourceManager::GetLayoutGeneration()) {
+    uint64_t num_active = 0;
+    for (auto uid : next_active_uids_) {
+      SoHandle soh;
+      if (rm->GetSimObject(uid, &soh) != nullptr) {
+        next_active_sim_objects_[num_active] = soh;
+        next_active_uids_[num_active] = uid;
+        num_active++;
+      }
+    }
+    next_active_sim_objects_.resize(num_active);
+    next_active_uids_.resize(num_active);
+  }
+
+  for (auto uid : new_active_uids) {
+    SoHandle soh;
+    if (rm->GetSimObject(uid, &soh) != nullptr) {
+      next_active_sim_objects_.push_back(soh);
+      next_active_uids_.push_back(uid);
+    }
+  }
+
+  active_generation_ = ResourceManager::GetLayoutGeneration();
+  active_num_sim_objects_ = rm->GetNumSimObjects();
+}
+
+void Scheduler::ApplyOnAllElementsParallelDynamic(
+    const std::vector<Operation>& ops,
+    const std::function<void(SimObject*, SoHandle)>& function) {
+  auto* sim = Simulation::GetActive();
+  auto* rm = sim->GetResourceManager();
+  auto* param = sim->GetParam();
+
+  // batch sizes and measured costs are stored for each combination of
+  // operations
+  std::string key;
+  for (auto& op : ops) {
+    key += key.empty() ? op.name_ : ", " + op.name_;
+  }
+
+  std::vector<uint64_t> batch_sizes;
+  if (param->autotune_scheduling_batch_size_) {
+    batch_sizes = batch_size_tuner_->GetBatchSizes(key);
+  } else {
+    auto numa_nodes = ThreadInfo::GetInstance()->GetNumaNodes();
+    batch_sizes.assign(numa_nodes, param->scheduling_batch_size_);
+  }
+
+  std::vector<SchedulingStatistics> statistics;
+  auto* stats_ptr =
+      param->autotune_scheduling_batch_size_ ? &statistics : nullptr;
+
+  switch (param->scheduling_cost_model_) {
+    case Param::SchedulingCostModel::kNeighbors: {
+      auto* grid = sim->GetGrid();
+      auto cost = [&](SimObject* so) -> double {
+        return 1 + grid->GetNumSimObjectsInMooreNeighborhood(so->GetBoxIdx());
+      };
+      rm->ApplyOnAllElementsParallelCostWeighted(batch_sizes, function, cost,
+                                                 stats_ptr);
+      break;
+    }
+    case Param::SchedulingCostModel::kMeasured: {
+      ApplyMeasuredCostWeighted(key, batch_sizes, function, stats_ptr);
+      break;
+    }
+    default:
+      rm->ApplyOnAllElementsParallelDynamic(batch_sizes, function, stats_ptr);
+  }
+
+  if (param->autotune_scheduling_batch_size_) {
+    batch_size_tuner_->Update(key, statistics);
+  }
+}
+
+void Scheduler::ApplyMeasuredCostWeighted(
+    const std::string& key, const std::vector<uint64_t>& batch_sizes,
+    const std::function<void(SimObject*, SoHandle)>& function,
+    std::vector<SchedulingStatistics>* statistics) {
+  using Runtime = std::pair<int64_t, uint64_t>;  // (runtime in ns, count)
+  using RuntimeMap = std::unordered_map<std::type_index, Runtime>;
+
+  auto* rm = Simulation::GetActive()->GetResourceManager();
+  auto& costs = measured_costs_[key];
+
+  // cost of sim object types that have not been measured yet
+  double default_cost = 1;
+  if (!costs.empty()) {
+    default_cost = 0;
+    for (auto& el : costs) {
+      default_cost += el.second;
+    }
+    default_cost /= costs.size();
+  }
+  auto cost = [&](SimObject* so) -> double {
+    auto it = costs.find(std::type_index(typeid(*so)));
+    return it != costs.end() ? it->second : default_cost;
+  };
+
+  std::vector<RuntimeMap> runtimes(omp_get_max_threads());
+  auto timed_function = [&](SimObject* so, SoHandle handle) {
+    auto start = Clock::now();
+    function(so, handle);
+    auto duration = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                        Clock::now() - start)
+                        .count();
+    auto& runtime = runtimes[omp_get_thread_num()][typeid(*so)];
+    runtime.first += duration;
+    runtime.second++;
+  };
+
+  rm->ApplyOnAllElementsParallelCostWeighted(batch_sizes, timed_function,
+                                             cost, statistics);
+
+  // merge thread local measurements
+  RuntimeMap total;
+  for (auto& thread_runtimes : runtimes) {
+    for (auto& el : thread_runtimes) {
+      auto& runtime = total[el.first];
+      runtime.first += el.second.first;
+      runtime.second += el.second.second;
+    }
+  }
+  costs.clear();
+  for (auto& el : total) {
+    // avoid zero costs if the clock resolution is too low
+    costs[el.first] =
+        std::max(static_cast<double>(el.second.first) / el.second.second, 1.0);
+  }
+}
+
 void Scheduler::Backup() {
   using std::chrono::seconds;
   using std::chrono::duration_cast;
@@ -174,8 +573,14 @@ void Scheduler::Backup() {
   if (backup_->BackupEnabled() &&
       duration_cast<seconds>(Clock::now() - last_backup_).count() >=
           param->backup_interval_) {
-    last_backup_ = Clock::now();
-    backup_->Backup(total_steps_);
+    if (!param->backup_async_) {
+      last_backup_ = Clock::now();
+      backup_->Backup(total_steps_);
+    } else if (backup_->BackupAsync(total_steps_)) {
+      // otherwise, the previous backup is still running; retry in the next
+      // simulation step
+      last_backup_ = Clock::now();
+    }
   }
 }
 
@@ -185,6 +590,7 @@ void Scheduler::Backup() {
 bool Scheduler::Restore(uint64_t* steps) {
   if (backup_->RestoreEnabled() && restore_point_ > total_steps_ + *steps) {
     total_steps_ += *steps;
+    simulated_time_ += *steps * time_step_;
     // restore requested, but not last backup was not done during this call to
     // Simualte. Therefore, we skip it.
     return true;
@@ -193,6 +599,7 @@ bool Scheduler::Restore(uint64_t* steps) {
     // Restore
     backup_->Restore();
     *steps = total_steps_ + *steps - restore_point_;
+    simulated_time_ += (restore_point_ - total_steps_) * time_step_;
     total_steps_ = restore_point_;
   }
   return false;
@@ -223,6 +630,8 @@ void Scheduler::Initialize() {
   int lbound = grid->GetDimensionThresholds()[0];
   int rbound = grid->GetDimensionThresholds()[1];
   rm->ApplyOnAllDiffusionGrids([&](DiffusionGrid* dgrid) {
+    dgrid->SetSubCycling(param->diffusion_sub_cycling_);
+    dgrid->SetSecretionMode(param->secretion_mode_);
     // Create data structures, whose size depend on the grid dimensions
     dgrid->Initialize({lbound, rbound, lbound, rbound, lbound, rbound});
     // Initialize data structures with user-defined values
@@ -235,9 +644,14 @@ std::vector<Operation> Scheduler::GetScheduleOps() {
   scheduled_ops.reserve(operations_.size());
   auto* param = Simulation::GetActive()->GetParam();
   for (auto& op : operations_) {
+    // biology modules are a protected operation. Their frequency is
+    // therefore set through `Param::biology_module_frequency_`
+    if (op.name_ == "biology modules") {
+      op.frequency_ = param->biology_module_frequency_;
+    }
     // special condition for displacement
     if (op.name_ == "displacement" &&
-        (!param->run_mechanical_interactions_ || !displacement_->UseCpu())) {
+        (!param->run_mechanical_interactions_ || !UseCpuDisplacement())) {
       continue;
     }
     if (total_steps_ % op.frequency_ == 0) {
@@ -247,4 +661,21 @@ std::vector<Operation> Scheduler::GetScheduleOps() {
   return scheduled_ops;
 }
 
+bool Scheduler::UseCpuDisplacement() {
+  if (displacement_->UseCpu()) {
+    return true;
+  }
+  auto* op = GetOperation("displacement");
+  if (op == nullptr || op->ExecutesFunctor<DisplacementOp>()) {
+    return false;
+  }
+  if (!reported_cpu_displacement_fallback_) {
+    Log::Warning("Scheduler",
+                 "The displacement operation has been replaced. It is "
+                 "executed on the CPU instead of the SoA or GPU backend.");
+    reported_cpu_displacement_fallback_ = true;
+  }
+  return true;
+}
+
 }  // namespace bdm
@@ -19,8 +19,11 @@
 #include <functional>
 #include <set>
 #include <string>
+#include <typeindex>
+#include <unordered_map>
 #include <vector>
 #include "core/operation/operation.h"
+#include "core/resource_manager.h"
 
 namespace bdm {
 
@@ -31,6 +34,9 @@ class RootAdaptor;
 class BoundSpace;
 class DisplacementOp;
 class DiffusionOp;
+class BatchSizeTuner;
+class TimeStepController;
+class CylinderInteractionCounter;
 
 class Scheduler {
  public:
@@ -42,9 +48,48 @@ class Scheduler {
 
   void Simulate(uint64_t steps);
 
+  /// Simulates until the simulated time (see `GetSimulatedTime`) reaches
+  /// `time`. Useful if the time step is adapted during the simulation
+  /// (see `Param::adaptive_time_step_`). Restoring from a backup is not
+  /// supported.
+  void SimulateUntil(double time);
+
   /// This function returns the numer of simulated steps (=iterations).
   uint64_t GetSimulatedSteps() const;
 
+  /// Returns the simulated time, i.e. the sum of the time steps of all
+  /// simulated steps. If simulation steps have been restored from a backup,
+  /// they are accounted with the current time step.
+  double GetSimulatedTime() const;
+
+  /// Returns the time step of the current simulation step.
+  /// `Param::simulation_time_step_` unless `Param::adaptive_time_step_` is
+  /// enabled.
+  double GetSimulationTimeStep() const;
+
+  /// Returns the time that elapses between two executions of the biology
+  /// modules (`GetSimulationTimeStep()` multiplied by
+  /// `Param::biology_module_frequency_`). Biology modules should use this
+  /// value to integrate over time.
+  double GetBiologyModuleTimeStep() const;
+
+  /// Returns the time that elapses between two executions of the operation
+  /// with the given name (`GetSimulationTimeStep()` multiplied by
+  /// `Operation::frequency_`). If the operation does not exist,
+  /// `GetSimulationTimeStep()` will be returned.
+  double GetOperationTimeStep(const std::string& op_name) const;
+
+  /// Returns the controller that adapts the time step if
+  /// `Param::adaptive_time_step_` is enabled.
+  TimeStepController* GetTimeStepController() { return time_step_controller_; }
+
+  /// Returns the counter of the cylinder interactions that `DefaultForce`
+  /// rejected or evaluated during this simulation. Only populated if
+  /// `Param::statistics_` is enabled.
+  CylinderInteractionCounter* GetCylinderInteractionCounter() {
+    return cylinder_interaction_counter_;
+  }
+
   void AddOperation(const Operation& operation);
 
   /// Remove an operation. However, some operations are protected and cannot
@@ -60,8 +105,17 @@ class Scheduler {
 
   RootAdaptor* GetRootVisualization() { return root_visualization_; }
 
+  /// Returns the sim objects for which the displacement was calculated in the
+  /// last simulation step. Only populated if
+  /// `Param::detect_static_sim_objects_` is enabled.
+  const std::vector<SoHandle>& GetActiveSimObjects() const {
+    return active_sim_objects_;
+  }
+
  protected:
   uint64_t total_steps_ = 0;
+  /// Sum of the time steps of all simulated steps
+  double simulated_time_ = 0;
 
   /// Executes one step.
   /// This design makes testing more convenient
@@ -75,13 +129,41 @@ class Scheduler {
   RootAdaptor* root_visualization_ = nullptr;      //!
 
   bool is_gpu_environment_initialized_ = false;
+  /// True if the fallback to the CPU displacement has been reported
+  /// (\see UseCpuDisplacement)
+  bool reported_cpu_displacement_fallback_ = false;
 
   BoundSpace* bound_space_;
   DisplacementOp* displacement_;
   DiffusionOp* diffusion_;
+  BatchSizeTuner* batch_size_tuner_;
+  TimeStepController* time_step_controller_;
+  CylinderInteractionCounter* cylinder_interaction_counter_;
+  /// Time step of the current simulation step
+  double time_step_;
 
   std::vector<Operation> operations_;  //!
   std::set<std::string> protected_operations_;
+  /// Sim objects that were displaced in the last simulation step.
+  /// Only used if `Param::detect_static_sim_objects_` is enabled.
+  std::vector<SoHandle> active_sim_objects_;  //!
+  /// Sim objects whose displacement flag is set for the next simulation
+  /// step (i.e. sim objects that moved, grew or divided and their neighbors)
+  /// and their uids. Persists across simulation steps.
+  /// Only used if `Param::detect_static_sim_objects_` is enabled.
+  std::vector<SoHandle> next_active_sim_objects_;  //!
+  std::vector<SoUid> next_active_uids_;            //!
+  /// Layout generation of the ResourceManager and number of sim objects for
+  /// which `next_active_sim_objects_` is valid. If they do not match, all sim
+  /// objects are scanned for their flag (\see CollectActiveSimObjects).
+  uint64_t active_generation_ = 0;       //!
+  uint64_t active_num_sim_objects_ = 0;  //!
+  /// Average runtime in ns of one sim object type for a combination of
+  /// operations. Only used if `Param::scheduling_cost_model_` is
+  /// `Param::SchedulingCostModel::kMeasured`.
+  std::unordered_map<std::string,
+                     std::unordered_map<std::type_index, double>>
+      measured_costs_;  //!
 
   /// Backup the simulation. Backup interval based on `Param::backup_interval_`
   void Backup();
@@ -96,8 +178,62 @@ class Scheduler {
   // if Simulate is called with one timestep.
   void Initialize();
 
+  /// Executes one simulation step, advances the simulated time and adapts
+  /// the time step if `Param::adaptive_time_step_` is enabled.
+  void SimulateStep();
+
   // Decide which operations should be executed
   std::vector<Operation> GetScheduleOps();
+
+  /// Returns true if the displacement operation is executed for each sim
+  /// object. This is the case if `DisplacementOp` selects the CPU
+  /// implementation, or if the displacement operation has been replaced
+  /// (e.g. with a custom force model in `DisplacementOpCpu`). The SoA and GPU
+  /// implementations only support the default force model.
+  bool UseCpuDisplacement();
+
+  /// Executes the scheduled operations if `Param::detect_static_sim_objects_`
+  /// is enabled. The operations "first", "displacement" and "last" are only
+  /// executed for active sim objects, which are kept across simulation steps.
+  /// A sim object becomes active if it moved, grew or divided
+  /// (\see SimObject::SetRunDisplacementForAllNextTs), or if it is in
+  /// contact with such a sim object. All other operations are executed for
+  /// all sim objects in one pass. The order of operations of each sim object
+  /// is preserved.
+  void ExecuteOnActiveSimObjects(const std::vector<Operation>& scheduled_ops);
+
+  /// Scans all sim objects for their displacement flag of the next step.
+  /// Required if sim objects have been added or reordered outside of the
+  /// scheduler.
+  void CollectActiveSimObjects();
+
+  /// Resets the displacement flag of the sim objects that were displaced in
+  /// this step. Returns the uids of new sim objects whose displacement flag
+  /// is set for the next step. Must be called before the execution contexts
+  /// are torn down.
+  std::vector<SoUid> ResetActiveSimObjects();
+
+  /// Updates the active sim objects after the execution contexts have been
+  /// torn down: removed sim objects are dropped and `new_active_uids` are
+  /// added.
+  void UpdateActiveSimObjects(const std::vector<SoUid>& new_active_uids);
+
+  /// Applies `function` on all sim objects using the dynamic scheduler of the
+  /// `ResourceManager`. `ops` are the operations executed by `function`. They
+  /// identify the batch sizes if `Param::autotune_scheduling_batch_size_` is
+  /// enabled and the measured costs if `Param::scheduling_cost_model_` is
+  /// `Param::SchedulingCostModel::kMeasured`.
+  void ApplyOnAllElementsParallelDynamic(
+      const std::vector<Operation>& ops,
+      const std::function<void(SimObject*, SoHandle)>& function);
+
+  /// Applies `function` on all sim objects with batches of equal cost. The
+  /// cost of a sim object is the runtime of its type measured during the
+  /// last call with the same `key`. The measurements are updated afterwards.
+  void ApplyMeasuredCostWeighted(
+      const std::string& key, const std::vector<uint64_t>& batch_sizes,
+      const std::function<void(SimObject*, SoHandle)>& function,
+      std::vector<SchedulingStatistics>* statistics);
 };
 
 }  // namespace bdm
@@ -29,10 +29,13 @@
 #include "core/event/cell_division_event.h"
 #include "core/event/event.h"
 #include "core/execution_context/in_place_exec_ctxt.h"
+#include "core/grid.h"
 #include "core/param/param.h"
+#include "core/scheduler.h"
 #include "core/shape.h"
 #include "core/sim_object/sim_object.h"
 #include "core/util/math.h"
+#include "core/util/type.h"
 
 namespace bdm {
 
@@ -133,6 +136,8 @@ class Cell : public SimObject {
 
   Shape GetShape() const override { return Shape::kSphere; }
 
+  bool IsCell() const override { return true; }
+
   /// \brief Divide this cell.
   ///
   /// CellDivisionEvent::volume_ratio_ will be between 0.9 and 1.1\n
@@ -230,8 +235,8 @@ class Cell : public SimObject {
 
   void ChangeVolume(double speed) {
     // scaling for integration step
-    auto* param = Simulation::GetActive()->GetParam();
-    double delta = speed * param->simulation_time_step_;
+    auto* scheduler = Simulation::GetActive()->GetScheduler();
+    double delta = speed * scheduler->GetBiologyModuleTimeStep();
     volume_ += delta;
     if (volume_ < 5.2359877E-7) {
       volume_ = 5.2359877E-7;
@@ -259,6 +264,14 @@ class Cell : public SimObject {
   }
 
   Double3 CalculateDisplacement(double squared_radius, double dt) override {
+    return CalculateDisplacement(DefaultForce(), squared_radius, dt);
+  }
+
+  /// Calculates the displacement using the given force model.
+  /// \see DefaultForce, DisplacementOpCpu
+  template <typename TForce>
+  Double3 CalculateDisplacement(const TForce& force, double squared_radius,
+                                double dt) {
     // Basically, the idea is to make the sum of all the forces acting
     // on the Point mass. It is stored in translationForceOnPointMass.
     // There is also a computation of the torque (only applied
@@ -299,17 +312,42 @@ class Cell : public SimObject {
     //  (We check for every neighbor object if they touch us, i.e. push us
     //  away)
 
-    auto calculate_neighbor_forces = [&, this](const auto* neighbor) {
-      DefaultForce default_force;
-      auto neighbor_force = default_force.GetForce(this, neighbor);
-      translation_force_on_point_mass[0] += neighbor_force[0];
-      translation_force_on_point_mass[1] += neighbor_force[1];
-      translation_force_on_point_mass[2] += neighbor_force[2];
-    };
-
-    auto* ctxt = Simulation::GetActive()->GetExecutionContext();
-    ctxt->ForEachNeighborWithinRadius(calculate_neighbor_forces, *this,
-                                      squared_radius);
+    auto* sim = Simulation::GetActive();
+    auto* ctxt = sim->GetExecutionContext();
+    if (sim->GetGrid()->ContainsOnlyCells()) {
+      // All neighbors are cells. Therefore, the shape dispatch and the
+      // virtual function calls in `GetForce` can be skipped.
+      if (std::is_same<TForce, DefaultForce>::value) {
+        // calculate forces in batches
+        SphereForceAccumulator<> accumulator(position_, diameter_);
+        auto calculate_sphere_forces = [&](const SimObject* neighbor) {
+          auto* cell = bdm_static_cast<const Cell*>(neighbor);
+          accumulator.Add(cell->position_, cell->diameter_);
+        };
+        ctxt->ForEachNeighborWithinRadius(calculate_sphere_forces, *this,
+                                          squared_radius);
+        translation_force_on_point_mass = accumulator.GetForce();
+      } else {
+        auto calculate_sphere_forces = [&](const SimObject* neighbor) {
+          auto* cell = bdm_static_cast<const Cell*>(neighbor);
+          Double3 neighbor_force;
+          force.ForceBetweenSpheres(position_, diameter_, cell->position_,
+                                    cell->diameter_, &neighbor_force);
+          translation_force_on_point_mass += neighbor_force;
+        };
+        ctxt->ForEachNeighborWithinRadius(calculate_sphere_forces, *this,
+                                          squared_radius);
+      }
+    } else {
+      auto calculate_neighbor_forces = [&, this](const auto* neighbor) {
+        auto neighbor_force = force.GetForce(this, neighbor);
+        translation_force_on_point_mass[0] += neighbor_force[0];
+        translation_force_on_point_mass[1] += neighbor_force[1];
+        translation_force_on_point_mass[2] += neighbor_force[2];
+      };
+      ctxt->ForEachNeighborWithinRadius(calculate_neighbor_forces, *this,
+                                        squared_radius);
+    }
 
     // 4) PhysicalBonds
     // How the physics influences the next displacement
@@ -59,6 +59,7 @@ SimObject::SimObject(const SimObject& other)
       run_displacement_for_all_next_ts_(
           other.run_displacement_for_all_next_ts_),
       run_displacement_next_ts_(other.run_displacement_next_ts_) {
+  biology_modules_.reserve(other.biology_modules_.size());
   for (auto* module : other.biology_modules_) {
     biology_modules_.push_back(module->GetCopy());
   }
@@ -66,7 +67,7 @@ SimObject::SimObject(const SimObject& other)
 
 SimObject::~SimObject() {
   for (auto* el : biology_modules_) {
-    delete el;
+    BaseBiologyModule::Release(el);
   }
 }
 
@@ -112,7 +113,7 @@ void SimObject::AddBiologyModule(BaseBiologyModule* module) {
 void SimObject::RemoveBiologyModule(const BaseBiologyModule* remove_module) {
   for (unsigned int i = 0; i < biology_modules_.size(); i++) {
     if (biology_modules_[i] == remove_module) {
-      delete remove_module;
+      BaseBiologyModule::Release(biology_modules_[i]);
       biology_modules_.erase(biology_modules_.begin() + i);
       // if remove_module was before or at the current run_bm_loop_idx_,
       // correct it by subtracting one.
@@ -150,6 +151,7 @@ void SimObject::EventHandler(const Event& event, SimObject* other1,
 
 void SimObject::CopyBiologyModules(const Event& event,
                                    decltype(biology_modules_) * other) {
+  biology_modules_.reserve(other->size());
   for (auto* bm : *other) {
     if (bm->Copy(event.GetId())) {
       auto* new_bm = bm->GetInstance(event, bm);
@@ -181,7 +183,7 @@ void SimObject::BiologyModuleEventHandler(const Event& event,
   for (auto it = biology_modules_.begin(); it != biology_modules_.end();) {
     auto* bm = *it;
     if (bm->Remove(event.GetId())) {
-      delete *it;
+      BaseBiologyModule::Release(bm);
       it = biology_modules_.erase(it);
     } else {
       ++it;
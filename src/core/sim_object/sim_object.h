@@ -165,6 +165,12 @@ class SimObject {
 
   virtual Shape GetShape() const = 0;
 
+  /// Returns true if this simulation object derives from `Cell`.
+  /// If all simulation objects are cells, mechanical interactions are
+  /// calculated with a specialized implementation that accesses the data
+  /// members of `Cell` directly (see `Grid::ContainsOnlyCells`).
+  virtual bool IsCell() const { return false; }
+
   /// Returns the data members that are required to visualize this simulation
   /// object.
   virtual std::set<std::string> GetRequiredVisDataMembers() const {
@@ -185,6 +191,18 @@ class SimObject {
     run_displacement_next_ts_ = run;
   }
 
+  bool GetRunDisplacementNextTimestep() const {
+    return run_displacement_next_ts_;
+  }
+
+  /// Sets the displacement flag for the next timestep. Can be called
+  /// concurrently for the same sim object.
+  /// @return true if the flag has not been set before
+  bool MarkRunDisplacementNextTimestep() const {
+    return !__atomic_exchange_n(&run_displacement_next_ts_, true,
+                                __ATOMIC_RELAXED);
+  }
+
   bool GetRunDisplacementForAllNextTs() const {
     return run_displacement_for_all_next_ts_;
   }
@@ -202,6 +220,9 @@ class SimObject {
 
   bool RunDisplacement() const { return run_displacement_; }
 
+  /// Clears the displacement flag of the current timestep.
+  void ResetRunDisplacement() { run_displacement_ = false; }
+
   /// Return simulation object pointer
   template <typename TSimObject = SimObject>
   SoPointer<TSimObject> GetSoPtr() const {
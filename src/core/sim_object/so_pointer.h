@@ -15,11 +15,15 @@
 #ifndef CORE_SIM_OBJECT_SO_POINTER_H_
 #define CORE_SIM_OBJECT_SO_POINTER_H_
 
+#include <atomic>
+#include <cassert>
 #include <cstdint>
 #include <limits>
 #include <ostream>
+#include <type_traits>
 
 #include "core/execution_context/in_place_exec_ctxt.h"
+#include "core/sim_object/so_handle.h"
 #include "core/sim_object/so_uid.h"
 #include "core/simulation.h"
 #include "core/util/root.h"
@@ -28,13 +32,44 @@ namespace bdm {
 
 class SimObject;
 
+namespace detail {
+
+/// Casts a sim object to `TTo`. If `TTo` derives from `SimObject`, a static
+/// cast is used. Its correctness is only checked in debug builds.
+template <typename TTo, typename TFrom>
+typename std::enable_if<
+    std::is_base_of<SimObject, typename std::remove_const<TTo>::type>::value,
+    TTo*>::type
+SoPointerCast(TFrom* so) {
+  assert(so == nullptr || dynamic_cast<TTo*>(so) != nullptr);
+  return static_cast<TTo*>(so);
+}
+
+/// Casts a sim object to `TTo`. `TTo` does not derive from `SimObject`
+/// (e.g. `NeuronOrNeurite`). Therefore, a cross cast is required.
+template <typename TTo, typename TFrom>
+typename std::enable_if<
+    !std::is_base_of<SimObject, typename std::remove_const<TTo>::type>::value,
+    TTo*>::type
+SoPointerCast(TFrom* so) {
+  return dynamic_cast<TTo*>(so);
+}
+
+}  // namespace detail
+
 /// Simulation object pointer. Required to point to a simulation object with
 /// throughout the whole simulation. Raw pointers cannot be used, because
 /// a sim object might be copied to a different NUMA domain, or if it resides
 /// on a different address space in case of a distributed runtime.
 /// Benefit compared to SoHandle is, that the compiler knows
 /// the type returned by `Get` and can therefore inline the code from the callee
-/// and perform optimizations.
+/// and perform optimizations.\n
+/// SoPointer caches the SoHandle of the sim object. As long as the
+/// layout of the ResourceManager does not change (see
+/// `ResourceManager::GetLayoutGeneration`), dereferencing is a direct
+/// array access instead of a hash map lookup. The cache is updated
+/// atomically; an SoPointer can therefore be dereferenced from several
+/// threads concurrently.
 /// @tparam TSimObject simulation object type
 template <typename TSimObject>
 class SoPointer {
@@ -44,6 +79,10 @@ class SoPointer {
   /// constructs an SoPointer object representing a nullptr
   SoPointer() {}
 
+  SoPointer(const SoPointer& other)
+      : uid_(other.uid_),
+        cache_(other.cache_.load(std::memory_order_relaxed)) {}
+
   virtual ~SoPointer() {}
 
   uint64_t GetUid() const { return uid_; }
@@ -76,16 +115,25 @@ class SoPointer {
     return *this;
   }
 
+  SoPointer& operator=(const SoPointer& other) {
+    uid_ = other.uid_;
+    cache_.store(other.cache_.load(std::memory_order_relaxed),
+                 std::memory_order_relaxed);
+    return *this;
+  }
+
   TSimObject* operator->() {
     assert(*this != nullptr);
     auto* ctxt = Simulation::GetActive()->GetExecutionContext();
-    return dynamic_cast<TSimObject*>(ctxt->GetSimObject(uid_));
+    return detail::SoPointerCast<TSimObject>(
+        ctxt->GetSimObject(uid_, &cache_));
   }
 
   const TSimObject* operator->() const {
     assert(*this != nullptr);
     auto* ctxt = Simulation::GetActive()->GetExecutionContext();
-    return dynamic_cast<const TSimObject*>(ctxt->GetConstSimObject(uid_));
+    return detail::SoPointerCast<const TSimObject>(
+        ctxt->GetSimObject(uid_, &cache_));
   }
 
   friend std::ostream& operator<<(std::ostream& str, const SoPointer& so_ptr) {
@@ -107,6 +155,10 @@ class SoPointer {
 
  private:
   SoUid uid_ = std::numeric_limits<uint64_t>::max();
+  /// SoHandle of the sim object and the layout generation it has been
+  /// obtained in (see `InPlaceExecutionContext::GetSimObject`)
+  mutable std::atomic<uint64_t> cache_{
+      std::numeric_limits<uint64_t>::max()};  //!
 
   BDM_TEMPLATE_CLASS_DEF(SoPointer, 2);
 };
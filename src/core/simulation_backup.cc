@@ -13,6 +13,9 @@
 // -----------------------------------------------------------------------------
 
 #include "core/simulation_backup.h"
+#include <omp.h>
+#include <sys/wait.h>
+#include <unistd.h>
 
 namespace bdm {
 
@@ -39,6 +42,67 @@ SimulationBackup::SimulationBackup(const std::string& backup_file,
   }
 }
 
+SimulationBackup::~SimulationBackup() { WaitForAsyncBackup(); }
+
+bool SimulationBackup::BackupAsync(size_t completed_simulation_steps) {
+  if (!backup_) {
+    Log::Fatal("SimulationBackup",
+               "Requested to backup data, but no backup file given.");
+  }
+  if (IsAsyncBackupRunning()) {
+    return false;
+  }
+
+  auto pid = fork();
+  if (pid == 0) {
+    // child process: only the forking thread has been copied. Therefore, the
+    // OpenMP thread pool of the parent must not be used.
+    omp_set_num_threads(1);
+    Backup(completed_simulation_steps);
+    // skip exit handlers and do not flush stdio buffers inherited from the
+    // parent
+    _exit(0);
+  } else if (pid < 0) {
+    Log::Warning("SimulationBackup",
+                 "Could not create process for asynchronous backup. Fall "
+                 "back to synchronous backup.");
+    Backup(completed_simulation_steps);
+  } else {
+    backup_pid_ = pid;
+  }
+  return true;
+}
+
+bool SimulationBackup::IsAsyncBackupRunning() {
+  if (backup_pid_ == -1) {
+    return false;
+  }
+  int status;
+  auto ret = waitpid(backup_pid_, &status, WNOHANG);
+  if (ret == 0) {
+    return true;
+  }
+  if (ret == -1 || !WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+    Log::Warning("SimulationBackup", "Asynchronous backup to ", backup_file_,
+                 " failed.");
+  }
+  backup_pid_ = -1;
+  return false;
+}
+
+void SimulationBackup::WaitForAsyncBackup() {
+  if (backup_pid_ == -1) {
+    return;
+  }
+  int status;
+  auto ret = waitpid(backup_pid_, &status, 0);
+  if (ret == -1 || !WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+    Log::Warning("SimulationBackup", "Asynchronous backup to ", backup_file_,
+                 " failed.");
+  }
+  backup_pid_ = -1;
+}
+
 size_t SimulationBackup::GetSimulationStepsFromBackup() {
   if (restore_) {
     IntegralTypeWrapper<size_t>* wrapper = nullptr;
@@ -15,6 +15,7 @@
 #ifndef CORE_SIMULATION_BACKUP_H_
 #define CORE_SIMULATION_BACKUP_H_
 
+#include <sys/types.h>
 #include <functional>
 #include <sstream>
 #include <string>
@@ -50,6 +51,9 @@ class SimulationBackup {
   SimulationBackup(const std::string& backup_file,
                    const std::string& restore_file);
 
+  /// Waits until an asynchronous backup has been finished
+  ~SimulationBackup();
+
   void Backup(size_t completed_simulation_steps) {
     if (!backup_) {
       Log::Fatal("SimulationBackup",
@@ -79,6 +83,22 @@ class SimulationBackup {
     rename(tmp_file.str().c_str(), backup_file_.c_str());
   }
 
+  /// Writes the backup in a child process that operates on a copy-on-write
+  /// snapshot of this process. Therefore, the caller can continue with the
+  /// simulation immediately. The atomicity guarantees of `Backup` are
+  /// retained, since the child process calls `Backup`.\n
+  /// Falls back to a synchronous backup if the child process cannot be
+  /// created.
+  /// @return false if the previous asynchronous backup is still running. In
+  ///         this case no backup is made.
+  bool BackupAsync(size_t completed_simulation_steps);
+
+  /// Returns true if an asynchronous backup is being written
+  bool IsAsyncBackupRunning();
+
+  /// Blocks until the current asynchronous backup (if any) has been finished
+  void WaitForAsyncBackup();
+
   void Restore() {
     if (!restore_) {
       Log::Fatal("SimulationBackup",
@@ -118,6 +138,9 @@ class SimulationBackup {
   bool restore_ = true;
   std::string backup_file_;
   std::string restore_file_;
+  /// Process id of the child process that writes the asynchronous backup.
+  /// -1 if there is no asynchronous backup in progress.
+  pid_t backup_pid_ = -1;
 };
 
 }  // namespace bdm
@@ -15,6 +15,8 @@
 #ifndef CORE_SUBSTANCE_INITIALIZERS_H_
 #define CORE_SUBSTANCE_INITIALIZERS_H_
 
+#include <algorithm>
+#include <cmath>
 #include <stdexcept>
 #include <vector>
 
@@ -26,7 +28,10 @@ namespace bdm {
 
 // -----------------------------------------------------------------------------
 // A substance initializer is a function that can be used to initialize the
-// concentration values of a particular substance in space.
+// concentration values of a particular substance in space. The initializers
+// below also provide the batch interface `FillRow`, which initializes a whole
+// line of the diffusion grid along the x-axis at once
+// (see `DiffusionGrid::AddInitializer`).
 // -----------------------------------------------------------------------------
 
 // Use this enum to express the axis you are interested in
@@ -72,6 +77,22 @@ struct Uniform {
     }
     return 0;
   }
+
+  /// Stores the concentrations at the positions (x0 + i * dx, y, z) in
+  /// `values[i]` for `i` in [0, n)
+  void FillRow(double x0, double dx, uint64_t n, double y, double z,
+               double* values) {
+    if (axis_ != Axis::kXAxis) {
+      // constant along the x-axis
+      std::fill(values, values + n, (*this)(x0, y, z));
+      return;
+    }
+#pragma omp simd
+    for (uint64_t i = 0; i < n; i++) {
+      double x = x0 + i * dx;
+      values[i] = x >= min_ && x <= max_ ? value_ : 0;
+    }
+  }
 };
 
 /// An initializer that follows a Gaussian (normal) distribution along one axis
@@ -116,6 +137,25 @@ struct GaussianBand {
         throw std::logic_error("You have chosen an non-existing axis!");
     }
   }
+
+  /// Stores the concentrations at the positions (x0 + i * dx, y, z) in
+  /// `values[i]` for `i` in [0, n)
+  void FillRow(double x0, double dx, uint64_t n, double y, double z,
+               double* values) {
+    if (axis_ != Axis::kXAxis) {
+      // constant along the x-axis
+      std::fill(values, values + n, (*this)(x0, y, z));
+      return;
+    }
+    // same formula as `normal_pdf` with the constant factors hoisted
+    const double factor = 1 / (std::sqrt(2 * M_PI) * std::fabs(sigma_));
+    const double exponent = -1 / (2 * sigma_ * sigma_);
+#pragma omp simd
+    for (uint64_t i = 0; i < n; i++) {
+      double d = x0 + i * dx - mean_;
+      values[i] = factor * std::exp(d * d * exponent);
+    }
+  }
 };
 
 /// An initializer that follows a Poisson (normal) distribution along one axis
@@ -156,6 +196,20 @@ struct PoissonBand {
         throw std::logic_error("You have chosen an non-existing axis!");
     }
   }
+
+  /// Stores the concentrations at the positions (x0 + i * dx, y, z) in
+  /// `values[i]` for `i` in [0, n)
+  void FillRow(double x0, double dx, uint64_t n, double y, double z,
+               double* values) {
+    if (axis_ != Axis::kXAxis) {
+      // constant along the x-axis
+      std::fill(values, values + n, (*this)(x0, y, z));
+      return;
+    }
+    for (uint64_t i = 0; i < n; i++) {
+      values[i] = (*this)(x0 + i * dx, y, z);
+    }
+  }
 };
 
 }  // namespace bdm
@@ -0,0 +1,182 @@
+// -----------------------------------------------------------------------------
+//
+// Copyright (C) The BioDynaMo Project.
+// All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+//
+// See the LICENSE file distributed with this work for details.
+// See the NOTICE file distributed with this work for additional information
+// regarding copyright ownership.
+//
+// -----------------------------------------------------------------------------
+
+#ifndef CORE_UTIL_BATCH_SIZE_TUNER_H_
+#define CORE_UTIL_BATCH_SIZE_TUNER_H_
+
+#include <algorithm>
+#include <limits>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "core/util/scheduling_statistics.h"
+#include "core/util/thread_info.h"
+#include "core/util/timing_aggregator.h"
+
+namespace bdm {
+
+/// Adapts the batch size of the dynamic scheduler at runtime.\n
+/// Batch sizes are tuned separately for each key (e.g. the operations that
+/// are executed in one pass over all sim objects) and for each NUMA node.
+/// The tuner uses a hill climbing strategy that doubles or halves the batch
+/// size as long as the runtime per sim object improves. The initial search
+/// direction is determined by the steal rate: a high steal rate indicates
+/// load imbalance, which is addressed with smaller batches. Once converged,
+/// the search is restarted if the runtime per sim object degrades
+/// significantly or the number of sim objects changes considerably.
+class BatchSizeTuner {
+ public:
+  explicit BatchSizeTuner(uint64_t initial_batch_size)
+      : initial_batch_size_(std::max<uint64_t>(initial_batch_size, 1)) {}
+
+  /// Returns the batch size for each NUMA node for the given key.
+  const std::vector<uint64_t>& GetBatchSizes(const std::string& key) {
+    auto numa_nodes = ThreadInfo::GetInstance()->GetNumaNodes();
+    auto& state = states_[key];
+    if (state.batch_sizes.size() != static_cast<uint64_t>(numa_nodes)) {
+      state.batch_sizes.assign(numa_nodes, initial_batch_size_);
+      state.nodes.assign(numa_nodes, NodeState());
+    }
+    return state.batch_sizes;
+  }
+
+  /// Adapts the batch sizes of `key` based on the measurements of their last
+  /// execution.
+  void Update(const std::string& key,
+              const std::vector<SchedulingStatistics>& statistics) {
+    auto* thread_info = ThreadInfo::GetInstance();
+    auto& state = states_[key];
+    auto numa_nodes = std::min(statistics.size(), state.nodes.size());
+    for (uint64_t n = 0; n < numa_nodes; n++) {
+      auto& stats = statistics[n];
+      if (stats.num_sim_objects == 0) {
+        continue;
+      }
+      auto threads = std::max(thread_info->GetThreadsInNumaNode(n), 1);
+      auto max_batch_size =
+          std::max<uint64_t>(stats.num_sim_objects / threads, 1);
+      state.batch_sizes[n] = UpdateNode(stats, max_batch_size,
+                                        state.batch_sizes[n], &state.nodes[n]);
+    }
+  }
+
+  /// Adds the chosen batch sizes to `statistics`
+  void AddDescriptions(TimingAggregator* statistics) const {
+    for (auto& el : states_) {
+      for (uint64_t n = 0; n < el.second.batch_sizes.size(); n++) {
+        std::stringstream description;
+        description << "batch size [" << el.first << "] numa node " << n
+                    << ": " << el.second.batch_sizes[n];
+        statistics->AddDescription(description.str());
+      }
+    }
+  }
+
+ private:
+  /// Steal rate above which the search starts with smaller batches
+  static constexpr double kHighStealRate = 0.25;
+  /// Minimum relative improvement of the runtime per sim object to continue
+  /// the search in the same direction
+  static constexpr double kMinImprovement = 0.02;
+  /// Relative degradation of the runtime per sim object that restarts the
+  /// search after convergence
+  static constexpr double kRetuneThreshold = 1.25;
+
+  struct NodeState {
+    /// Search direction: 1 grow, -1 shrink, 0 converged
+    int direction = 0;
+    /// Number of search direction reversals since the last (re)start
+    uint64_t reversals = 0;
+    /// Number of sim objects at the last (re)start
+    uint64_t num_sim_objects = 0;
+    uint64_t best_batch_size = 0;
+    double best_runtime_per_so = std::numeric_limits<double>::max();
+  };
+
+  struct KeyState {
+    std::vector<uint64_t> batch_sizes;
+    std::vector<NodeState> nodes;
+  };
+
+  uint64_t initial_batch_size_;
+  std::map<std::string, KeyState> states_;
+
+  /// Returns the batch size for the next execution
+  uint64_t UpdateNode(const SchedulingStatistics& stats,
+                      uint64_t max_batch_size, uint64_t batch_size,
+                      NodeState* node) {
+    double runtime_per_so =
+        static_cast<double>(stats.runtime) / stats.num_sim_objects;
+
+    bool restart = node->best_batch_size == 0;
+    if (!restart && node->direction == 0) {
+      auto ratio = static_cast<double>(stats.num_sim_objects) /
+                   node->num_sim_objects;
+      restart = runtime_per_so > kRetuneThreshold * node->best_runtime_per_so ||
+                ratio > 2 || ratio < 0.5;
+      if (!restart) {
+        // keep the converged value, but track slow changes
+        node->best_runtime_per_so = runtime_per_so;
+        return batch_size;
+      }
+    }
+
+    if (restart) {
+      node->direction = stats.GetStealRate() > kHighStealRate ? -1 : 1;
+      node->reversals = 0;
+      node->num_sim_objects = stats.num_sim_objects;
+      node->best_batch_size = batch_size;
+      node->best_runtime_per_so = runtime_per_so;
+    } else if (runtime_per_so <
+               node->best_runtime_per_so * (1 - kMinImprovement)) {
+      node->best_batch_size = batch_size;
+      node->best_runtime_per_so = runtime_per_so;
+    } else {
+      // no improvement: continue from the best batch size in the opposite
+      // direction
+      batch_size = node->best_batch_size;
+      node->direction = -node->direction;
+      node->reversals++;
+    }
+
+    auto next = Step(batch_size, node->direction, max_batch_size);
+    if (next == batch_size && node->direction != 0) {
+      // reached a bound
+      node->direction = -node->direction;
+      node->reversals++;
+      next = Step(batch_size, node->direction, max_batch_size);
+    }
+    if (node->reversals >= 2 || next == batch_size) {
+      node->direction = 0;
+      return node->best_batch_size;
+    }
+    return next;
+  }
+
+  static uint64_t Step(uint64_t batch_size, int direction,
+                       uint64_t max_batch_size) {
+    if (direction > 0) {
+      return std::min(batch_size * 2, std::max(max_batch_size, batch_size));
+    } else if (direction < 0) {
+      return std::max<uint64_t>(batch_size / 2, 1);
+    }
+    return batch_size;
+  }
+};
+
+}  // namespace bdm
+
+#endif  // CORE_UTIL_BATCH_SIZE_TUNER_H_
@@ -0,0 +1,80 @@
+// -----------------------------------------------------------------------------
+//
+// Copyright (C) The BioDynaMo Project.
+// All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+//
+// See the LICENSE file distributed with this work for details.
+// See the NOTICE file distributed with this work for additional information
+// regarding copyright ownership.
+//
+// -----------------------------------------------------------------------------
+
+#ifndef CORE_UTIL_CYLINDER_INTERACTION_COUNTER_H_
+#define CORE_UTIL_CYLINDER_INTERACTION_COUNTER_H_
+
+#include <omp.h>
+
+#include <array>
+#include <atomic>
+#include <vector>
+
+#include "core/util/thread_info.h"
+
+namespace bdm {
+
+/// Counts the cylinder interactions (cylinder-cylinder and cylinder-sphere)
+/// that `DefaultForce` rejects with the bounding box test and the ones that
+/// it evaluates exactly. Only used if `Param::statistics_` is enabled.\n
+/// Each thread counts into its own slot. Threads with an id beyond the
+/// number of threads in `ThreadInfo` fall back to atomic counters.
+class CylinderInteractionCounter {
+ public:
+  CylinderInteractionCounter()
+      : counters_(ThreadInfo::GetInstance()->GetMaxThreads(), {{0}}) {}
+
+  /// Counts the result of one bounding box test.
+  /// Can be called concurrently from different threads.
+  void Count(bool rejected) {
+    auto tid = static_cast<uint64_t>(omp_get_thread_num());
+    uint64_t idx = rejected ? 0 : 1;
+    if (tid < counters_.size()) {
+      counters_[tid][idx]++;
+    } else {
+      overflow_[idx]++;
+    }
+  }
+
+  /// Returns the number of rejected and evaluated interactions since the
+  /// construction or the last call to `Reset`. Sums up the counts of all
+  /// threads.
+  void GetCounts(uint64_t* rejected, uint64_t* evaluated) const {
+    *rejected = overflow_[0];
+    *evaluated = overflow_[1];
+    for (auto& counter : counters_) {
+      *rejected += counter[0];
+      *evaluated += counter[1];
+    }
+  }
+
+  void Reset() {
+    for (auto& counter : counters_) {
+      counter[0] = 0;
+      counter[1] = 0;
+    }
+    overflow_[0] = 0;
+    overflow_[1] = 0;
+  }
+
+ private:
+  /// Rejected (element 0) and evaluated (element 1) interactions per thread.
+  /// Padded to avoid false sharing (assumes 64 byte cache lines).
+  std::vector<std::array<uint64_t, 8>> counters_;
+  std::array<std::atomic<uint64_t>, 2> overflow_ = {{{0}, {0}}};
+};
+
+}  // namespace bdm
+
+#endif  // CORE_UTIL_CYLINDER_INTERACTION_COUNTER_H_
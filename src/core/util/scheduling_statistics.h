@@ -0,0 +1,43 @@
+// -----------------------------------------------------------------------------
+//
+// Copyright (C) The BioDynaMo Project.
+// All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+//
+// See the LICENSE file distributed with this work for details.
+// See the NOTICE file distributed with this work for additional information
+// regarding copyright ownership.
+//
+// -----------------------------------------------------------------------------
+
+#ifndef CORE_UTIL_SCHEDULING_STATISTICS_H_
+#define CORE_UTIL_SCHEDULING_STATISTICS_H_
+
+#include <cstdint>
+
+namespace bdm {
+
+/// Measurements of one NUMA node gathered during one call to
+/// `ResourceManager::ApplyOnAllElementsParallelDynamic`
+struct SchedulingStatistics {
+  /// Number of sim objects of this NUMA node
+  uint64_t num_sim_objects = 0;
+  /// Number of batches of this NUMA node
+  uint64_t batches = 0;
+  /// Number of batches that were processed by a thread other than the one
+  /// they were initially assigned to (work stealing)
+  uint64_t stolen_batches = 0;
+  /// Time in ns until the last batch of this NUMA node was processed
+  int64_t runtime = 0;
+
+  /// Fraction of batches that have been stolen
+  double GetStealRate() const {
+    return batches == 0 ? 0 : static_cast<double>(stolen_batches) / batches;
+  }
+};
+
+}  // namespace bdm
+
+#endif  // CORE_UTIL_SCHEDULING_STATISTICS_H_
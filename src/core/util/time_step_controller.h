@@ -0,0 +1,145 @@
+// -----------------------------------------------------------------------------
+//
+// Copyright (C) The BioDynaMo Project.
+// All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+//
+// See the LICENSE file distributed with this work for details.
+// See the NOTICE file distributed with this work for additional information
+// regarding copyright ownership.
+//
+// -----------------------------------------------------------------------------
+
+#ifndef CORE_UTIL_TIME_STEP_CONTROLLER_H_
+#define CORE_UTIL_TIME_STEP_CONTROLLER_H_
+
+#include <omp.h>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cmath>
+#include <vector>
+
+#include "core/util/thread_info.h"
+
+namespace bdm {
+
+/// Adapts the simulation time step to the mechanical interactions
+/// (see `Param::adaptive_time_step_`).\n
+/// The displacement operation reports the displacement of each simulation
+/// object. Afterwards, the largest displacement of the step determines the
+/// time step of the next one. Since displacements are proportional to the
+/// time step, the time step is scaled such that the largest displacement
+/// approaches `kTargetFraction * max_displacement`. The change per step is
+/// limited to a factor of two. If displacements were clipped at
+/// `max_displacement`, the time step is halved. The time step is only adapted
+/// in steps in which displacements have been observed. Steps without
+/// displacement calculation (e.g. `Operation::frequency_` > 1, or only
+/// static sim objects) keep the time step.\n
+/// Each thread records its displacements in its own slot. Threads with an id
+/// beyond the number of threads in `ThreadInfo` fall back to an atomic slot.
+class TimeStepController {
+ public:
+  TimeStepController()
+      : max_displacements_(ThreadInfo::GetInstance()->GetMaxThreads(),
+                           {{0}}) {}
+
+  /// Resets the displacements observed in the previous step
+  void StartStep() {
+    for (auto& el : max_displacements_) {
+      el[0] = 0;
+      el[1] = 0;
+    }
+    overflow_max_displacement_ = -1;
+  }
+
+  /// Records the displacement of one simulation object.
+  /// Can be called concurrently from different threads.
+  void ObserveDisplacement(double squared_norm) {
+    auto tid = static_cast<uint64_t>(omp_get_thread_num());
+    if (tid >= max_displacements_.size()) {
+      auto max = overflow_max_displacement_.load();
+      while (squared_norm > max &&
+             !overflow_max_displacement_.compare_exchange_weak(max,
+                                                               squared_norm)) {
+      }
+      return;
+    }
+    auto& max = max_displacements_[tid][0];
+    if (squared_norm > max) {
+      max = squared_norm;
+    }
+    max_displacements_[tid][1] = 1;
+  }
+
+  /// Returns true if a displacement has been observed since the last call to
+  /// `StartStep`
+  bool HasObservations() const {
+    if (overflow_max_displacement_ >= 0) {
+      return true;
+    }
+    for (auto& el : max_displacements_) {
+      if (el[1] != 0) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  /// Returns the largest displacement that has been observed since the last
+  /// call to `StartStep`
+  double GetMaxDisplacement() const {
+    double max = std::max(0.0, overflow_max_displacement_.load());
+    for (auto& el : max_displacements_) {
+      max = std::max(max, el[0]);
+    }
+    return std::sqrt(max);
+  }
+
+  /// Returns the time step for the next simulation step. Returns `time_step`
+  /// if no displacement has been observed.
+  /// @param time_step time step of the step that has just been simulated
+  /// @param max_displacement upper bound of the displacement per step
+  ///        (`Param::simulation_max_displacement_`)
+  /// @param min_time_step, max_time_step bounds of the returned time step
+  double GetNextTimeStep(double time_step, double max_displacement,
+                         double min_time_step, double max_time_step) const {
+    if (!HasObservations()) {
+      return time_step;
+    }
+    double observed = GetMaxDisplacement();
+    double factor = kMaxGrowth;
+    if (observed >= max_displacement * (1 - 1e-9)) {
+      // displacements have been clipped
+      factor = 0.5;
+    } else if (observed > 0) {
+      factor = kTargetFraction * max_displacement / observed;
+    }
+    // avoid odr-use of kMaxGrowth in std::min
+    const double max_growth = kMaxGrowth;
+    factor = std::max(0.5, std::min(max_growth, factor));
+    return std::max(min_time_step, std::min(max_time_step, time_step * factor));
+  }
+
+ private:
+  /// Largest displacement of the next step relative to the maximum
+  /// displacement the time step aims for
+  static constexpr double kTargetFraction = 0.5;
+  /// Maximum increase of the time step from one step to the next
+  static constexpr double kMaxGrowth = 2;
+
+  /// Largest squared displacement per thread (element 0) and whether a
+  /// displacement has been observed (element 1) - padded to avoid false
+  /// sharing (assumes 64 byte cache lines)
+  std::vector<std::array<double, 8>> max_displacements_;
+  /// Largest squared displacement of threads without a slot in
+  /// `max_displacements_`; negative if none has been observed
+  std::atomic<double> overflow_max_displacement_{-1};
+};
+
+}  // namespace bdm
+
+#endif  // CORE_UTIL_TIME_STEP_CONTROLLER_H_
@@ -61,6 +61,13 @@ inline std::ostream& operator<<(std::ostream& os, const TimingAggregator& ta) {
   } else {
     os << "No statistics were gathered!" << std::endl;
   }
+
+  if (ta.descriptions_.size() != 0) {
+    os << std::endl;
+    for (auto& description : ta.descriptions_) {
+      os << description << std::endl;
+    }
+  }
   return os;
 }
 }  // namespace bdm
@@ -15,6 +15,7 @@
 #ifndef CORE_UTIL_TYPE_H_
 #define CORE_UTIL_TYPE_H_
 
+#include <cassert>
 #include <type_traits>
 #include <typeinfo>
 #include "core/shape.h"
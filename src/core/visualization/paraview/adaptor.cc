@@ -16,7 +16,10 @@
 #include "core/visualization/paraview/helper.h"
 #include "core/visualization/paraview/insitu_pipeline.h"
 
+#include <omp.h>
+#include <algorithm>
 #include <cstdlib>
+#include <future>
 
 #ifndef __ROOTCLING__
 
@@ -39,12 +42,41 @@
 
 namespace bdm {
 
+/// Returns the size of the values that `grid` stores (see
+/// `DiffusionGrid::SetSinglePrecision`)
+static uint64_t GetValueSize(const DiffusionGrid* grid) {
+  return grid->IsSinglePrecision() ? sizeof(float) : sizeof(double);
+}
+
+/// Returns the concentrations of `grid` in its storage type
+static const void* GetConcentrations(const DiffusionGrid* grid) {
+  if (grid->IsSinglePrecision()) {
+    return grid->GetAllConcentrations<float>();
+  }
+  return grid->GetAllConcentrations();
+}
+
+/// Returns the gradients of `grid` in its storage type
+static const void* GetGradients(const DiffusionGrid* grid) {
+  if (grid->IsSinglePrecision()) {
+    return grid->GetAllGradients<float>();
+  }
+  return grid->GetAllGradients();
+}
+
 struct ParaviewAdaptor::ParaviewImpl {
   vtkCPProcessor* g_processor_ = nullptr;
   std::unordered_map<std::string, VtkSoGrid*> vtk_so_grids_;
   std::unordered_map<std::string, VtkDiffusionGrid*> vtk_dgrids_;
   InSituPipeline* pipeline_ = nullptr;
   vtkCPDataDescription* data_description_ = nullptr;
+  /// Staging buffer for asynchronous export. One entry per thread, which maps
+  /// simulation object type names to the extracted data members.
+  std::vector<std::unordered_map<std::string, StagedSimObjects>>
+      staged_sim_objects_;
+  std::unordered_map<std::string, StagedDiffusionGrid> staged_dgrids_;
+  /// Asynchronous export that is currently in progress
+  std::future<void> pending_export_;
 };
 
 std::atomic<uint64_t> ParaviewAdaptor::counter_;
@@ -61,6 +93,8 @@ ParaviewAdaptor::~ParaviewAdaptor() {
   counter_--;
 
   if (impl_) {
+    WaitForExport();
+
     if (impl_->pipeline_) {
       impl_->g_processor_->RemovePipeline(impl_->pipeline_);
       impl_->pipeline_->Delete();
@@ -101,12 +135,11 @@ void ParaviewAdaptor::Visualize() {
     return;
   }
 
+  double time = sim->GetScheduler()->GetSimulatedTime();
   if (param->live_visualization_) {
-    double time = param->simulation_time_step_ * total_steps;
     LiveVisualization(time, total_steps);
   }
   if (param->export_visualization_) {
-    double time = param->simulation_time_step_ * total_steps;
     ExportVisualization(time, total_steps);
   }
 }
@@ -189,6 +222,12 @@ void ParaviewAdaptor::LiveVisualization(double time, size_t step) {
 /// @param[in]  last_time_step  The last time step
 ///
 void ParaviewAdaptor::ExportVisualization(double time, size_t step) {
+  auto* param = Simulation::GetActive()->GetParam();
+  if (exclusive_export_viz_ && param->visualization_export_async_) {
+    ExportVisualizationAsync(step);
+    return;
+  }
+
   if (impl_->data_description_ == nullptr) {
     impl_->data_description_ = vtkCPDataDescription::New();
   } else {
@@ -201,6 +240,199 @@ void ParaviewAdaptor::ExportVisualization(double time, size_t step) {
   WriteToFile(step);
 }
 
+void ParaviewAdaptor::ExportVisualizationAsync(size_t step) {
+  // the export thread must have finished using the staging buffer and the
+  // VTK structures
+  WaitForExport();
+
+  StageSimObjects();
+  StageDiffusionGrids();
+
+  auto output_dir = Simulation::GetActive()->GetOutputDir();
+  impl_->pending_export_ =
+      std::async(std::launch::async, [this, output_dir, step]() {
+        BuildVtkStructuresFromStagingBuffer();
+        WriteToFile(output_dir, step);
+      });
+}
+
+void ParaviewAdaptor::WaitForExport() {
+  if (impl_->pending_export_.valid()) {
+    impl_->pending_export_.get();
+  }
+}
+
+void ParaviewAdaptor::StageSimObjects() {
+  auto* sim = Simulation::GetActive();
+  auto* param = sim->GetParam();
+  auto& staged = impl_->staged_sim_objects_;
+
+  // reset staging buffer, but keep allocated memory
+  staged.resize(omp_get_max_threads());
+  for (auto& thread_staged : staged) {
+    for (auto& el : thread_staged) {
+      el.second.representative_ = nullptr;
+      for (auto& dm : el.second.data_members_) {
+        dm.second.doubles_.clear();
+        dm.second.ints_.clear();
+      }
+    }
+  }
+
+  auto* rm = sim->GetResourceManager();
+  rm->ApplyOnAllElementsParallel([&](SimObject* so) {
+    auto so_name = so->GetTypeName();
+    if (param->visualize_sim_objects_.find(so_name) ==
+        param->visualize_sim_objects_.end()) {
+      return;
+    }
+    auto& type_staged = staged[omp_get_thread_num()][so_name];
+    if (type_staged.representative_ == nullptr) {
+      type_staged.representative_ = so;
+      if (type_staged.vis_data_members_.empty()) {
+        type_staged.vis_data_members_ = VtkSoGrid::GetVisDataMembers(so);
+      }
+    }
+    StagingSoVisitor visitor(&type_staged);
+    so->ForEachDataMemberIn(type_staged.vis_data_members_, &visitor);
+  });
+
+  // initialize the VTK structures of newly visualized types
+  for (auto& thread_staged : staged) {
+    for (auto& el : thread_staged) {
+      auto* vsg = impl_->vtk_so_grids_[el.first];
+      if (!vsg->initialized_ && el.second.representative_ != nullptr) {
+        vsg->Init(el.second.representative_);
+      }
+    }
+  }
+}
+
+void ParaviewAdaptor::StageDiffusionGrids() {
+  auto* sim = Simulation::GetActive();
+  auto* param = sim->GetParam();
+  auto* rm = sim->GetResourceManager();
+
+  rm->ApplyOnAllDiffusionGrids([&](DiffusionGrid* grid) {
+    const auto& name = grid->GetSubstanceName();
+    bool visualize = false;
+    for (auto& entry : param->visualize_diffusion_) {
+      visualize |= entry.name_ == name;
+    }
+    if (!visualize) {
+      return;
+    }
+
+    auto* vdg = impl_->vtk_dgrids_[name];
+    if (!vdg->used_ || vdg->single_precision_ != grid->IsSinglePrecision()) {
+      vdg->Init(grid->IsSinglePrecision());
+    }
+
+    auto& staged = impl_->staged_dgrids_[name];
+    auto grid_dimensions = grid->GetDimensions();
+    auto num_boxes = grid->GetNumBoxesArray();
+    auto total_boxes = grid->GetNumBoxes();
+    for (int i = 0; i < 3; i++) {
+      staged.origin_[i] = grid_dimensions[2 * i];
+      staged.dimensions_[i] = num_boxes[i];
+    }
+    staged.spacing_ = grid->GetBoxLength();
+    staged.num_boxes_ = total_boxes;
+    const uint64_t bytes = total_boxes * GetValueSize(grid);
+    if (vdg->concentration_) {
+      auto* co_ptr = static_cast<const char*>(GetConcentrations(grid));
+      staged.concentrations_.assign(co_ptr, co_ptr + bytes);
+    }
+    if (vdg->gradient_) {
+      auto* gr_ptr = static_cast<const char*>(GetGradients(grid));
+      staged.gradients_.assign(gr_ptr, gr_ptr + bytes * 3);
+    }
+  });
+}
+
+void ParaviewAdaptor::BuildVtkStructuresFromStagingBuffer() {
+  auto& staged = impl_->staged_sim_objects_;
+
+  // simulation objects
+  for (auto& el : impl_->vtk_so_grids_) {
+    auto* vsg = el.second;
+    if (!vsg->initialized_) {
+      continue;
+    }
+
+    for (auto& dm_name : vsg->vis_data_members_) {
+      // collect the staged values of all threads
+      std::vector<const StagedDataMember*> parts;
+      uint64_t num_tuples = 0;
+      for (auto& thread_staged : staged) {
+        auto type_search = thread_staged.find(el.first);
+        if (type_search == thread_staged.end()) {
+          continue;
+        }
+        auto& data_members = type_search->second.data_members_;
+        auto dm_search = data_members.find(dm_name);
+        if (dm_search != data_members.end()) {
+          parts.push_back(&dm_search->second);
+          num_tuples += dm_search->second.GetNumberOfTuples();
+        }
+      }
+
+      vtkDataArray* vtk_array = nullptr;
+      auto array_search = vsg->data_arrays_.find(dm_name);
+      if (array_search != vsg->data_arrays_.end()) {
+        vtk_array = array_search->second.data_;
+      } else if (!parts.empty()) {
+        vtk_array = CreateVtkDataArray(dm_name, vsg, parts[0]->is_double_,
+                                       parts[0]->components_);
+      } else {
+        continue;
+      }
+
+      vtk_array->SetNumberOfTuples(num_tuples);
+      if (num_tuples == 0) {
+        continue;
+      }
+      uint64_t offset = 0;
+      if (parts[0]->is_double_) {
+        auto* dest = static_cast<vtkDoubleArray*>(vtk_array)->GetPointer(0);
+        for (auto* part : parts) {
+          std::copy(part->doubles_.begin(), part->doubles_.end(),
+                    dest + offset);
+          offset += part->doubles_.size();
+        }
+      } else {
+        auto* dest = static_cast<vtkIntArray*>(vtk_array)->GetPointer(0);
+        for (auto* part : parts) {
+          std::copy(part->ints_.begin(), part->ints_.end(), dest + offset);
+          offset += part->ints_.size();
+        }
+      }
+    }
+  }
+
+  // diffusion grids
+  for (auto& el : impl_->staged_dgrids_) {
+    auto* vdg = impl_->vtk_dgrids_[el.first];
+    auto& sdg = el.second;
+    vdg->data_->SetOrigin(sdg.origin_[0], sdg.origin_[1], sdg.origin_[2]);
+    vdg->data_->SetDimensions(sdg.dimensions_[0], sdg.dimensions_[1],
+                              sdg.dimensions_[2]);
+    vdg->data_->SetSpacing(sdg.spacing_, sdg.spacing_, sdg.spacing_);
+    // the staging buffer is not modified before the next call to
+    // `WaitForExport`. Therefore, VTK can use it without copying.
+    if (vdg->concentration_) {
+      vdg->concentration_->SetVoidArray(
+          sdg.concentrations_.data(), static_cast<vtkIdType>(sdg.num_boxes_),
+          1);
+    }
+    if (vdg->gradient_) {
+      vdg->gradient_->SetVoidArray(sdg.gradients_.data(),
+                                   static_cast<vtkIdType>(sdg.num_boxes_ * 3),
+                                   1);
+    }
+  }
+}
+
 void ParaviewAdaptor::CreateVtkObjects() {
   BuildSimObjectsVTKStructures();
   BuildDiffusionGridVTKStructures();
@@ -256,8 +488,8 @@ void ParaviewAdaptor::ProcessDiffusionGrid(const DiffusionGrid* grid) {
 
   if (vd != nullptr) {
     auto* vdg = impl_->vtk_dgrids_[grid->GetSubstanceName()];
-    if (!vdg->used_) {
-      vdg->Init();
+    if (!vdg->used_ || vdg->single_precision_ != grid->IsSinglePrecision()) {
+      vdg->Init(grid->IsSinglePrecision());
     }
 
     // If we segfault at here it probably means that there is a problem
@@ -280,14 +512,14 @@ void ParaviewAdaptor::ProcessDiffusionGrid(const DiffusionGrid* grid) {
       vdg->data_->SetSpacing(box_length, box_length, box_length);
 
       if (vdg->concentration_) {
-        auto* co_ptr = const_cast<double*>(grid->GetAllConcentrations());
-        vdg->concentration_->SetArray(co_ptr,
-                                      static_cast<vtkIdType>(total_boxes), 1);
+        auto* co_ptr = const_cast<void*>(GetConcentrations(grid));
+        vdg->concentration_->SetVoidArray(
+            co_ptr, static_cast<vtkIdType>(total_boxes), 1);
       }
       if (vdg->gradient_) {
-        auto gr_ptr = const_cast<double*>(grid->GetAllGradients());
-        vdg->gradient_->SetArray(gr_ptr,
-                                 static_cast<vtkIdType>(total_boxes * 3), 1);
+        auto* gr_ptr = const_cast<void*>(GetGradients(grid));
+        vdg->gradient_->SetVoidArray(
+            gr_ptr, static_cast<vtkIdType>(total_boxes * 3), 1);
       }
     }
   }
@@ -301,11 +533,15 @@ void ParaviewAdaptor::BuildDiffusionGridVTKStructures() {
 }
 
 void ParaviewAdaptor::WriteToFile(size_t step) {
-  auto* sim = Simulation::GetActive();
+  WriteToFile(Simulation::GetActive()->GetOutputDir(), step);
+}
+
+void ParaviewAdaptor::WriteToFile(const std::string& output_dir,
+                                  size_t step) {
   for (auto& el : impl_->vtk_so_grids_) {
     vtkNew<vtkXMLPUnstructuredGridWriter> cells_writer;
     auto filename =
-        Concat(sim->GetOutputDir(), "/", el.second->name_, "-", step, ".pvtu");
+        Concat(output_dir, "/", el.second->name_, "-", step, ".pvtu");
     cells_writer->SetFileName(filename.c_str());
     cells_writer->SetInputData(el.second->data_);
     cells_writer->Update();
@@ -315,8 +551,7 @@ void ParaviewAdaptor::WriteToFile(size_t step) {
     vtkNew<vtkXMLPImageDataWriter> dgrid_writer;
 
     const auto& substance_name = entry.second->name_;
-    auto filename =
-        Concat(sim->GetOutputDir(), "/", substance_name, "-", step, ".pvti");
+    auto filename = Concat(output_dir, "/", substance_name, "-", step, ".pvti");
     dgrid_writer->SetFileName(filename.c_str());
     dgrid_writer->SetInputData(entry.second->data_);
     dgrid_writer->Update();
@@ -61,6 +61,7 @@ class ParaviewAdaptor : VisualizationAdaptor {
 
   friend class ParaviewAdaptorTest_GenerateSimulationInfoJson_Test;
   friend class ParaviewAdaptorTest_GenerateParaviewState_Test;
+  friend class ParaviewAdaptorTest_ExportVisualizationAsync_Test;
   friend class ParaviewAdaptorTest_DISABLED_CheckVisualizationSelection_Test;
   friend class DISABLED_DiffusionTest_ModelInitializer_Test;
 
@@ -86,6 +87,25 @@ class ParaviewAdaptor : VisualizationAdaptor {
   ///
   void ExportVisualization(double time, size_t step);
 
+  /// Pipelined version of `ExportVisualization` (see
+  /// `Param::visualization_export_async_`). Copies the visualized data into a
+  /// staging buffer and builds and writes the VTK structures on a separate
+  /// thread. Returns before the files have been written.
+  void ExportVisualizationAsync(size_t step);
+
+  /// Blocks until the previous asynchronous export has been finished.
+  void WaitForExport();
+
+  /// Copies the visualized data members of all simulation objects into the
+  /// staging buffer in parallel.
+  void StageSimObjects();
+
+  /// Copies the visualized diffusion grids into the staging buffer.
+  void StageDiffusionGrids();
+
+  /// Fills the VTK structures with the content of the staging buffer.
+  void BuildVtkStructuresFromStagingBuffer();
+
   /// Creates the VTK objects that represent the simulation objects in ParaView.
   ///
   /// @param      data_description  The data description
@@ -120,6 +140,10 @@ class ParaviewAdaptor : VisualizationAdaptor {
   ///
   void WriteToFile(size_t step);
 
+  /// Same as `WriteToFile(step)`, but writes the files to `output_dir`. Does
+  /// not access the active simulation.
+  void WriteToFile(const std::string& output_dir, size_t step);
+
   /// This function generates the Paraview state based on the exported files
   /// Therefore, the user can load the visualization simply by opening the pvsm
   /// file and does not have to perform a lot of manual steps.
@@ -19,9 +19,11 @@
 // detail when using ROOT I/O
 #ifndef __ROOTCLING__
 
+#include <array>
 #include <set>
 #include <string>
 #include <unordered_map>
+#include <vector>
 #include "core/param/param.h"
 #include "core/shape.h"
 #include "core/sim_object/sim_object.h"
@@ -30,6 +32,7 @@
 #include <vtkCPDataDescription.h>
 #include <vtkCPInputDataDescription.h>
 #include <vtkDoubleArray.h>
+#include <vtkFloatArray.h>
 #include <vtkImageData.h>
 #include <vtkIntArray.h>
 #include <vtkNew.h>
@@ -70,16 +73,22 @@ struct VtkSoGrid {
   }
 
   void Init(const SimObject* so) {
-    auto type_name = so->GetTypeName();
-    vis_data_members_ = so->GetRequiredVisDataMembers();
-    auto* param = Simulation::GetActive()->GetParam();
-    for (auto& dm : param->visualize_sim_objects_.at(type_name)) {
-      vis_data_members_.insert(dm);
-    }
+    vis_data_members_ = GetVisDataMembers(so);
     shape_ = so->GetShape();
     initialized_ = true;
   }
 
+  /// Returns the data members of `so` that are required for visualization
+  /// and the ones that have been selected in `Param::visualize_sim_objects_`.
+  static std::set<std::string> GetVisDataMembers(const SimObject* so) {
+    auto data_members = so->GetRequiredVisDataMembers();
+    auto* param = Simulation::GetActive()->GetParam();
+    for (auto& dm : param->visualize_sim_objects_.at(so->GetTypeName())) {
+      data_members.insert(dm);
+    }
+    return data_members;
+  }
+
   bool initialized_ = false;
   std::string name_;
   vtkUnstructuredGrid* data_ = nullptr;
@@ -107,20 +116,9 @@ struct VtkDiffusionGrid {
       }
     }
 
-    // Add attribute data
-    if (vd->concentration_) {
-      vtkNew<vtkDoubleArray> concentration;
-      concentration->SetName("Substance Concentration");
-      concentration_ = concentration.GetPointer();
-      data_->GetPointData()->AddArray(concentration.GetPointer());
-    }
-    if (vd->gradient_) {
-      vtkNew<vtkDoubleArray> gradient;
-      gradient->SetName("Diffusion Gradient");
-      gradient->SetNumberOfComponents(3);
-      gradient_ = gradient.GetPointer();
-      data_->GetPointData()->AddArray(gradient.GetPointer());
-    }
+    // attribute data is added in `Init`
+    visualize_concentration_ = vd->concentration_;
+    visualize_gradient_ = vd->gradient_;
 
     data_description->AddInput(name.c_str());
     data_description->GetInputDescriptionByName(name.c_str())->SetGrid(data_);
@@ -134,13 +132,86 @@ struct VtkDiffusionGrid {
     gradient_ = nullptr;
   }
 
-  void Init() { used_ = true; }
+  /// Adds the attribute data for a diffusion grid with the given storage
+  /// type. Concentrations and gradients of single precision diffusion grids
+  /// are exported as `vtkFloatArray` (see
+  /// `DiffusionGrid::SetSinglePrecision`). Replaces existing arrays if
+  /// called again.
+  void Init(bool single_precision) {
+    used_ = true;
+    single_precision_ = single_precision;
+    if (visualize_concentration_) {
+      concentration_ = AddArray("Substance Concentration", 1);
+    }
+    if (visualize_gradient_) {
+      gradient_ = AddArray("Diffusion Gradient", 3);
+    }
+  }
 
   bool used_ = false;
   std::string name_;
   vtkImageData* data_ = nullptr;
-  vtkDoubleArray* concentration_ = nullptr;
-  vtkDoubleArray* gradient_ = nullptr;
+  /// `vtkFloatArray` if `single_precision_`; `vtkDoubleArray` otherwise
+  vtkDataArray* concentration_ = nullptr;
+  vtkDataArray* gradient_ = nullptr;
+  bool single_precision_ = false;
+
+ private:
+  bool visualize_concentration_ = false;
+  bool visualize_gradient_ = false;
+
+  vtkDataArray* AddArray(const char* name, int components) {
+    vtkDataArray* array = nullptr;
+    if (single_precision_) {
+      array = vtkFloatArray::New();
+    } else {
+      array = vtkDoubleArray::New();
+    }
+    array->SetName(name);
+    array->SetNumberOfComponents(components);
+    data_->GetPointData()->RemoveArray(name);
+    data_->GetPointData()->AddArray(array);
+    // the point data holds a reference
+    array->Delete();
+    return array;
+  }
+};
+
+/// Values of one data member that have been copied from simulation objects
+/// for asynchronous export.
+struct StagedDataMember {
+  /// `true` for `double` and `Double3` data members; `false` for integer
+  /// data members, which are stored as `int` (see `ParaviewSoVisitor`)
+  bool is_double_ = true;
+  int components_ = 1;
+  std::vector<double> doubles_;
+  std::vector<int> ints_;
+
+  uint64_t GetNumberOfTuples() const {
+    auto size = is_double_ ? doubles_.size() : ints_.size();
+    return size / components_;
+  }
+};
+
+/// Visualized data members of all simulation objects of one type that have
+/// been processed by one thread.
+struct StagedSimObjects {
+  /// One simulation object of this type; used to initialize the `VtkSoGrid`
+  const SimObject* representative_ = nullptr;
+  std::set<std::string> vis_data_members_;
+  std::unordered_map<std::string, StagedDataMember> data_members_;
+};
+
+/// Copy of a diffusion grid for asynchronous export.
+struct StagedDiffusionGrid {
+  std::array<double, 3> origin_;
+  std::array<uint32_t, 3> dimensions_;
+  double spacing_;
+  /// Copies of the concentrations and gradients in the storage type of the
+  /// diffusion grid (see `DiffusionGrid::IsSinglePrecision`)
+  std::vector<char> concentrations_;
+  std::vector<char> gradients_;
+  uint64_t num_boxes_ = 0;
 };
 
 /// If the user selects the visualiation option export, we need to pass the
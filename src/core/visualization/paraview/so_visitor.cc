@@ -15,6 +15,7 @@
 #ifndef __ROOTCLING__
 
 #include <string>
+#include <type_traits>
 
 #include "core/visualization/paraview/helper.h"
 #include "core/visualization/paraview/so_visitor.h"
@@ -30,15 +31,48 @@ struct ParaviewSoVisitor::ParaviewImpl {
   VtkSoGrid* so_grid_;
 };
 
+vtkDataArray* CreateVtkDataArray(const std::string& dm_name,
+                                 VtkSoGrid* so_grid, bool is_double,
+                                 int components) {
+  vtkDataArray* vtk_array = nullptr;
+  if (is_double) {
+    vtk_array = vtkDoubleArray::New();
+  } else {
+    vtk_array = vtkIntArray::New();
+  }
+  vtk_array->SetName(dm_name.c_str());
+  vtk_array->SetNumberOfComponents(components);
+  so_grid->data_arrays_.insert({dm_name, VtkDataArrayWrapper(vtk_array)});
+
+  auto* point_data = so_grid->data_->GetPointData();
+  if (is_double && components == 3 &&
+      dm_name == "position_") {  // TODO(lukas) performance
+    vtkNew<vtkPoints> points;
+    points->SetData(vtk_array);
+    so_grid->data_->SetPoints(points.GetPointer());
+  } else if (is_double && components == 3 && dm_name == "mass_location_") {
+    // create points with position {0, 0, 0}
+    // BDMGlyph will rotate and translate based on the attribute data
+    vtkNew<vtkPoints> points;
+    points->SetData(vtk_array);
+    so_grid->data_->SetPoints(points.GetPointer());
+    point_data->AddArray(vtk_array);
+  } else {
+    point_data->AddArray(vtk_array);
+  }
+  // ownership has been transferred to the points or point data
+  vtk_array->Delete();
+  return vtk_array;
+}
+
 template <typename TDataArray>
 TDataArray* GetDataArray(const std::string& dm_name, VtkSoGrid* so_grid,
                          int components = 1) {
-  TDataArray* vtk_array = nullptr;
   auto& data_arrays = so_grid->data_arrays_;
   auto search = data_arrays.find(dm_name);
   if (search != data_arrays.end()) {
     auto& da_wrapper = search->second;
-    vtk_array = static_cast<TDataArray*>(da_wrapper.data_);
+    auto* vtk_array = static_cast<TDataArray*>(da_wrapper.data_);
 
     // reset
     auto* scheduler = Simulation::GetActive()->GetScheduler();
@@ -46,61 +80,18 @@ TDataArray* GetDataArray(const std::string& dm_name, VtkSoGrid* so_grid,
       vtk_array->Reset();
       da_wrapper.time_step_ = scheduler->GetSimulatedSteps();
     }
-
-  } else {
-    // create
-    vtkNew<TDataArray> new_vtk_array;
-    new_vtk_array->SetName(dm_name.c_str());
-    vtk_array = new_vtk_array.GetPointer();
-    vtk_array->SetNumberOfComponents(components);
-    auto* point_data = so_grid->data_->GetPointData();
-    point_data->AddArray(vtk_array);
-    data_arrays.insert({dm_name, VtkDataArrayWrapper(vtk_array)});
+    return vtk_array;
   }
 
-  return vtk_array;
+  // create
+  bool is_double = std::is_same<TDataArray, vtkDoubleArray>::value;
+  return static_cast<TDataArray*>(
+      CreateVtkDataArray(dm_name, so_grid, is_double, components));
 }
 
 vtkDoubleArray* GetDouble3Array(const std::string& dm_name,
                                 VtkSoGrid* so_grid) {
-  vtkDoubleArray* vtk_array = nullptr;
-  auto& data_arrays = so_grid->data_arrays_;
-  auto search = data_arrays.find(dm_name);
-  if (search != data_arrays.end()) {
-    auto& da_wrapper = search->second;
-    vtk_array = static_cast<vtkDoubleArray*>(da_wrapper.data_);
-
-    // reset
-    auto* scheduler = Simulation::GetActive()->GetScheduler();
-    if (da_wrapper.time_step_ != scheduler->GetSimulatedSteps()) {
-      vtk_array->Reset();
-      da_wrapper.time_step_ = scheduler->GetSimulatedSteps();
-    }
-
-  } else {
-    // create
-    vtkNew<vtkDoubleArray> new_vtk_array;
-    new_vtk_array->SetName(dm_name.c_str());
-    vtk_array = new_vtk_array.GetPointer();
-    vtk_array->SetNumberOfComponents(3);
-    data_arrays.insert({dm_name, VtkDataArrayWrapper(vtk_array)});
-    if (dm_name == "position_") {  // TODO(lukas) performance
-      vtkNew<vtkPoints> points;
-      points->SetData(vtk_array);
-      so_grid->data_->SetPoints(points.GetPointer());
-    } else if (dm_name == "mass_location_") {
-      // create points with position {0, 0, 0}
-      // BDMGlyph will rotate and translate based on the attribute data
-      vtkNew<vtkPoints> points;
-      points->SetData(vtk_array);
-      so_grid->data_->SetPoints(points.GetPointer());
-      so_grid->data_->GetPointData()->AddArray(vtk_array);
-    } else {
-      so_grid->data_->GetPointData()->AddArray(vtk_array);
-    }
-  }
-
-  return vtk_array;
+  return GetDataArray<vtkDoubleArray>(dm_name, so_grid, 3);
 }
 
 ParaviewSoVisitor::ParaviewSoVisitor(VtkSoGrid* so_grid) {
@@ -160,6 +151,44 @@ void ParaviewSoVisitor::Int3(const std::string& dm_name, const void* d) {
   vtk_array->InsertNextTuple3(data[0], data[1], data[2]);
 }
 
+void StagingSoVisitor::Visit(const std::string& dm_name,
+                             size_t type_hash_code, const void* data) {
+  if (type_hash_code == typeid(double).hash_code()) {
+    auto* staged = GetStagedDataMember(dm_name, true, 1);
+    staged->doubles_.push_back(*reinterpret_cast<const double*>(data));
+  } else if (type_hash_code == typeid(int).hash_code()) {
+    auto* staged = GetStagedDataMember(dm_name, false, 1);
+    staged->ints_.push_back(*reinterpret_cast<const int*>(data));
+  } else if (type_hash_code == typeid(uint64_t).hash_code()) {
+    auto* staged = GetStagedDataMember(dm_name, false, 1);
+    staged->ints_.push_back(*reinterpret_cast<const uint64_t*>(data));
+  } else if (type_hash_code == typeid(Double3).hash_code()) {
+    auto& d3 = *reinterpret_cast<const Double3*>(data);
+    auto* staged = GetStagedDataMember(dm_name, true, 3);
+    staged->doubles_.insert(staged->doubles_.end(), {d3[0], d3[1], d3[2]});
+  } else if (type_hash_code == typeid(std::array<int, 3>).hash_code()) {
+    auto& i3 = *reinterpret_cast<const std::array<int, 3>*>(data);
+    auto* staged = GetStagedDataMember(dm_name, false, 3);
+    staged->ints_.insert(staged->ints_.end(), {i3[0], i3[1], i3[2]});
+  } else {
+    Log::Fatal("StagingSoVisitor::Visit",
+               "This data member is not supported for visualization");
+  }
+}
+
+StagedDataMember* StagingSoVisitor::GetStagedDataMember(
+    const std::string& dm_name, bool is_double, int components) {
+  auto& data_members = staged_->data_members_;
+  auto search = data_members.find(dm_name);
+  if (search != data_members.end()) {
+    return &search->second;
+  }
+  auto& staged = data_members[dm_name];
+  staged.is_double_ = is_double;
+  staged.components_ = components;
+  return &staged;
+}
+
 }  // namespace bdm
 
 #endif  // ifndef __ROOTCLING__
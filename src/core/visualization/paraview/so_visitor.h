@@ -29,6 +29,13 @@
 
 namespace bdm {
 
+/// Creates a vtk data array for data member `dm_name` and adds it to
+/// `so_grid`. Double3 data members named `position_` or `mass_location_`
+/// become the points of the unstructured grid.
+vtkDataArray* CreateVtkDataArray(const std::string& dm_name,
+                                 VtkSoGrid* so_grid, bool is_double,
+                                 int components);
+
 /// This simulation object visitor is used to extract data from simulation
 /// objects. It also creates the required vtk data structures and resets them
 /// at the beginning of each iteration.
@@ -56,6 +63,28 @@ class ParaviewSoVisitor : public SoVisitor {
   std::unique_ptr<ParaviewImpl> impl_;
 };
 
+/// This simulation object visitor copies the visualized data members of
+/// simulation objects into a staging buffer. In contrast to
+/// `ParaviewSoVisitor` it does not modify vtk data structures. Therefore,
+/// multiple threads can extract data in parallel (one staging buffer per
+/// thread).
+class StagingSoVisitor : public SoVisitor {
+ public:
+  explicit StagingSoVisitor(StagedSimObjects* staged) : staged_(staged) {}
+  virtual ~StagingSoVisitor() {}
+
+  void Visit(const std::string& dm_name, size_t type_hash_code,
+             const void* data) override;
+
+ private:
+  StagedSimObjects* staged_;
+
+  /// Returns the staged data member `dm_name`. Creates it if it does not
+  /// exist yet.
+  StagedDataMember* GetStagedDataMember(const std::string& dm_name,
+                                        bool is_double, int components);
+};
+
 }  // namespace bdm
 
 #endif  // ifndef __ROOTCLING__
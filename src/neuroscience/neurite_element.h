@@ -21,6 +21,7 @@
 #include <vector>
 
 #include "core/default_force.h"
+#include "core/scheduler.h"
 #include "core/shape.h"
 #include "core/sim_object/sim_object.h"
 #include "core/util/log.h"
@@ -246,8 +247,9 @@ class NeuriteElement : public SimObject, public NeuronOrNeurite {
       return;
     }
     // scaling for integration step
-    auto* core_param = Simulation::GetActive()->GetParam();
-    speed *= core_param->simulation_time_step_;
+    auto* scheduler = Simulation::GetActive()->GetScheduler();
+    const double dt = scheduler->GetBiologyModuleTimeStep();
+    speed *= dt;
 
     auto* mother_soma = dynamic_cast<NeuronSoma*>(mother_.Get());
     auto* mother_neurite = dynamic_cast<NeuriteElement*>(mother_.Get());
@@ -276,7 +278,7 @@ class NeuriteElement : public SimObject, public NeuronOrNeurite {
       // if actual_length_ < length and mother is a neurite element with no
       // other daughter : merge with mother
       RemoveProximalNeuriteElement();  // also updates volume_...
-      RetractTerminalEnd(speed / core_param->simulation_time_step_);
+      RetractTerminalEnd(speed / dt);
     } else {
       // if mother is neurite element with other daughter or is not a neurite
       // segment: disappear.
@@ -557,8 +559,8 @@ class NeuriteElement : public SimObject, public NeuronOrNeurite {
     }
 
     // scaling for integration step
-    auto* core_param = Simulation::GetActive()->GetParam();
-    double length = speed * core_param->simulation_time_step_;
+    auto* scheduler = Simulation::GetActive()->GetScheduler();
+    double length = speed * scheduler->GetBiologyModuleTimeStep();
     auto dir = direction;
     auto displacement = dir.Normalize() * length;
     auto new_mass_location = displacement + mass_location_;
@@ -591,8 +593,8 @@ class NeuriteElement : public SimObject, public NeuronOrNeurite {
   /// @param speed cubic micron/ h
   void ChangeVolume(double speed) {
     // scaling for integration step
-    auto* core_param = Simulation::GetActive()->GetParam();
-    double delta = speed * core_param->simulation_time_step_;
+    auto* scheduler = Simulation::GetActive()->GetScheduler();
+    double delta = speed * scheduler->GetBiologyModuleTimeStep();
     volume_ += delta;
 
     if (volume_ <
@@ -606,8 +608,8 @@ class NeuriteElement : public SimObject, public NeuronOrNeurite {
   /// @param speed micron/ h
   void ChangeDiameter(double speed) {
     // scaling for integration step
-    auto* core_param = Simulation::GetActive()->GetParam();
-    double delta = speed * core_param->simulation_time_step_;
+    auto* scheduler = Simulation::GetActive()->GetScheduler();
+    double delta = speed * scheduler->GetBiologyModuleTimeStep();
     diameter_ += delta;
     UpdateVolume();
   }
@@ -617,6 +619,14 @@ class NeuriteElement : public SimObject, public NeuronOrNeurite {
   // ***************************************************************************
 
   Double3 CalculateDisplacement(double squared_radius, double dt) override {
+    return CalculateDisplacement(DefaultForce(), squared_radius, dt);
+  }
+
+  /// Calculates the displacement using the given force model.
+  /// \see DefaultForce, DisplacementOpCpu
+  template <typename TForce>
+  Double3 CalculateDisplacement(const TForce& force, double squared_radius,
+                                double dt) {
     Double3 force_on_my_point_mass{0, 0, 0};
     Double3 force_on_my_mothers_point_mass{0, 0, 0};
 
@@ -649,7 +659,7 @@ class NeuriteElement : public SimObject, public NeuronOrNeurite {
     // 3) Object avoidance force
     bool has_neurite_neighbor = false;
     //  (We check for every neighbor object if they touch us, i.e. push us away)
-    auto calculate_neighbor_forces = [this, &force_from_neighbors,
+    auto calculate_neighbor_forces = [this, &force, &force_from_neighbors,
                                       &force_on_my_mothers_point_mass,
                                       &h_over_m, &has_neurite_neighbor](
         const SimObject* neighbor) {
@@ -675,7 +685,6 @@ class NeuriteElement : public SimObject, public NeuronOrNeurite {
         }
       }
 
-      DefaultForce force;
       Double4 force_from_neighbor = force.GetForce(this, neighbor);
 
       // hack: if the neighbour is a neurite, we need to reduce the force from
@@ -16,6 +16,7 @@
 #include <typeinfo>
 #include "core/resource_manager.h"
 #include "gtest/gtest.h"
+#include "unit/test_util/test_sim_object.h"
 #include "unit/test_util/test_util.h"
 
 namespace bdm {
@@ -58,4 +59,11 @@ TEST(GrowDivideTest, Divide) {
   EXPECT_EQ(1u, rm->GetNumSimObjects());
 }
 
+TEST(GrowDivideTest, NotACell) {
+  Simulation simulation(TEST_NAME);
+  TestSimObject so;
+  GrowDivide gd(40, 300, {gAllEventIds});
+  ASSERT_DEATH(gd.Run(&so), ".*SimObject is not a Cell.*");
+}
+
 }  // namespace bdm
@@ -24,7 +24,10 @@ namespace bdm {
 namespace regulate_genes_test_internal {
 
 struct TestScheduler : public Scheduler {
-  void SetSimulationSteps(uint64_t total_steps) { total_steps_ = total_steps; }
+  void SetSimulationSteps(uint64_t total_steps) {
+    total_steps_ = total_steps;
+    simulated_time_ = total_steps * GetSimulationTimeStep();
+  }
 };
 
 TEST(RegulateGenesTest, EulerTest) {
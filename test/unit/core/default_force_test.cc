@@ -13,7 +13,9 @@
 // -----------------------------------------------------------------------------
 
 #include "core/default_force.h"
+#include "core/scheduler.h"
 #include "core/sim_object/cell.h"
+#include "core/util/cylinder_interaction_counter.h"
 #include "gtest/gtest.h"
 #include "neuroscience/module.h"
 #include "neuroscience/neurite_element.h"
@@ -84,6 +86,55 @@ TEST(DefaultForce, AllAtSamePositionSphere) {
   EXPECT_NEAR(0, result[2], 3);
 }
 
+/// Compares the batched sphere force kernel with the scalar reference
+TEST(DefaultForce, SphereForceAccumulator) {
+  // simulation object required for random number generator
+  Simulation simulation(TEST_NAME);
+  auto* random = simulation.GetRandom();
+
+  Double3 position = {10, 20, 30};
+  double diameter = 12;
+  // more neighbors than the batch size; includes non overlapping and
+  // coinciding neighbors
+  std::vector<Double3> positions;
+  std::vector<double> diameters;
+  for (uint64_t i = 0; i < 100; i++) {
+    positions.push_back(position + random->UniformArray<3>(-15, 15));
+    diameters.push_back(random->Uniform(5, 15));
+  }
+  positions[7] = position;
+  positions[70] = position;
+
+  // random forces of coinciding neighbors must be drawn in the same order
+  random->SetSeed(42);
+  Double3 expected = {0, 0, 0};
+  for (uint64_t i = 0; i < positions.size(); i++) {
+    Double3 force;
+    DefaultForce::ForceBetweenSpheres(position, diameter, positions[i],
+                                      diameters[i], &force);
+    expected += force;
+  }
+
+  random->SetSeed(42);
+  SphereForceAccumulator<true> reference(position, diameter);
+  for (uint64_t i = 0; i < positions.size(); i++) {
+    reference.Add(positions[i], diameters[i]);
+  }
+
+  random->SetSeed(42);
+  SphereForceAccumulator<> batched(position, diameter);
+  for (uint64_t i = 0; i < positions.size(); i++) {
+    batched.Add(positions[i], diameters[i]);
+  }
+
+  const auto& reference_force = reference.GetForce();
+  // reference mode reproduces the scalar version bitwise
+  for (int i = 0; i < 3; i++) {
+    EXPECT_EQ(expected[i], reference_force[i]);
+  }
+  EXPECT_ARR_NEAR(reference_force, batched.GetForce());
+}
+
 /// Tests the forces that are created between the reference sphere and its
 /// overlapping cylinder
 TEST(DISABLED_DefaultForce, GeneralSphereCylinder) {
@@ -219,6 +270,58 @@ TEST(DefaultForce, NotTouchingParallelCylinders) {
   EXPECT_NEAR(0.5, result[3], abs_error<double>::value);
 }
 
+TEST(DefaultForce, CylinderBoundingBoxRejection) {
+  experimental::neuroscience::InitModule();
+  auto set_param = [](Param* param) { param->statistics_ = true; };
+  Simulation simulation(TEST_NAME, set_param);
+  auto* counter = simulation.GetScheduler()->GetCylinderInteractionCounter();
+
+  NeuriteElement cylinder1;
+  cylinder1.SetMassLocation({0, 0, 0});
+  cylinder1.SetSpringAxis({-5, 0, 0});  // -> proximal end = {5, 0, 0}
+  cylinder1.SetDiameter(4);
+
+  // the bounding boxes are apart in y direction
+  NeuriteElement cylinder2;
+  cylinder2.SetMassLocation({0, -5.1, 0});
+  cylinder2.SetSpringAxis({-5, 0, 0});  // -> proximal end = {5, -5.1, 0}
+  cylinder2.SetDiameter(6);
+
+  // touches cylinder1 at its distal end
+  Cell sphere({-9.9, 0, 0});
+  sphere.SetDiameter(20);
+  // does not touch cylinder1
+  Cell far_sphere({0, 30, 0});
+  far_sphere.SetDiameter(20);
+
+  DefaultForce force;
+  EXPECT_ARR_NEAR4({0, 0, 0, 0}, force.GetForce(&cylinder1, &cylinder2));
+  EXPECT_ARR_NEAR4({0, 0, 0, 0}, force.GetForce(&cylinder1, &far_sphere));
+  EXPECT_ARR_NEAR4({0, 0, 0, 0}, force.GetForce(&far_sphere, &cylinder1));
+  auto result = force.GetForce(&cylinder1, &sphere);
+  EXPECT_GT(std::abs(result[0]), 0.01);
+
+  uint64_t rejected = 0;
+  uint64_t evaluated = 0;
+  counter->GetCounts(&rejected, &evaluated);
+  EXPECT_EQ(3u, rejected);
+  EXPECT_EQ(1u, evaluated);
+
+  counter->Reset();
+  counter->GetCounts(&rejected, &evaluated);
+  EXPECT_EQ(0u, rejected);
+  EXPECT_EQ(0u, evaluated);
+
+  // a new simulation starts with new counters, which are only populated if
+  // statistics are enabled
+  Simulation simulation2(TEST_NAME);
+  counter = simulation2.GetScheduler()->GetCylinderInteractionCounter();
+  EXPECT_ARR_NEAR4({0, 0, 0, 0}, force.GetForce(&cylinder1, &cylinder2));
+  counter->GetCounts(&rejected, &evaluated);
+  EXPECT_EQ(0u, rejected);
+  EXPECT_EQ(0u, evaluated);
+}
+
 // test I case of ForceOnACylinderFromASphere() function, ie if cylinder length
 // < sphere radius
 // sphere-cylinder interaction is done at the center and in the horizontal
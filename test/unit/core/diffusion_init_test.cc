@@ -12,6 +12,9 @@
 //
 // -----------------------------------------------------------------------------
 
+#include <array>
+#include <vector>
+
 #include "core/diffusion_grid.h"
 #include "core/grid.h"
 #include "core/model_initializer.h"
@@ -90,4 +93,58 @@ TEST(DiffusionInitTest, GaussianBand) {
               eps);
 }
 
+// The batch interface of the initializers returns the same values as the
+// evaluation box by box
+TEST(DiffusionInitTest, FillRow) {
+  const double x0 = -20;
+  const double dx = 7.5;
+  const uint64_t n = 12;
+  auto compare = [&](auto initializer) {
+    std::vector<double> values(n);
+    for (double y : {-10.0, 5.0}) {
+      for (double z : {-10.0, 5.0}) {
+        initializer.FillRow(x0, dx, n, y, z, values.data());
+        for (uint64_t i = 0; i < n; i++) {
+          EXPECT_NEAR(initializer(x0 + i * dx, y, z), values[i], 1e-15);
+        }
+      }
+    }
+  };
+  for (uint8_t axis : {Axis::kXAxis, Axis::kYAxis, Axis::kZAxis}) {
+    compare(Uniform(-5, 30, 3, axis));
+    compare(GaussianBand(10, 15, axis));
+    compare(PoissonBand(4, axis));
+  }
+}
+
+// Initializers with and without batch interface are applied in the same way
+TEST(DiffusionInitTest, RunInitializers) {
+  DiffusionGrid batch(0, "Substance", 0.5, 0, 20);
+  DiffusionGrid pointwise(1, "Substance", 0.5, 0, 20);
+  for (auto* dg : {&batch, &pointwise}) {
+    dg->Initialize({0, 190, 0, 190, 0, 190});
+  }
+  GaussianBand x_band(80, 30, Axis::kXAxis);
+  GaussianBand z_band(120, 40, Axis::kZAxis);
+  batch.AddInitializer(x_band);
+  batch.AddInitializer(z_band);
+  pointwise.AddInitializer(
+      [&](double x, double y, double z) { return x_band(x, y, z); });
+  pointwise.AddInitializer(
+      [&](double x, double y, double z) { return z_band(x, y, z); });
+  batch.RunInitializers();
+  pointwise.RunInitializers();
+
+  auto* expected = pointwise.GetAllConcentrations();
+  auto* actual = batch.GetAllConcentrations();
+  for (size_t i = 0; i < batch.GetNumBoxes(); i++) {
+    EXPECT_NEAR(expected[i], actual[i], 1e-15);
+  }
+  // box (x, y, z) = (2, 3, 4) is located at (20, 30, 40)
+  std::array<uint32_t, 3> box = {2, 3, 4};
+  EXPECT_NEAR(ROOT::Math::normal_pdf(20, 30, 80) +
+                  ROOT::Math::normal_pdf(40, 40, 120),
+              actual[batch.GetBoxIndex(box)], 1e-15);
+}
+
 }  // namespace bdm
@@ -12,7 +12,10 @@
 //
 // -----------------------------------------------------------------------------
 
+#include <algorithm>
 #include <fstream>
+#include <numeric>
+#include <vector>
 
 #include "core/diffusion_grid.h"
 #include "core/grid.h"
@@ -343,6 +346,71 @@ TEST(DiffusionTest, CopyOldData) {
   delete d_grid;
 }
 
+// Test if a padded grid absorbs growth without reallocation
+TEST(DiffusionTest, GrowthFactor) {
+  DiffusionGrid exact(0, "Kalium", 0.4, 0, 5);
+  DiffusionGrid padded(1, "Kalium", 0.4, 0, 5);
+  padded.SetGrowthFactor(2);
+  for (auto* dg : {&exact, &padded}) {
+    dg->Initialize({-100, 100, -100, 100, -100, 100});
+    dg->IncreaseConcentrationBy({{0, 0, 0}}, 4);
+    dg->IncreaseConcentrationBy({{-60, 20, 50}}, 2);
+    dg->DiffuseWithLeakingEdge();
+    dg->CalculateGradient();
+    dg->Update({-140, 140});
+  }
+  // box length 50: the exact grid has 7 boxes per axis, the padded one
+  // twice the previous number plus one to keep the parity
+  EXPECT_EQ(7u, exact.GetNumBoxesArray()[0]);
+  EXPECT_EQ(11u, padded.GetNumBoxesArray()[0]);
+  EXPECT_EQ(-290, padded.GetDimensions()[0]);
+  EXPECT_EQ(260, padded.GetDimensions()[1]);
+
+  // further growth within the padding neither changes nor moves the data
+  auto* data = padded.GetAllConcentrations();
+  auto dimensions = padded.GetDimensions();
+  padded.Update({-240, 240});
+  EXPECT_EQ(data, padded.GetAllConcentrations());
+  EXPECT_EQ(dimensions, padded.GetDimensions());
+  EXPECT_EQ(11u, padded.GetNumBoxesArray()[0]);
+
+  // both grids contain the same data at the same positions
+  for (double x = -100; x <= 100; x += 50) {
+    for (double y = -100; y <= 100; y += 50) {
+      for (double z = -100; z <= 100; z += 50) {
+        Double3 position = {{x, y, z}};
+        EXPECT_EQ(exact.GetConcentration(position),
+                  padded.GetConcentration(position));
+      }
+    }
+  }
+}
+
+// Test if a padded grid grows if the thresholds move past one side of it
+TEST(DiffusionTest, GrowthFactorOneSided) {
+  DiffusionGrid dg(0, "Kalium", 0.4, 0, 5);
+  dg.SetGrowthFactor(2);
+  dg.Initialize({-100, 100, -100, 100, -100, 100});
+  dg.Update({-140, 140});
+  EXPECT_EQ(11u, dg.GetNumBoxesArray()[0]);
+  EXPECT_EQ(-290, dg.GetDimensions()[0]);
+  EXPECT_EQ(260, dg.GetDimensions()[1]);
+
+  // the width of the thresholds is still covered by the padded grid, but
+  // the upper threshold is not
+  dg.Update({-240, 300});
+  auto dimensions = dg.GetDimensions();
+  auto num_boxes = dg.GetNumBoxesArray();
+  for (int i = 0; i < 3; i++) {
+    EXPECT_GE(-240, dimensions[2 * i]);
+    EXPECT_LE(300, dimensions[2 * i + 1]);
+    EXPECT_LT(11u, num_boxes[i]);
+    EXPECT_EQ(dimensions[2 * i + 1] - dimensions[2 * i],
+              static_cast<int32_t>(num_boxes[i] * 50));
+  }
+  EXPECT_GT(dg.GetNumBoxes(), dg.GetBoxIndex(Double3{299, 299, 299}));
+}
+
 #ifdef USE_DICT
 
 // Test if all the data members of the diffusion grid are correctly serialized
@@ -500,6 +568,504 @@ TEST(DiffusionTest, Convergence) {
   delete d_grid8;
 }
 
+TEST(DiffusionTest, AdaptTimeStep) {
+  // these parameters would result in unphysical behavior for time step 1
+  // (see WrongParameters)
+  DiffusionGrid d_grid(0, "Kalium", 1, 0.5, 51);
+  d_grid.SetSubCycling(true);
+  d_grid.Initialize({{0, 100, 0, 100, 0, 100}});
+
+  // box length = 2 -> diffusion is stable for dt < 4 / 6
+  EXPECT_NEAR(4.0 / 6, d_grid.GetMaxStableTimeStep(), abs_error<double>::value);
+  EXPECT_EQ(2u, d_grid.AdaptTimeStep(1));
+  EXPECT_NEAR(0.5, d_grid.GetTimeStep(), abs_error<double>::value);
+  EXPECT_EQ(1u, d_grid.AdaptTimeStep(0.5));
+  EXPECT_NEAR(0.5, d_grid.GetTimeStep(), abs_error<double>::value);
+
+  // decay is stable for dt < 1 / mu
+  d_grid.SetDecayConstant(4);
+  EXPECT_NEAR(0.25, d_grid.GetMaxStableTimeStep(), abs_error<double>::value);
+  EXPECT_EQ(5u, d_grid.AdaptTimeStep(1));
+  EXPECT_NEAR(0.2, d_grid.GetTimeStep(), abs_error<double>::value);
+}
+
+TEST(DiffusionTest, SubCycling) {
+  double diff_coef = 0.5;
+  DiffusionGrid reference(0, "Kalium", diff_coef, 0, 41);
+  DiffusionGrid sub_cycled(1, "Kalium", diff_coef, 0, 41);
+  sub_cycled.SetSubCycling(true);
+
+  int l = -100;
+  int r = 100;
+  reference.Initialize({l, r, l, r, l, r});
+  sub_cycled.Initialize({l, r, l, r, l, r});
+
+  // instantaneous point source
+  int init = 1e5;
+  Double3 source = {{0, 0, 0}};
+  reference.IncreaseConcentrationBy(source,
+                                    init / pow(reference.GetBoxLength(), 3));
+  sub_cycled.IncreaseConcentrationBy(source,
+                                     init / pow(sub_cycled.GetBoxLength(), 3));
+
+  // advance both grids by 100 time units: the reference grid with 100 steps
+  // of time step 1, the sub-cycled grid with the largest stable time step
+  int tot = 100;
+  for (int t = 0; t < tot; t++) {
+    reference.DiffuseEuler();
+  }
+  auto sub_steps = sub_cycled.AdaptTimeStep(tot);
+  EXPECT_GT(sub_steps, 1u);
+  EXPECT_LT(sub_steps, static_cast<uint64_t>(tot));
+  for (uint64_t i = 0; i < sub_steps; i++) {
+    sub_cycled.DiffuseEuler();
+  }
+
+  Double3 marker = {10.0, 10.0, 10.0};
+  auto rc = GetRealCoordinates(sub_cycled.GetBoxCoordinates(source),
+                               sub_cycled.GetBoxCoordinates(marker),
+                               sub_cycled.GetBoxLength());
+  auto real_val =
+      CalculateAnalyticalSolution(init, rc[0], rc[1], rc[2], diff_coef, tot);
+  auto ref_val = reference.GetConcentration(marker);
+  auto sub_cycled_val = sub_cycled.GetConcentration(marker);
+  // the larger time step is less accurate, but still comparable to the
+  // reference solution
+  EXPECT_NEAR(ref_val, sub_cycled_val, 0.1 * ref_val);
+  EXPECT_NEAR(real_val, sub_cycled_val, 0.15 * real_val);
+}
+
+TEST(DiffusionTest, TemporalBlocking) {
+  for (bool leaking_edge : {false, true}) {
+    DiffusionGrid single(0, "Kalium", 0.4, 0.01, 21);
+    DiffusionGrid blocked(1, "Kalium", 0.4, 0.01, 21);
+    single.Initialize({-100, 100, -100, 100, -100, 100});
+    blocked.Initialize({-100, 100, -100, 100, -100, 100});
+    single.SetTimeStep(10);
+    blocked.SetTimeStep(10);
+    for (auto* dg : {&single, &blocked}) {
+      dg->IncreaseConcentrationBy({{0, 0, 0}}, 1000);
+      dg->IncreaseConcentrationBy({{-95, 95, 0}}, 500);
+      dg->IncreaseConcentrationBy({{95, -20, -95}}, 200);
+    }
+
+    // one sweep with seven time steps yields the same result as seven sweeps
+    for (int i = 0; i < 7; i++) {
+      if (leaking_edge) {
+        single.DiffuseEulerLeakingEdge();
+      } else {
+        single.DiffuseEuler();
+      }
+    }
+    if (leaking_edge) {
+      blocked.DiffuseEulerLeakingEdge(7);
+    } else {
+      blocked.DiffuseEuler(7);
+    }
+
+    auto* expected = single.GetAllConcentrations();
+    auto* actual = blocked.GetAllConcentrations();
+    for (size_t i = 0; i < single.GetNumBoxes(); i++) {
+      EXPECT_NEAR(expected[i], actual[i], abs_error<double>::value);
+    }
+    // substance leaves the grid through the leaking edges
+    double total = std::accumulate(actual, actual + blocked.GetNumBoxes(), 0.0);
+    if (leaking_edge) {
+      EXPECT_LT(total, 1700 * std::pow(1 - 0.01 * 10, 7));
+    }
+  }
+}
+
+TEST(DiffusionTest, FusedDiffusion) {
+  for (bool leaking_edge : {false, true}) {
+    std::vector<DiffusionGrid*> separate;
+    std::vector<DiffusionGrid*> fused;
+    for (int i = 0; i < 3; i++) {
+      for (auto* grids : {&separate, &fused}) {
+        auto* dg = new DiffusionGrid(i, "Kalium", 0.1 * (i + 1), 0.01 * i, 21);
+        dg->Initialize({-100, 100, -100, 100, -100, 100});
+        dg->IncreaseConcentrationBy({{0, 0, 0}}, 1000);
+        dg->IncreaseConcentrationBy({{-95, 95, 10.0 * i}}, 500);
+        dg->IncreaseConcentrationBy({{95, -20, -95}}, 200);
+        grids->push_back(dg);
+      }
+    }
+
+    for (int step = 0; step < 3; step++) {
+      for (auto* dg : separate) {
+        if (leaking_edge) {
+          dg->DiffuseEulerLeakingEdge();
+        } else {
+          dg->DiffuseEuler();
+        }
+        dg->CalculateGradient();
+      }
+      DiffusionGrid::DiffuseEulerFused(fused, leaking_edge, true);
+    }
+
+    for (int i = 0; i < 3; i++) {
+      auto num_boxes = separate[i]->GetNumBoxes();
+      auto* expected = separate[i]->GetAllConcentrations();
+      auto* actual = fused[i]->GetAllConcentrations();
+      for (size_t b = 0; b < num_boxes; b++) {
+        EXPECT_NEAR(expected[b], actual[b], abs_error<double>::value);
+      }
+      expected = separate[i]->GetAllGradients();
+      actual = fused[i]->GetAllGradients();
+      for (size_t b = 0; b < 3 * num_boxes; b++) {
+        EXPECT_NEAR(expected[b], actual[b], abs_error<double>::value);
+      }
+      delete separate[i];
+      delete fused[i];
+    }
+  }
+}
+
+TEST(DiffusionTest, SparseDiffusion) {
+  for (bool leaking_edge : {false, true}) {
+    DiffusionGrid dense(0, "Kalium", 0.4, 0.01, 64);
+    DiffusionGrid sparse(1, "Kalium", 0.4, 0.01, 64);
+    sparse.SetSparsityThreshold(1e-12);
+    for (auto* dg : {&dense, &sparse}) {
+      dg->Initialize({-63, 63, -63, 63, -63, 63});
+      dg->IncreaseConcentrationBy({{-40, -40, -40}}, 1000);
+    }
+    EXPECT_EQ(512u, sparse.GetNumBlocks());
+
+    auto step = [&](DiffusionGrid* dg) {
+      if (leaking_edge) {
+        dg->DiffuseEulerLeakingEdge();
+      } else {
+        dg->DiffuseEuler();
+      }
+      dg->CalculateGradient();
+    };
+    for (int i = 0; i < 10; i++) {
+      step(&dense);
+      step(&sparse);
+    }
+    // substance is confined to a few blocks around the source
+    EXPECT_LT(sparse.GetNumActiveBlocks(), 30u);
+
+    // secretion into an inactive region activates it
+    dense.IncreaseConcentrationBy({{40, 40, 40}}, 500);
+    sparse.IncreaseConcentrationBy({{40, 40, 40}}, 500);
+    for (int i = 0; i < 10; i++) {
+      step(&dense);
+      step(&sparse);
+    }
+
+    auto num_boxes = dense.GetNumBoxes();
+    auto* expected = dense.GetAllConcentrations();
+    auto* actual = sparse.GetAllConcentrations();
+    for (size_t b = 0; b < num_boxes; b++) {
+      EXPECT_NEAR(expected[b], actual[b], 1e-9);
+    }
+    expected = dense.GetAllGradients();
+    actual = sparse.GetAllGradients();
+    for (size_t b = 0; b < 3 * num_boxes; b++) {
+      EXPECT_NEAR(expected[b], actual[b], 1e-9);
+    }
+  }
+}
+
+TEST(DiffusionTest, ADI) {
+  double diff_coef = 0.5;
+  DiffusionGrid reference(0, "Kalium", diff_coef, 0, 41);
+  DiffusionGrid adi(1, "Kalium", diff_coef, 0, 41);
+  adi.SetDiffusionMethod(Param::DiffusionMethod::kADI);
+
+  int l = -100;
+  int r = 100;
+  reference.Initialize({l, r, l, r, l, r});
+  adi.Initialize({l, r, l, r, l, r});
+
+  // instantaneous point source
+  int init = 1e5;
+  Double3 source = {{0, 0, 0}};
+  reference.IncreaseConcentrationBy(source,
+                                    init / pow(reference.GetBoxLength(), 3));
+  adi.IncreaseConcentrationBy(source, init / pow(adi.GetBoxLength(), 3));
+
+  // advance both grids by 100 time units: the reference grid with 100 steps
+  // of time step 1, the ADI grid with 8 steps beyond the stability limit of
+  // the explicit scheme
+  int tot = 100;
+  for (int t = 0; t < tot; t++) {
+    reference.DiffuseEuler();
+  }
+  double dt = 12.5;
+  EXPECT_GT(dt, adi.GetMaxStableTimeStep());
+  adi.SetTimeStep(dt);
+  for (int t = 0; t < 8; t++) {
+    adi.DiffuseADI();
+  }
+
+  // the implicit scheme is only first order accurate in time
+  for (auto& marker : {Double3{10, 0, 0}, Double3{10, 10, 10}}) {
+    auto ref_val = reference.GetConcentration(marker);
+    auto adi_val = adi.GetConcentration(marker);
+    EXPECT_NEAR(ref_val, adi_val, 0.2 * ref_val);
+  }
+}
+
+TEST(DiffusionTest, ADIClosedEdge) {
+  DiffusionGrid d_grid(0, "Kalium", 0.4, 0, 11);
+  d_grid.SetDiffusionMethod(Param::DiffusionMethod::kADI);
+  d_grid.Initialize({-100, 100, -100, 100, -100, 100});
+  d_grid.IncreaseConcentrationBy({{0, 0, 0}}, 1000);
+  d_grid.IncreaseConcentrationBy({{-90, 50, 90}}, 500);
+
+  auto total = [&]() {
+    auto* c = d_grid.GetAllConcentrations();
+    return std::accumulate(c, c + d_grid.GetNumBoxes(), 0.0);
+  };
+  auto squared_norm = [&]() {
+    auto* c = d_grid.GetAllConcentrations();
+    return std::inner_product(c, c + d_grid.GetNumBoxes(), c, 0.0);
+  };
+
+  // substance does not leave the grid and the solution does not grow, even
+  // for time steps that are orders of magnitude above the stability limit of
+  // the explicit scheme
+  d_grid.SetTimeStep(1e4);
+  for (int i = 0; i < 10; i++) {
+    auto previous_norm = squared_norm();
+    d_grid.DiffuseADI();
+    EXPECT_NEAR(1500, total(), 1e-8);
+    EXPECT_LE(squared_norm(), previous_norm);
+  }
+  auto* c = d_grid.GetAllConcentrations();
+  EXPECT_GE(*std::min_element(c, c + d_grid.GetNumBoxes()), 0);
+
+  // leaking edges and decay reduce the amount of substance
+  d_grid.SetDecayConstant(0.01);
+  d_grid.SetTimeStep(10);
+  d_grid.DiffuseADILeakingEdge();
+  EXPECT_LT(total(), 1500 * std::exp(-0.01 * 10));
+  EXPECT_GT(total(), 0);
+}
+
+TEST(DiffusionTest, ConcurrentSecretion) {
+  for (auto mode :
+       {Param::SecretionMode::kAtomic, Param::SecretionMode::kBuffered}) {
+    DiffusionGrid d_grid(0, "Kalium", 0.4, 0, 11);
+    d_grid.SetSecretionMode(mode);
+    d_grid.Initialize({-100, 100, -100, 100, -100, 100});
+    d_grid.SetConcentrationThreshold(1e15);
+
+    // many threads secrete into the same boxes
+#pragma omp parallel for
+    for (int i = 0; i < 100000; i++) {
+      d_grid.IncreaseConcentrationBy({{0, 0, 0}}, 1);
+      d_grid.IncreaseConcentrationBy({{50, 50, 50}}, 0.5);
+      d_grid.IncreaseConcentrationBy({{-90, -90, -90}}, 2);
+    }
+    d_grid.ApplyDeposits();
+
+    EXPECT_NEAR(100000, d_grid.GetConcentration({{0, 0, 0}}),
+                abs_error<double>::value);
+    EXPECT_NEAR(50000, d_grid.GetConcentration({{50, 50, 50}}),
+                abs_error<double>::value);
+    EXPECT_NEAR(200000, d_grid.GetConcentration({{-90, -90, -90}}),
+                abs_error<double>::value);
+
+    // the threshold caps the concentration
+    d_grid.SetConcentrationThreshold(200010);
+#pragma omp parallel for
+    for (int i = 0; i < 100; i++) {
+      d_grid.IncreaseConcentrationBy({{-90, -90, -90}}, 1);
+    }
+    d_grid.ApplyDeposits();
+    EXPECT_NEAR(200010, d_grid.GetConcentration({{-90, -90, -90}}),
+                abs_error<double>::value);
+  }
+}
+
+TEST(DiffusionTest, BufferedSecretion) {
+  DiffusionGrid atomic(0, "Kalium", 0.4, 0, 5);
+  DiffusionGrid buffered(1, "Kalium", 0.4, 0, 5);
+  buffered.SetSecretionMode(Param::SecretionMode::kBuffered);
+  atomic.Initialize({-100, 100, -100, 100, -100, 100});
+  buffered.Initialize({-100, 100, -100, 100, -100, 100});
+
+  // buffered deposits are added before the next diffusion step
+  for (int i = 0; i < 10; i++) {
+    atomic.IncreaseConcentrationBy({{0, 0, 0}}, 4);
+    buffered.IncreaseConcentrationBy({{0, 0, 0}}, 4);
+    atomic.DiffuseWithLeakingEdge();
+    buffered.DiffuseWithLeakingEdge();
+  }
+  auto* expected = atomic.GetAllConcentrations();
+  auto* actual = buffered.GetAllConcentrations();
+  for (size_t i = 0; i < atomic.GetNumBoxes(); i++) {
+    EXPECT_EQ(expected[i], actual[i]);
+  }
+
+  // deposits are not visible before they have been applied
+  buffered.IncreaseConcentrationBy({{0, 0, 0}}, 4);
+  auto before = buffered.GetConcentration({{0, 0, 0}});
+  buffered.ApplyDeposits();
+  EXPECT_NEAR(before + 4, buffered.GetConcentration({{0, 0, 0}}),
+              abs_error<double>::value);
+}
+
+TEST(DiffusionTest, SinglePrecision) {
+  for (auto method :
+       {Param::DiffusionMethod::kExplicitEuler, Param::DiffusionMethod::kADI}) {
+    DiffusionGrid dp(0, "Kalium", 0.4, 0.01, 21);
+    DiffusionGrid sp(1, "Kalium", 0.4, 0.01, 21);
+    sp.SetSinglePrecision(true);
+    EXPECT_TRUE(sp.IsSinglePrecision());
+    for (auto* dg : {&dp, &sp}) {
+      dg->SetDiffusionMethod(method);
+      dg->Initialize({-100, 100, -100, 100, -100, 100});
+      dg->IncreaseConcentrationBy({{-30, 10, 20}}, 1000);
+      dg->IncreaseConcentrationBy({{30, -10, 0}}, 500);
+    }
+
+    auto step = [&](DiffusionGrid* dg) {
+      if (method == Param::DiffusionMethod::kADI) {
+        dg->DiffuseADILeakingEdge();
+      } else {
+        dg->DiffuseEulerLeakingEdge();
+      }
+      dg->CalculateGradient();
+    };
+    for (int i = 0; i < 10; i++) {
+      step(&dp);
+      step(&sp);
+    }
+    // the data of the single precision grid is copied when it grows
+    dp.Update({-140, 140});
+    sp.Update({-140, 140});
+    for (int i = 0; i < 10; i++) {
+      step(&dp);
+      step(&sp);
+    }
+
+    // the stored values differ by the rounding error of float
+    ASSERT_EQ(dp.GetNumBoxes(), sp.GetNumBoxes());
+    auto num_boxes = dp.GetNumBoxes();
+    auto* expected = dp.GetAllConcentrations();
+    auto* actual = sp.GetAllConcentrations<float>();
+    double max = *std::max_element(expected, expected + num_boxes);
+    EXPECT_GT(max, 0);
+    for (size_t b = 0; b < num_boxes; b++) {
+      EXPECT_NEAR(expected[b], actual[b], 1e-5 * max);
+    }
+    auto* expected_gradients = dp.GetAllGradients();
+    auto* actual_gradients = sp.GetAllGradients<float>();
+    for (size_t b = 0; b < 3 * num_boxes; b++) {
+      EXPECT_NEAR(expected_gradients[b], actual_gradients[b],
+                  1e-5 * max / dp.GetBoxLength());
+    }
+    Double3 position = {{-20, 10, 20}};
+    EXPECT_NEAR(dp.GetConcentration(position), sp.GetConcentration(position),
+                1e-5 * max);
+    Double3 expected_gradient;
+    Double3 actual_gradient;
+    dp.GetGradient(position, &expected_gradient);
+    sp.GetGradient(position, &actual_gradient);
+    for (int i = 0; i < 3; i++) {
+      EXPECT_NEAR(expected_gradient[i], actual_gradient[i], 1e-4);
+    }
+
+    // converting to double precision keeps the values
+    std::vector<float> before(actual, actual + num_boxes);
+    sp.SetSinglePrecision(false);
+    EXPECT_FALSE(sp.IsSinglePrecision());
+    auto* after = sp.GetAllConcentrations();
+    for (size_t b = 0; b < num_boxes; b++) {
+      EXPECT_EQ(before[b], after[b]);
+    }
+  }
+}
+
+TEST(DiffusionTest, LazyGradients) {
+  DiffusionGrid eager(0, "Kalium", 0.4, 0.01, 21);
+  DiffusionGrid lazy(1, "Kalium", 0.4, 0.01, 21);
+  DiffusionGrid normalized(2, "Kalium", 0.4, 0.01, 21);
+  lazy.SetLazyGradients(true);
+  normalized.SetNormalizeGradients(true);
+  EXPECT_TRUE(lazy.HasLazyGradients());
+  EXPECT_TRUE(normalized.HasNormalizedGradients());
+  // deposits must not change the concentrations between two diffusion steps
+  EXPECT_EQ(Param::SecretionMode::kAtomic, eager.GetSecretionMode());
+  EXPECT_EQ(Param::SecretionMode::kBuffered, lazy.GetSecretionMode());
+  for (auto* dg : {&eager, &lazy, &normalized}) {
+    dg->Initialize({-100, 100, -100, 100, -100, 100});
+    dg->IncreaseConcentrationBy({{-30, 10, 20}}, 1000);
+    dg->IncreaseConcentrationBy({{30, -10, 0}}, 500);
+  }
+
+  // positions inside the grid and at its borders
+  std::vector<Double3> positions = {{{-20, 10, 20}},
+                                    {{0, 0, 0}},
+                                    {{-100, -100, -100}},
+                                    {{100, 100, 100}},
+                                    {{100, -60, -100}}};
+  auto expect_same_gradients = [&]() {
+    for (auto& position : positions) {
+      Double3 expected;
+      Double3 actual;
+      eager.GetGradient(position, &expected);
+      // the second query uses the cached value
+      for (int query = 0; query < 2; query++) {
+        lazy.GetGradient(position, &actual);
+        for (int i = 0; i < 3; i++) {
+          EXPECT_NEAR(expected[i], actual[i], 1e-12);
+        }
+      }
+      normalized.GetGradient(position, &actual);
+      for (int i = 0; i < 3; i++) {
+        EXPECT_NEAR(expected[i], actual[i], 1e-12);
+      }
+    }
+  };
+
+  for (int i = 0; i < 5; i++) {
+    for (auto* dg : {&eager, &lazy, &normalized}) {
+      dg->DiffuseEulerLeakingEdge();
+      dg->CalculateGradient();
+      // secretion after the gradients have been calculated does not change
+      // the gradients of this step
+      dg->IncreaseConcentrationBy({{-10, 10, 20}}, 100);
+    }
+    expect_same_gradients();
+  }
+  // the cache is invalidated when the grid grows
+  for (auto* dg : {&eager, &lazy, &normalized}) {
+    dg->Update({-140, 140});
+    dg->DiffuseEulerLeakingEdge();
+    dg->CalculateGradient();
+  }
+  expect_same_gradients();
+
+  // only queried boxes are calculated
+  auto* gradients = lazy.GetAllGradients();
+  auto num_boxes = lazy.GetNumBoxes();
+  uint64_t calculated = 0;
+  for (size_t b = 0; b < num_boxes; b++) {
+    calculated += gradients[3 * b] != 0 || gradients[3 * b + 1] != 0 ||
+                  gradients[3 * b + 2] != 0;
+  }
+  EXPECT_LE(calculated, positions.size());
+  EXPECT_LT(0u, calculated);
+
+  // stored gradients are normalized
+  gradients = normalized.GetAllGradients();
+  for (size_t b = 0; b < num_boxes; b++) {
+    double norm = std::sqrt(gradients[3 * b] * gradients[3 * b] +
+                            gradients[3 * b + 1] * gradients[3 * b + 1] +
+                            gradients[3 * b + 2] * gradients[3 * b + 2]);
+    // gradients with a norm below 1e-10 are not normalized
+    if (norm > 1e-10) {
+      EXPECT_NEAR(1, norm, 1e-9);
+    }
+  }
+}
+
 #ifdef USE_PARAVIEW
 
 // Travis does not support OpenGL 3.3
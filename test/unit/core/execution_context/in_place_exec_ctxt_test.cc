@@ -13,6 +13,10 @@
 // -----------------------------------------------------------------------------
 
 #include <gtest/gtest.h>
+#include <omp.h>
+#include <atomic>
+#include <limits>
+#include <vector>
 
 #include "core/execution_context/in_place_exec_ctxt.h"
 #include "core/grid.h"
@@ -129,6 +133,109 @@ TEST(InPlaceExecutionContext, NewAndGetSimObject) {
   EXPECT_EQ(789, rm->GetSimObject(uid_1)->GetDiameter());
 }
 
+TEST(InPlaceExecutionContext, ConcurrentPushBackAndGetSimObject) {
+  Simulation sim(TEST_NAME);
+  auto* rm = sim.GetResourceManager();
+  const auto& ctxts = sim.GetAllExecCtxts();
+  auto max_threads = ThreadInfo::GetInstance()->GetMaxThreads();
+  const uint64_t num_cells = 1000;
+
+  // uid of the last sim object each thread has added
+  std::vector<std::atomic<uint64_t>> last_uid(max_threads);
+  for (auto& uid : last_uid) {
+    uid = std::numeric_limits<uint64_t>::max();
+  }
+  std::atomic<uint64_t> lookups = {0};
+  std::atomic<uint64_t> not_found = {0};
+
+  // threads add new sim objects while others look them up
+#pragma omp parallel num_threads(max_threads)
+  {
+    auto tid = omp_get_thread_num();
+    auto* ctxt = ctxts[tid];
+    auto neighbor = (tid + 1) % omp_get_num_threads();
+    for (uint64_t i = 0; i < num_cells; i++) {
+      auto* cell = new Cell();
+      auto uid = cell->GetUid();
+      ctxt->push_back(cell);
+      last_uid[tid] = uid;
+      auto nb_uid = last_uid[neighbor].load();
+      if (nb_uid != std::numeric_limits<uint64_t>::max()) {
+        lookups++;
+        auto* so = ctxt->GetSimObject(nb_uid);
+        if (so == nullptr || so->GetUid() != nb_uid) {
+          not_found++;
+        }
+      }
+    }
+  }
+  EXPECT_GT(lookups, 0u);
+  EXPECT_EQ(0u, not_found);
+
+  ctxts[0]->TearDownIterationAll(ctxts);
+  EXPECT_EQ(num_cells * max_threads, rm->GetNumSimObjects());
+}
+
+TEST(InPlaceExecutionContext, NeighborCacheWithSoHandle) {
+  auto set_param = [](auto* param) { param->cache_neighbors_ = true; };
+  Simulation sim(TEST_NAME, set_param);
+  auto* rm = sim.GetResourceManager();
+  auto* ctxt = sim.GetExecutionContext();
+
+  auto* cell0 = new Cell({0, 0, 0});
+  cell0->SetDiameter(10);
+  rm->push_back(cell0);
+  auto* cell1 = new Cell({5, 0, 0});
+  cell1->SetDiameter(10);
+  rm->push_back(cell1);
+  sim.GetGrid()->Initialize();
+
+  // cached distances reflect the positions at the time the cache was built
+  cell1->SetPosition({6, 0, 0});
+  double squared_distance = 0;
+  Operation op("neighbors", [&](SimObject* so) {
+    ctxt->ForEachNeighbor(
+        [&](const SimObject*, double d) { squared_distance = d; }, *so);
+  });
+
+  // the SoHandle identifies the row in the neighbor cache
+  ctxt->Execute(cell0, rm->GetSoHandle(cell0->GetUid()), {op});
+  EXPECT_NEAR(25, squared_distance, abs_error<double>::value);
+
+  // without SoHandle the neighbors are determined by the grid
+  ctxt->Execute(cell0, {op});
+  EXPECT_NEAR(36, squared_distance, abs_error<double>::value);
+}
+
+TEST(InPlaceExecutionContext, NewSimObjectsLookupAndCommitOrder) {
+  Simulation sim(TEST_NAME);
+  auto* rm = sim.GetResourceManager();
+  auto* ctxt = sim.GetExecutionContext();
+
+  std::vector<SoUid> uids;
+  for (uint64_t i = 0; i < 10; i++) {
+    Cell* cell = new Cell();
+    cell->SetDiameter(i + 1);
+    uids.push_back(cell->GetUid());
+    ctxt->push_back(cell);
+    // lookups in between insertions must also find new sim objects
+    EXPECT_EQ(i / 2 + 1, ctxt->GetSimObject(uids[i / 2])->GetDiameter());
+  }
+  for (uint64_t i = 0; i < 10; i++) {
+    EXPECT_EQ(i + 1, ctxt->GetSimObject(uids[i])->GetDiameter());
+  }
+
+  ctxt->TearDownIterationAll(sim.GetAllExecCtxts());
+
+  // sim objects are appended in insertion order
+  EXPECT_EQ(10u, rm->GetNumSimObjects());
+  for (uint64_t i = 0; i < 10; i++) {
+    EXPECT_TRUE(rm->Contains(uids[i]));
+    EXPECT_EQ(SoHandle(0, i), rm->GetSoHandle(uids[i]));
+    EXPECT_EQ(i + 1, rm->GetSimObject(uids[i])->GetDiameter());
+  }
+}
+
 TEST(InPlaceExecutionContext, Execute) {
   Simulation sim(TEST_NAME);
   auto* ctxt = sim.GetExecutionContext();
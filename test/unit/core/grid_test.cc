@@ -15,6 +15,9 @@
 #include "core/grid.h"
 #include "core/sim_object/cell.h"
 #include "gtest/gtest.h"
+#include "neuroscience/module.h"
+#include "neuroscience/neurite_element.h"
+#include "unit/test_util/test_sim_object.h"
 #include "unit/test_util/test_util.h"
 
 namespace bdm {
@@ -320,4 +323,103 @@ TEST(GridTest, IterateZOrder) {
   }
 }
 
+TEST(GridTest, GetNumSimObjectsInMooreNeighborhood) {
+  Simulation simulation(TEST_NAME);
+  auto* rm = simulation.GetResourceManager();
+  auto* grid = simulation.GetGrid();
+
+  CellFactory(rm, 4);
+
+  grid->Initialize();
+
+  rm->ApplyOnAllElements([&](SimObject* so) {
+    // ForEachNeighbor iterates over all sim objects in the Moore neighborhood
+    // except the query itself
+    uint64_t expected = 1;
+    grid->ForEachNeighbor([&](const SimObject*) { expected++; }, *so);
+    EXPECT_EQ(expected,
+              grid->GetNumSimObjectsInMooreNeighborhood(so->GetBoxIdx()));
+  });
+}
+
+TEST(GridTest, NeighborCache) {
+  auto set_param = [](auto* param) { param->cache_neighbors_ = true; };
+  Simulation simulation(TEST_NAME, set_param);
+  auto* rm = simulation.GetResourceManager();
+  auto* grid = simulation.GetGrid();
+
+  CellFactory(rm, 4);
+
+  grid->Initialize();
+
+  // the cache must contain the same neighbors and distances as the grid
+  rm->ApplyOnAllElements([&](SimObject* so, SoHandle soh) {
+    std::unordered_map<SoUid, double> expected;
+    grid->ForEachNeighbor(
+        [&](const SimObject* neighbor, double squared_distance) {
+          expected[neighbor->GetUid()] = squared_distance;
+        },
+        *so);
+
+    std::unordered_map<SoUid, double> cached;
+    EXPECT_TRUE(grid->ForEachCachedNeighbor(
+        [&](const SimObject* neighbor, double squared_distance) {
+          cached[neighbor->GetUid()] = squared_distance;
+        },
+        *so, soh));
+
+    EXPECT_EQ(expected.size(), cached.size());
+    for (auto& el : expected) {
+      ASSERT_TRUE(cached.find(el.first) != cached.end());
+      EXPECT_NEAR(el.second, cached[el.first], abs_error<double>::value);
+    }
+  });
+
+  // sim objects that are not part of the cache
+  Cell new_cell({10, 10, 10});
+  EXPECT_FALSE(grid->ForEachCachedNeighbor(
+      [](const SimObject*, double) { FAIL(); }, new_cell, SoHandle()));
+  EXPECT_FALSE(grid->ForEachCachedNeighbor(
+      [](const SimObject*, double) { FAIL(); }, new_cell, SoHandle(0, 0)));
+
+  // changes in the ResourceManager layout invalidate the cache
+  auto* first = rm->GetSimObjectWithSoHandle(SoHandle(0, 0));
+  rm->Remove(rm->GetSimObjectWithSoHandle(SoHandle(0, 1))->GetUid());
+  EXPECT_FALSE(grid->ForEachCachedNeighbor(
+      [](const SimObject*, double) { FAIL(); }, *first, SoHandle(0, 0)));
+
+  grid->UpdateGrid();
+  EXPECT_TRUE(grid->ForEachCachedNeighbor([](const SimObject*, double) {},
+                                          *first, SoHandle(0, 0)));
+}
+
+TEST(GridTest, ContainsOnlyCells) {
+  experimental::neuroscience::InitModule();
+  Simulation simulation(TEST_NAME);
+  auto* rm = simulation.GetResourceManager();
+  auto* grid = simulation.GetGrid();
+
+  CellFactory(rm, 2);
+  grid->Initialize();
+  EXPECT_TRUE(grid->ContainsOnlyCells());
+
+  auto* neurite = new experimental::neuroscience::NeuriteElement();
+  neurite->SetPosition({10, 10, 10});
+  neurite->SetDiameter(2);
+  rm->push_back(neurite);
+  grid->UpdateGrid();
+  EXPECT_FALSE(grid->ContainsOnlyCells());
+
+  rm->Remove(neurite->GetUid());
+  grid->UpdateGrid();
+  EXPECT_TRUE(grid->ContainsOnlyCells());
+
+  // spheres that do not derive from Cell
+  auto* sphere = new TestSimObject({20, 20, 20});
+  sphere->SetDiameter(2);
+  rm->push_back(sphere);
+  grid->UpdateGrid();
+  EXPECT_FALSE(grid->ContainsOnlyCells());
+}
+
 }  // namespace bdm
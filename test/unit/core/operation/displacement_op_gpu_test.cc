@@ -24,14 +24,18 @@ namespace bdm {
 namespace displacement_op_gpu_test_internal {
 
 // NB: The GPU execution 'context' for the displacement operation differes,
-// from the CPU version. Once the CPU version supports the same execution
-// context, we can include it for direct comparison of results.
+// from the default CPU version. The data-parallel CPU version
+// (`DisplacementOpSoa`) uses the same execution context and is therefore
+// compared against the same results.
 
-enum ExecutionMode { kCuda, kOpenCl };
+enum ExecutionMode { kCpuSoa, kCuda, kOpenCl };
 
 void RunTest(ExecutionMode mode) {
   auto set_param = [&](Param* param) {
     switch (mode) {
+      case kCpuSoa:
+        param->use_soa_mechanics_ = true;
+        break;
       case kOpenCl:
         param->use_gpu_ = true;
         param->use_opencl_ = true;
@@ -113,6 +117,8 @@ void RunTest(ExecutionMode mode) {
   EXPECT_NEAR(1.1, final_cell1->GetMass(), abs_error<double>::value);
 }
 
+TEST(DisplacementOpGpuTest, ComputeSoaCpu) { RunTest(kCpuSoa); }
+
 #ifdef USE_CUDA
 TEST(DisplacementOpGpuTest, ComputeSoaCuda) { RunTest(kCuda); }
 #endif
@@ -124,6 +130,9 @@ TEST(DisplacementOpGpuTest, ComputeSoaOpenCL) { RunTest(kOpenCl); }
 void RunTest2(ExecutionMode mode) {
   auto set_param = [&](auto* param) {
     switch (mode) {
+      case kCpuSoa:
+        param->use_soa_mechanics_ = true;
+        break;
       case kOpenCl:
         param->use_gpu_ = true;
         param->use_opencl_ = true;
@@ -194,6 +203,8 @@ void RunTest2(ExecutionMode mode) {
   // clang-format on
 }
 
+TEST(DisplacementOpGpuTest, ComputeSoaNewCpu) { RunTest2(kCpuSoa); }
+
 #ifdef USE_CUDA
 TEST(DisplacementOpGpuTest, ComputeSoaNewCuda) { RunTest2(kCuda); }
 #endif
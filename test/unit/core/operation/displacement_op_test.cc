@@ -13,7 +13,11 @@
 // -----------------------------------------------------------------------------
 
 #include "unit/core/operation/displacement_op_test.h"
+#include <set>
 #include "gtest/gtest.h"
+#include "neuroscience/module.h"
+#include "neuroscience/neurite_element.h"
+#include "unit/test_util/test_sim_object.h"
 
 namespace bdm {
 namespace displacement_op_test_internal {
@@ -81,5 +85,200 @@ TEST(DisplacementOpTest, ComputeNew) {
   // clang-format on
 }
 
+/// Force model without any interactions
+struct NoForce {
+  Double4 GetForce(const SimObject* lhs, const SimObject* rhs) const {
+    return {0, 0, 0, 0};
+  }
+  void ForceBetweenSpheres(const Double3& ref_mass_location,
+                           double ref_diameter, const Double3& nb_mass_location,
+                           double nb_diameter, Double3* result) const {
+    *result = {0, 0, 0};
+  }
+};
+
+/// Force model that forwards all calls to DefaultForce
+struct ForwardingForce {
+  Double4 GetForce(const SimObject* lhs, const SimObject* rhs) const {
+    return DefaultForce().GetForce(lhs, rhs);
+  }
+  void ForceBetweenSpheres(const Double3& ref_mass_location,
+                           double ref_diameter, const Double3& nb_mass_location,
+                           double nb_diameter, Double3* result) const {
+    DefaultForce::ForceBetweenSpheres(ref_mass_location, ref_diameter,
+                                      nb_mass_location, nb_diameter, result);
+  }
+};
+
+/// Returns the positions of two overlapping cells after executing `op`
+std::vector<Double3> RunCustomForceModel(const Operation& op) {
+  Simulation simulation("displacement_op_test_RunCustomForceModel");
+  auto* rm = simulation.GetResourceManager();
+
+  Cell* cell0 = new Cell({0, 0, 0});
+  cell0->SetAdherence(0.3);
+  cell0->SetDiameter(9);
+  cell0->SetMass(1.4);
+  rm->push_back(cell0);
+  Cell* cell1 = new Cell({0, 5, 0});
+  cell1->SetAdherence(0.4);
+  cell1->SetDiameter(11);
+  cell1->SetMass(1.1);
+  rm->push_back(cell1);
+
+  simulation.GetGrid()->Initialize();
+  auto* ctxt = simulation.GetExecutionContext();
+  ctxt->Execute(cell0, {op});
+  ctxt->Execute(cell1, {op});
+  return {cell0->GetPosition(), cell1->GetPosition()};
+}
+
+TEST(DisplacementOpTest, CustomForceModel) {
+  auto no_force = RunCustomForceModel(
+      Operation("displacement", DisplacementOpCpu<NoForce>()));
+  EXPECT_ARR_NEAR(no_force[0], {0, 0, 0});
+  EXPECT_ARR_NEAR(no_force[1], {0, 5, 0});
+
+  auto expected =
+      RunCustomForceModel(Operation("displacement", DisplacementOp()));
+  auto forwarding = RunCustomForceModel(
+      Operation("displacement", DisplacementOpCpu<ForwardingForce>()));
+  EXPECT_ARR_NEAR(expected[0], forwarding[0]);
+  EXPECT_ARR_NEAR(expected[1], forwarding[1]);
+  // make sure that the cells have been moved
+  EXPECT_GT(std::abs(expected[0][1]), 1e-3);
+}
+
+TEST(DisplacementOpTest, CustomForceModelSoaBackend) {
+  auto set_param = [](auto* param) { param->use_soa_mechanics_ = true; };
+  Simulation simulation(TEST_NAME, set_param);
+  auto* rm = simulation.GetResourceManager();
+  auto* cell0 = new Cell({0, 0, 0});
+  cell0->SetDiameter(9);
+  rm->push_back(cell0);
+  auto* cell1 = new Cell({0, 5, 0});
+  cell1->SetDiameter(11);
+  rm->push_back(cell1);
+  auto uid0 = cell0->GetUid();
+  auto uid1 = cell1->GetUid();
+
+  // the custom force model must not be replaced by the default force model
+  // of the SoA backend
+  auto* op = simulation.GetScheduler()->GetOperation("displacement");
+  *op = Operation("displacement", op->frequency_, DisplacementOpCpu<NoForce>());
+  simulation.GetScheduler()->Simulate(1);
+
+  EXPECT_ARR_NEAR(rm->GetSimObject(uid0)->GetPosition(), {0, 0, 0});
+  EXPECT_ARR_NEAR(rm->GetSimObject(uid1)->GetPosition(), {0, 5, 0});
+}
+
+TEST(DisplacementOpTest, CustomForceModelUnsupportedType) {
+  Simulation simulation(TEST_NAME);
+  auto* so = new TestSimObject({0, 0, 0});
+  so->SetDiameter(10);
+  simulation.GetResourceManager()->push_back(so);
+  simulation.GetGrid()->Initialize();
+  Operation op("displacement", DisplacementOpCpu<NoForce>());
+  auto* ctxt = simulation.GetExecutionContext();
+  ASSERT_DEATH(ctxt->Execute(so, {op}),
+               ".*not supported for sim objects of type TestSimObject.*");
+}
+
+TEST(DisplacementOpTest, SoaData) {
+  Simulation simulation(TEST_NAME);
+  auto* rm = simulation.GetResourceManager();
+  auto* grid = simulation.GetGrid();
+  auto* random = simulation.GetRandom();
+
+  for (uint64_t i = 0; i < 1000; i++) {
+    auto* cell = new Cell({random->Uniform(0, 100), random->Uniform(0, 100),
+                           random->Uniform(0, 100)});
+    cell->SetDiameter(10);
+    rm->push_back(cell);
+  }
+  grid->Initialize();
+
+  DisplacementSoaData data;
+  EXPECT_TRUE(data.Update());
+  ASSERT_EQ(1000u, data.num_objects_);
+
+  // sim objects are sorted by box
+  std::set<SoUid> uids;
+  uint64_t num_objects = 0;
+  for (uint64_t b = 0; b < data.starts_.size(); b++) {
+    for (uint64_t i = data.starts_[b]; i < data.starts_[b] + data.lengths_[b];
+         i++) {
+      auto* cell = rm->GetSimObjectWithSoHandle(data.handles_[i]);
+      uids.insert(cell->GetUid());
+      EXPECT_EQ(b, data.box_id_[i]);
+      EXPECT_EQ(b, cell->GetBoxIdx());
+      EXPECT_EQ(i + 1, data.successors_[i]);
+      EXPECT_EQ(cell->GetPosition()[0], data.positions_[3 * i]);
+      EXPECT_EQ(cell->GetPosition()[2], data.positions_[3 * i + 2]);
+      EXPECT_EQ(10, data.diameters_[i]);
+      num_objects++;
+    }
+  }
+  EXPECT_EQ(1000u, num_objects);
+  EXPECT_EQ(1000u, uids.size());
+
+  // only the data of the sim objects is marshaled if the grid did not change
+  auto* cell = rm->GetSimObjectWithSoHandle(data.handles_[0]);
+  cell->SetPosition({1, 2, 3});
+  EXPECT_FALSE(data.Update());
+  EXPECT_EQ(1, data.positions_[0]);
+  EXPECT_EQ(2, data.positions_[1]);
+  EXPECT_EQ(3, data.positions_[2]);
+
+  EXPECT_EQ(0u, data.num_marshaled_boxes_);
+
+  // rebuilding the grid does not change the box assignment
+  grid->UpdateGrid();
+  EXPECT_FALSE(data.Update());
+  EXPECT_EQ(0u, data.num_marshaled_boxes_);
+
+  // a sim object moves to another box
+  auto box = cell->GetBoxIdx();
+  cell->SetPosition({90, 90, 90});
+  grid->UpdateGrid();
+  ASSERT_NE(box, cell->GetBoxIdx());
+  EXPECT_TRUE(data.Update());
+  EXPECT_EQ(1000u, data.num_marshaled_boxes_);
+
+  rm->push_back(new Cell({50, 50, 50}));
+  grid->UpdateGrid();
+  EXPECT_TRUE(data.Update());
+  EXPECT_EQ(1001u, data.num_objects_);
+  EXPECT_EQ(1001u, data.num_marshaled_boxes_);
+}
+
+TEST(DisplacementOpTest, SoaBackendSelection) {
+  experimental::neuroscience::InitModule();
+  auto set_param = [](auto* param) { param->use_soa_mechanics_ = true; };
+  Simulation simulation(TEST_NAME, set_param);
+  auto* rm = simulation.GetResourceManager();
+  auto* grid = simulation.GetGrid();
+  rm->push_back(new Cell(10));
+  grid->Initialize();
+
+  DisplacementOp op;
+  EXPECT_TRUE(op.UseSoa());
+  EXPECT_FALSE(op.UseCpu());
+
+  // the data-parallel implementation only supports cells
+  auto* neurite = new experimental::neuroscience::NeuriteElement();
+  rm->push_back(neurite);
+  grid->UpdateGrid();
+  EXPECT_FALSE(op.UseSoa());
+  EXPECT_TRUE(op.UseCpu());
+
+  // spheres that do not derive from Cell
+  rm->Remove(neurite->GetUid());
+  rm->push_back(new TestSimObject({20, 20, 20}));
+  grid->UpdateGrid();
+  EXPECT_FALSE(op.UseSoa());
+  EXPECT_TRUE(op.UseCpu());
+}
+
 }  // namespace displacement_op_test_internal
 }  // namespace bdm
@@ -46,6 +46,95 @@ TEST(ResourceManagerTest, SortAndApplyOnAllElementsParallelDynamic) {
   RunSortAndApplyOnAllElementsParallelDynamic();
 }
 
+TEST(ResourceManagerTest, ApplyOnAllElementsParallelDynamicStatistics) {
+  Simulation simulation(TEST_NAME);
+  auto* rm = simulation.GetResourceManager();
+  for (uint64_t i = 0; i < 1000; i++) {
+    rm->push_back(new TestSimObject());
+  }
+
+  auto numa_nodes = ThreadInfo::GetInstance()->GetNumaNodes();
+  std::vector<uint64_t> batch_sizes(numa_nodes, 10);
+  std::vector<SchedulingStatistics> statistics;
+  std::atomic<uint64_t> cnt(0);
+  rm->ApplyOnAllElementsParallelDynamic(
+      batch_sizes, [&](SimObject*, SoHandle) { cnt++; }, &statistics);
+
+  EXPECT_EQ(1000u, cnt.load());
+  ASSERT_EQ(static_cast<uint64_t>(numa_nodes), statistics.size());
+  uint64_t num_sim_objects = 0;
+  for (auto& stats : statistics) {
+    num_sim_objects += stats.num_sim_objects;
+    if (stats.num_sim_objects != 0) {
+      EXPECT_LE(stats.num_sim_objects, stats.batches * 10);
+      EXPECT_LE(stats.stolen_batches, stats.batches);
+      EXPECT_LE(0.0, stats.GetStealRate());
+      EXPECT_GE(1.0, stats.GetStealRate());
+      EXPECT_LT(0, stats.runtime);
+    }
+  }
+  EXPECT_EQ(1000u, num_sim_objects);
+}
+
+TEST(ResourceManagerTest, ApplyOnAllElementsParallelCostWeighted) {
+  Simulation simulation(TEST_NAME);
+  auto* rm = simulation.GetResourceManager();
+  auto ref_uid = SoUidGenerator::Get()->GetLastId();
+  for (uint64_t i = 0; i < 1000; i++) {
+    rm->push_back(new TestSimObject());
+  }
+
+  auto numa_nodes = ThreadInfo::GetInstance()->GetNumaNodes();
+  std::vector<uint64_t> batch_sizes(numa_nodes, 10);
+  // the first 100 sim objects are much more expensive
+  auto cost = [&](SimObject* so) -> double {
+    return so->GetUid() - ref_uid < 100 ? 100 : 1;
+  };
+
+  for (auto cost_fn : std::vector<std::function<double(SimObject*)>>{
+           cost, [](SimObject*) -> double { return 0; }}) {
+    std::vector<std::atomic<uint64_t>> cnt(1000);
+    std::vector<SchedulingStatistics> statistics;
+    auto count = [&](SimObject* so, SoHandle) {
+      cnt[so->GetUid() - ref_uid]++;
+    };
+    rm->ApplyOnAllElementsParallelCostWeighted(batch_sizes, count, cost_fn,
+                                               &statistics);
+
+    // each sim object must be processed exactly once
+    for (auto& c : cnt) {
+      EXPECT_EQ(1u, c.load());
+    }
+    ASSERT_EQ(static_cast<uint64_t>(numa_nodes), statistics.size());
+    uint64_t num_sim_objects = 0;
+    for (auto& stats : statistics) {
+      num_sim_objects += stats.num_sim_objects;
+      if (stats.num_sim_objects != 0) {
+        EXPECT_LT(0u, stats.batches);
+        EXPECT_GE(stats.num_sim_objects, stats.batches);
+      }
+    }
+    EXPECT_EQ(1000u, num_sim_objects);
+  }
+}
+
+struct BatchSizeTestResourceManager : public ResourceManager {
+  using ResourceManager::GetBatchSize;
+};
+
+TEST(ResourceManagerTest, GetBatchSize) {
+  using Rm = BatchSizeTestResourceManager;
+  // batches are not larger than requested
+  EXPECT_EQ(83u, Rm::GetBatchSize(1000, 2, 100));
+  EXPECT_EQ(250u, Rm::GetBatchSize(1000, 2, 300));
+  EXPECT_EQ(1u, Rm::GetBatchSize(1000, 2, 0));
+  EXPECT_EQ(1u, Rm::GetBatchSize(0, 2, 100));
+  // NUMA node without threads (e.g. OMP_NUM_THREADS=1 on a two socket
+  // machine)
+  EXPECT_EQ(90u, Rm::GetBatchSize(1000, 0, 100));
+  EXPECT_EQ(1u, Rm::GetBatchSize(0, 0, 100));
+}
+
 TEST(ResourceManagerTest, DiffusionGrid) {
   ResourceManager rm;
 
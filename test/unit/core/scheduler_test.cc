@@ -132,5 +132,345 @@ TEST(SchedulerTest, OperationManagement) {
   EXPECT_EQ(20u, op2_cnt);
 }
 
+TEST(SchedulerTest, MultiRateTimeStepping) {
+  auto set_param = [](auto* param) {
+    param->simulation_time_step_ = 0.5;
+    param->biology_module_frequency_ = 4;
+  };
+  Simulation simulation(TEST_NAME, set_param);
+
+  uint64_t bm_cnt = 0;
+  auto* cell = new Cell(10);
+  cell->AddBiologyModule(new TestTimeStepModule(&bm_cnt));
+  simulation.GetResourceManager()->push_back(cell);
+
+  auto* scheduler = simulation.GetScheduler();
+  scheduler->GetOperation("displacement")->frequency_ = 2;
+  EXPECT_NEAR(2.0, scheduler->GetBiologyModuleTimeStep(),
+              abs_error<double>::value);
+  EXPECT_NEAR(2.0, scheduler->GetOperationTimeStep("biology modules"),
+              abs_error<double>::value);
+  EXPECT_NEAR(1.0, scheduler->GetOperationTimeStep("displacement"),
+              abs_error<double>::value);
+  EXPECT_NEAR(0.5, scheduler->GetOperationTimeStep("does not exist"),
+              abs_error<double>::value);
+
+  scheduler->Simulate(10);
+  // biology modules are executed in steps 0, 4 and 8
+  EXPECT_EQ(3u, bm_cnt);
+}
+
+TEST(SchedulerTest, SimulatedTime) {
+  auto set_param = [](auto* param) { param->simulation_time_step_ = 0.25; };
+  Simulation simulation(TEST_NAME, set_param);
+  simulation.GetResourceManager()->push_back(new Cell(10));
+
+  auto* scheduler = simulation.GetScheduler();
+  scheduler->Simulate(10);
+  EXPECT_NEAR(2.5, scheduler->GetSimulatedTime(), abs_error<double>::value);
+
+  scheduler->SimulateUntil(5);
+  EXPECT_EQ(20u, scheduler->GetSimulatedSteps());
+  EXPECT_NEAR(5, scheduler->GetSimulatedTime(), abs_error<double>::value);
+}
+
+TEST(SchedulerTest, AdaptiveTimeStep) {
+  auto set_param = [](auto* param) {
+    param->adaptive_time_step_ = true;
+    param->simulation_time_step_ = 0.01;
+    param->simulation_min_time_step_ = 0.001;
+    param->simulation_max_time_step_ = 1;
+  };
+  Simulation simulation(TEST_NAME, set_param);
+  auto* rm = simulation.GetResourceManager();
+  // two overlapping cells that push each other apart
+  auto* cell1 = new Cell({0, 0, 0});
+  cell1->SetDiameter(10);
+  rm->push_back(cell1);
+  auto* cell2 = new Cell({5, 0, 0});
+  cell2->SetDiameter(10);
+  rm->push_back(cell2);
+
+  auto* scheduler = simulation.GetScheduler();
+  scheduler->SimulateUntil(10);
+  EXPECT_LE(10 - 1e-6, scheduler->GetSimulatedTime());
+  // a fixed time step would have required 1000 steps
+  EXPECT_GT(500u, scheduler->GetSimulatedSteps());
+  // the cells have separated: the time step grew to its maximum
+  EXPECT_NEAR(1, scheduler->GetSimulationTimeStep(), abs_error<double>::value);
+  auto* param = simulation.GetParam();
+  EXPECT_LE(scheduler->GetTimeStepController()->GetMaxDisplacement(),
+            param->simulation_max_displacement_);
+}
+
+TEST(SchedulerTest, AdaptiveTimeStepFrequency) {
+  auto set_param = [](auto* param) {
+    param->adaptive_time_step_ = true;
+    param->simulation_time_step_ = 0.01;
+    param->simulation_min_time_step_ = 0.001;
+    param->simulation_max_time_step_ = 1;
+  };
+  Simulation simulation(TEST_NAME, set_param);
+  auto* rm = simulation.GetResourceManager();
+  // two overlapping cells that push each other apart
+  auto* cell1 = new Cell({0, 0, 0});
+  cell1->SetDiameter(10);
+  rm->push_back(cell1);
+  auto* cell2 = new Cell({5, 0, 0});
+  cell2->SetDiameter(10);
+  rm->push_back(cell2);
+
+  // the time step is only adapted in steps with displacement calculation
+  auto* scheduler = simulation.GetScheduler();
+  scheduler->GetOperation("displacement")->frequency_ = 4;
+  scheduler->Simulate(1);
+  auto time_step = scheduler->GetSimulationTimeStep();
+  EXPECT_NE(0.01, time_step);
+  scheduler->Simulate(3);
+  EXPECT_EQ(time_step, scheduler->GetSimulationTimeStep());
+  scheduler->Simulate(1);
+  EXPECT_NE(time_step, scheduler->GetSimulationTimeStep());
+}
+
+TEST(SchedulerTest, ActiveSimObjects) {
+  auto set_param = [](auto* param) {
+    param->detect_static_sim_objects_ = true;
+  };
+  Simulation simulation(TEST_NAME, set_param);
+  auto* rm = simulation.GetResourceManager();
+
+  // sim objects are far away from each other and do not interact
+  std::vector<SoUid> uids;
+  for (uint64_t i = 0; i < 10; i++) {
+    auto* cell = new Cell({i * 100.0, 0, 0});
+    cell->SetDiameter(10);
+    uids.push_back(cell->GetUid());
+    rm->push_back(cell);
+  }
+
+  // replace the displacement operation to count its executions
+  uint64_t displacement_cnt = 0;
+  uint64_t bm_cnt = 0;
+  auto* scheduler = simulation.GetScheduler();
+  scheduler->RemoveOperation("displacement");
+  scheduler->AddOperation(Operation("displacement", [&](SimObject* so) {
+#pragma omp atomic
+    displacement_cnt++;
+  }));
+  scheduler->AddOperation(Operation("counter", [&](SimObject* so) {
+#pragma omp atomic
+    bm_cnt++;
+  }));
+
+  // all sim objects are active in the first two iterations, because they
+  // were placed at their initial positions
+  scheduler->Simulate(2);
+  EXPECT_EQ(20u, displacement_cnt);
+  EXPECT_EQ(10u, scheduler->GetActiveSimObjects().size());
+  EXPECT_EQ(20u, bm_cnt);
+
+  // static sim objects are skipped by mechanical operations
+  scheduler->Simulate(5);
+  EXPECT_EQ(20u, displacement_cnt);
+  EXPECT_EQ(0u, scheduler->GetActiveSimObjects().size());
+  EXPECT_EQ(70u, bm_cnt);
+
+  // a sim object that moved becomes active again: the operation "last" sets
+  // its displacement flag for the next step
+  auto* cell = rm->GetSimObject(uids[3]);
+  cell->SetPosition({300, 5, 0});
+  scheduler->Simulate(1);
+  EXPECT_EQ(20u, displacement_cnt);
+  EXPECT_EQ(80u, bm_cnt);
+  scheduler->Simulate(1);
+  EXPECT_EQ(21u, displacement_cnt);
+  EXPECT_EQ(1u, scheduler->GetActiveSimObjects().size());
+  EXPECT_EQ(90u, bm_cnt);
+}
+
+TEST(SchedulerTest, ActiveSimObjectsNeighbors) {
+  auto set_param = [](auto* param) {
+    param->detect_static_sim_objects_ = true;
+  };
+  Simulation simulation(TEST_NAME, set_param);
+  auto* rm = simulation.GetResourceManager();
+
+  // two clusters far away from each other; each consists of a center cell
+  // in contact with four surrounding cells
+  std::vector<SoUid> uids;
+  for (double x : {50.0, 250.0}) {
+    for (const Double3& pos : std::vector<Double3>{{x, 50, 0},
+                                                   {x - 9, 50, 0},
+                                                   {x + 9, 50, 0},
+                                                   {x, 41, 0},
+                                                   {x, 59, 0}}) {
+      auto* cell = new Cell(pos);
+      cell->SetDiameter(10);
+      uids.push_back(cell->GetUid());
+      rm->push_back(cell);
+    }
+  }
+
+  // replace the displacement operation to record the displaced sim objects
+  std::set<SoUid> displaced;
+  auto* scheduler = simulation.GetScheduler();
+  scheduler->RemoveOperation("displacement");
+  scheduler->AddOperation(Operation("displacement", [&](SimObject* so) {
+#pragma omp critical
+    displaced.insert(so->GetUid());
+  }));
+  // removes and adds sim objects on request
+  bool remove_cell = false;
+  bool add_cell = false;
+  SoUid new_uid = 0;
+  scheduler->AddOperation(Operation("modify", [&](SimObject* so) {
+    if (so->GetUid() != uids[5]) {
+      return;
+    }
+    auto* ctxt = Simulation::GetActive()->GetExecutionContext();
+    if (remove_cell) {
+      ctxt->RemoveFromSimulation(uids[1]);
+      remove_cell = false;
+    }
+    if (add_cell) {
+      auto* cell = new Cell({150, 50, 0});
+      cell->SetDiameter(10);
+      new_uid = cell->GetUid();
+      ctxt->push_back(cell);
+      add_cell = false;
+    }
+  }));
+
+  scheduler->Simulate(3);
+  EXPECT_EQ(10u, displaced.size());
+  EXPECT_EQ(0u, scheduler->GetActiveSimObjects().size());
+
+  // the center cell of the first cluster grows: only the cell itself and its
+  // neighbors in contact are displaced in the next step
+  rm->GetSimObject(uids[0])->SetDiameter(11);
+  displaced.clear();
+  scheduler->Simulate(2);
+  std::set<SoUid> expected = {uids[0], uids[1], uids[2], uids[3], uids[4]};
+  EXPECT_EQ(expected, displaced);
+  EXPECT_EQ(5u, scheduler->GetActiveSimObjects().size());
+
+  // quiescent sim objects are not visited
+  displaced.clear();
+  scheduler->Simulate(3);
+  EXPECT_TRUE(displaced.empty());
+  EXPECT_EQ(0u, scheduler->GetActiveSimObjects().size());
+
+  // a removed neighbor is dropped from the active sim objects; the sim
+  // object that takes its place in the ResourceManager stays static
+  rm->GetSimObject(uids[0])->SetDiameter(12);
+  remove_cell = true;
+  scheduler->Simulate(2);
+  expected = {uids[0], uids[2], uids[3], uids[4]};
+  EXPECT_EQ(expected, displaced);
+
+  // a new sim object is displaced in the step after its creation
+  scheduler->Simulate(3);
+  displaced.clear();
+  add_cell = true;
+  scheduler->Simulate(2);
+  expected = {new_uid};
+  EXPECT_EQ(expected, displaced);
+}
+
+/// Returns the positions of cells that are pushed by an operation that is
+/// executed after the displacement
+std::vector<Double3> RunPushedCells(bool detect_static_sim_objects) {
+  auto set_param = [&](auto* param) {
+    param->detect_static_sim_objects_ = detect_static_sim_objects;
+  };
+  Simulation simulation("SchedulerTest_RunPushedCells", set_param);
+  auto* rm = simulation.GetResourceManager();
+
+  // sim objects are far away from each other and do not interact
+  std::vector<SoUid> uids;
+  for (uint64_t i = 0; i < 10; i++) {
+    auto* cell = new Cell({i * 100.0, 0, 0});
+    cell->SetDiameter(10);
+    uids.push_back(cell->GetUid());
+    rm->push_back(cell);
+  }
+
+  // every other cell is pushed; the tractor force is consumed by the
+  // displacement of the next step
+  auto* scheduler = simulation.GetScheduler();
+  scheduler->AddOperation(Operation("push", [](SimObject* so) {
+    auto* cell = bdm_static_cast<Cell*>(so);
+    if (static_cast<int>(cell->GetPosition()[0]) % 200 == 0) {
+      cell->SetTractorForce({1, 0, 0});
+      cell->SetRunDisplacementForAllNextTs();
+    }
+  }));
+  scheduler->Simulate(10);
+
+  std::vector<Double3> positions;
+  for (auto uid : uids) {
+    positions.push_back(rm->GetSimObject(uid)->GetPosition());
+  }
+  return positions;
+}
+
+// Detecting static sim objects must not change the order of operations
+TEST(SchedulerTest, ActiveSimObjectsSameResult) {
+  auto expected = RunPushedCells(false);
+  auto actual = RunPushedCells(true);
+  ASSERT_EQ(expected.size(), actual.size());
+  for (uint64_t i = 0; i < expected.size(); i++) {
+    EXPECT_EQ(expected[i], actual[i]);
+  }
+  // make sure that the cells have been moved: the tractor force of the
+  // first step is applied in the second one (nine steps with time step 0.01)
+  EXPECT_NEAR(0.09, expected[0][0], abs_error<double>::value);
+  EXPECT_EQ(100, expected[1][0]);
+}
+
+TEST(SchedulerTest, AutotuneBatchSize) {
+  auto set_param = [](auto* param) {
+    param->autotune_scheduling_batch_size_ = true;
+  };
+  Simulation simulation(TEST_NAME, set_param);
+  auto* rm = simulation.GetResourceManager();
+  for (uint64_t i = 0; i < 1000; i++) {
+    auto* cell = new Cell({i * 20.0, 0, 0});
+    cell->SetDiameter(10);
+    rm->push_back(cell);
+  }
+
+  std::atomic<uint64_t> op_cnt(0);
+  auto* scheduler = simulation.GetScheduler();
+  scheduler->AddOperation(Operation("op", [&](SimObject* so) { op_cnt++; }));
+  scheduler->Simulate(20);
+  EXPECT_EQ(20000u, op_cnt.load());
+}
+
+TEST(SchedulerTest, CostWeightedScheduling) {
+  for (auto model : {Param::SchedulingCostModel::kNeighbors,
+                     Param::SchedulingCostModel::kMeasured}) {
+    auto set_param = [&](auto* param) {
+      param->scheduling_cost_model_ = model;
+      param->autotune_scheduling_batch_size_ = true;
+    };
+    Simulation simulation(TEST_NAME, set_param);
+    auto* rm = simulation.GetResourceManager();
+    // dense cluster and sparse region
+    for (uint64_t i = 0; i < 1000; i++) {
+      auto x = i < 500 ? (i % 8) * 1.0 : i * 20.0;
+      auto* cell = new Cell({x, 0, 0});
+      cell->SetDiameter(10);
+      rm->push_back(cell);
+    }
+
+    std::atomic<uint64_t> op_cnt(0);
+    auto* scheduler = simulation.GetScheduler();
+    scheduler->AddOperation(Operation("op", [&](SimObject* so) { op_cnt++; }));
+    scheduler->Simulate(5);
+    EXPECT_EQ(5000u, op_cnt.load());
+  }
+}
+
 }  // namespace scheduler_test_internal
 }  // namespace bdm
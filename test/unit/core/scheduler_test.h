@@ -19,12 +19,16 @@
 
 #include <gtest/gtest.h>
 #include <unistd.h>
+#include <set>
 #include <string>
 
+#include "core/biology_module/biology_module.h"
+#include "core/execution_context/in_place_exec_ctxt.h"
 #include "core/grid.h"
 #include "core/sim_object/cell.h"
 #include "core/simulation_backup.h"
 #include "core/util/io.h"
+#include "core/util/time_step_controller.h"
 #include "unit/test_util/test_util.h"
 
 #define ROOTFILE "bdmFile.root"
@@ -56,6 +60,39 @@ class TestSchedulerBackup : public Scheduler {
   unsigned execute_calls_ = 0;
 };
 
+/// Counts its executions and checks the time step of biology modules
+struct TestTimeStepModule : public BaseBiologyModule {
+  explicit TestTimeStepModule(uint64_t* counter) : counter_(counter) {}
+
+  TestTimeStepModule(const Event& event, BaseBiologyModule* other,
+                     uint64_t new_oid = 0)
+      : BaseBiologyModule(event, other, new_oid) {
+    counter_ = static_cast<TestTimeStepModule*>(other)->counter_;
+  }
+
+  BaseBiologyModule* GetInstance(const Event& event, BaseBiologyModule* other,
+                                 uint64_t new_oid = 0) const override {
+    return new TestTimeStepModule(event, other, new_oid);
+  }
+
+  BaseBiologyModule* GetCopy() const override {
+    return new TestTimeStepModule(*this);
+  }
+
+  void Run(SimObject* so) override {
+    auto* sim = Simulation::GetActive();
+    auto* scheduler = sim->GetScheduler();
+    EXPECT_EQ(0u, scheduler->GetSimulatedSteps() % 4);
+    EXPECT_NEAR(2.0, scheduler->GetBiologyModuleTimeStep(),
+                abs_error<double>::value);
+    (*counter_)++;
+  }
+
+ private:
+  uint64_t* counter_ = nullptr;  //!
+  BDM_CLASS_DEF_OVERRIDE(TestTimeStepModule, 1);
+};
+
 inline void RunRestoreTest() {
   {
     Simulation simulation("SchedulerTest_RunRestoreTest");
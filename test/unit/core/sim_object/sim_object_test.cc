@@ -129,6 +129,33 @@ TEST(SimObjectTest, RemoveBiologyModule) {
   ASSERT_EQ(2u, bms.size());
 }
 
+TEST(SimObjectTest, StatelessBiologyModulesAreShared) {
+  Simulation simulation(TEST_NAME);
+
+  auto* cell = new TestSimObject();
+  auto* module = new StatelessModule();
+  cell->AddBiologyModule(module);
+
+  auto* copy = new TestSimObject(*cell);
+  ASSERT_EQ(1u, copy->GetAllBiologyModules().size());
+  EXPECT_EQ(module, copy->GetAllBiologyModules()[0]);
+  EXPECT_EQ(2u, module->GetNumReferences());
+
+  CellDivisionEvent event(1, 2, 3);
+  auto* daughter = new TestSimObject(event, cell, 0);
+  cell->EventHandler(event, daughter);
+  ASSERT_EQ(1u, daughter->GetAllBiologyModules().size());
+  EXPECT_EQ(module, daughter->GetAllBiologyModules()[0]);
+  // module has been removed from the mother
+  EXPECT_EQ(0u, cell->GetAllBiologyModules().size());
+  EXPECT_EQ(2u, module->GetNumReferences());
+
+  delete cell;
+  delete copy;
+  EXPECT_EQ(1u, module->GetNumReferences());
+  delete daughter;
+}
+
 struct Visitor1 : public SoVisitor {
   uint16_t counter_ = 0;
 
@@ -108,6 +108,19 @@ struct MovementModule : public BaseBiologyModule {
   BDM_CLASS_DEF_OVERRIDE(MovementModule, 1);
 };
 
+/// Stateless biology module that is copied on cell division and removed from
+/// the mother cell
+struct StatelessModule : public BaseBiologyModule {
+  BDM_STATELESS_BM_HEADER(StatelessModule, BaseBiologyModule, 1);
+
+ public:
+  StatelessModule()
+      : BaseBiologyModule(CellDivisionEvent::kEventId,
+                          CellDivisionEvent::kEventId) {}
+
+  void Run(SimObject* so) override {}
+};
+
 /// This biology module removes itself the first time it is executed
 struct RemoveModule : public BaseBiologyModule {
   RemoveModule() {}
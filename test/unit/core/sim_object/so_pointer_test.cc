@@ -45,6 +45,75 @@ TEST(SoPointerTest, Basics) {
   delete so1;
 }
 
+TEST(SoPointerTest, CachedSoHandle) {
+  Simulation simulation(TEST_NAME);
+  auto* rm = simulation.GetResourceManager();
+
+  std::vector<SoUid> uids;
+  for (int i = 0; i < 4; i++) {
+    auto* so = new TestSimObject(i);
+    uids.push_back(so->GetUid());
+    rm->push_back(so);
+  }
+
+  SoPointer<TestSimObject> so_ptr(uids[1]);
+  SoPointer<TestSimObject> last_ptr(uids[3]);
+  EXPECT_EQ(1, so_ptr->GetData());
+  EXPECT_EQ(3, last_ptr->GetData());
+
+  // adding sim objects does not change the layout generation
+  auto generation = ResourceManager::GetLayoutGeneration();
+  rm->push_back(new TestSimObject(4));
+  EXPECT_EQ(generation, ResourceManager::GetLayoutGeneration());
+  EXPECT_EQ(1, so_ptr->GetData());
+
+  // removal moves the last sim object into the freed slot
+  rm->Remove(uids[0]);
+  EXPECT_NE(generation, ResourceManager::GetLayoutGeneration());
+  EXPECT_EQ(1, so_ptr->GetData());
+  EXPECT_EQ(3, last_ptr->GetData());
+
+  // const access
+  const auto& const_ptr = so_ptr;
+  EXPECT_EQ(1, const_ptr->GetData());
+
+  // cached handles must not be used for a different simulation
+  Simulation other(Concat(TEST_NAME, "-other"));
+  auto* other_so = new TestSimObject(42);
+  other.GetResourceManager()->push_back(other_so);
+  SoPointer<TestSimObject> other_ptr(other_so->GetUid());
+  EXPECT_EQ(42, other_ptr->GetData());
+  EXPECT_EQ(nullptr, so_ptr.Get());
+  simulation.Activate();
+  EXPECT_EQ(1, so_ptr->GetData());
+}
+
+TEST(SoPointerTest, ConcurrentAccess) {
+  Simulation simulation(TEST_NAME);
+  auto* rm = simulation.GetResourceManager();
+
+  std::vector<SoPointer<TestSimObject>> so_ptrs;
+  for (int i = 0; i < 100; i++) {
+    auto* so = new TestSimObject(i);
+    so_ptrs.emplace_back(so->GetUid());
+    rm->push_back(so);
+  }
+  // copies share the cached handle
+  auto copy = so_ptrs;
+
+  // all threads dereference the same (const) pointers
+  const auto& const_ptrs = so_ptrs;
+  uint64_t errors = 0;
+#pragma omp parallel for reduction(+ : errors)
+  for (int i = 0; i < 100000; i++) {
+    if (const_ptrs[i % 100]->GetData() != i % 100 ||
+        copy[i % 100]->GetData() != i % 100) {
+      errors++;
+    }
+  }
+  EXPECT_EQ(0u, errors);
+}
+
 TEST(IsSoPtrTest, All) {
   static_assert(!is_so_ptr<TestSimObject>::value,
                 "TestSimObject is not a SoPointer");
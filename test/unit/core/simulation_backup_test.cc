@@ -101,6 +101,31 @@ TEST(SimulationBackupTest, Backup) {
   remove(ROOTFILE);
 }
 
+TEST(SimulationBackupTest, BackupAsync) {
+  remove(ROOTFILE);
+  Simulation simulation(TEST_NAME);
+  auto* rm = simulation.GetResourceManager();
+
+  rm->push_back(new Cell());
+  size_t iterations = 26;
+
+  SimulationBackup backup(ROOTFILE, "");
+  EXPECT_TRUE(backup.BackupAsync(iterations));
+  // modifications after the snapshot must not be part of the backup
+  rm->push_back(new Cell());
+  backup.WaitForAsyncBackup();
+  EXPECT_FALSE(backup.IsAsyncBackupRunning());
+
+  ASSERT_TRUE(FileExists(ROOTFILE));
+
+  SimulationBackup restore("", ROOTFILE);
+  EXPECT_EQ(26u, restore.GetSimulationStepsFromBackup());
+  restore.Restore();
+  EXPECT_EQ(1u, simulation.GetResourceManager()->GetNumSimObjects());
+
+  remove(ROOTFILE);
+}
+
 TEST(SimulationBackupDeathTest, RestoreNoRestoreFileSpecified) {
   ASSERT_DEATH(
       {
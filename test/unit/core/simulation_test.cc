@@ -33,18 +33,34 @@ class SimulationTest : public ::testing::Test {
       "backup_file = \"backup.root\"\n"
       "restore_file = \"restore.root\"\n"
       "backup_interval = 3600\n"
+      "backup_async = true\n"
       "time_step = 0.0125\n"
       "max_displacement = 2.0\n"
+      "adaptive_time_step = true\n"
+      "min_time_step = 0.001\n"
+      "max_time_step = 0.5\n"
+      "biology_module_frequency = 4\n"
       "run_mechanical_interactions = false\n"
       "bound_space = true\n"
       "min_bound = -100\n"
       "max_bound =  200\n"
+      "diffusion_sub_cycling = true\n"
+      "diffusion_temporal_block_size = 4\n"
+      "fuse_diffusion_grids = true\n"
+      "diffusion_sparsity_threshold = 1e-6\n"
+      "diffusion_single_precision = true\n"
+      "diffusion_grid_growth_factor = 1.5\n"
+      "lazy_gradients = true\n"
+      "normalize_gradients = true\n"
+      "diffusion_method = \"adi\"\n"
+      "secretion_mode = \"buffered\"\n"
       "\n"
       "[visualization]\n"
       "live = false\n"
       "export = true\n"
       "export_interval = 100\n"
       "export_generate_pvsm = false\n"
+      "export_async = true\n"
       "\n"
       "  [[visualize_sim_object]]\n"
       "  name = \"Cell\"\n"
@@ -64,13 +80,18 @@ class SimulationTest : public ::testing::Test {
       "\n"
       "[performance]\n"
       "scheduling_batch_size = 123\n"
+      "autotune_scheduling_batch_size = true\n"
+      "scheduling_cost_model = \"neighbors\"\n"
       "detect_static_sim_objects = true\n"
       "cache_neighbors = true\n"
       "\n"
       "[development]\n"
       "# this is a comment\n"
       "statistics = true\n"
-      "debug_numa = true\n";
+      "debug_numa = true\n"
+      "\n"
+      "[experimental]\n"
+      "use_soa_mechanics = true\n";
 
  protected:
   virtual void SetUp() {
@@ -99,16 +120,34 @@ class SimulationTest : public ::testing::Test {
     EXPECT_EQ("paraview", param->visualization_engine_);
     EXPECT_EQ("result-dir", param->output_dir_);
     EXPECT_EQ(3600u, param->backup_interval_);
+    EXPECT_TRUE(param->backup_async_);
     EXPECT_EQ(0.0125, param->simulation_time_step_);
     EXPECT_EQ(2.0, param->simulation_max_displacement_);
+    EXPECT_TRUE(param->adaptive_time_step_);
+    EXPECT_EQ(0.001, param->simulation_min_time_step_);
+    EXPECT_EQ(0.5, param->simulation_max_time_step_);
+    EXPECT_EQ(4u, param->biology_module_frequency_);
     EXPECT_FALSE(param->run_mechanical_interactions_);
     EXPECT_TRUE(param->bound_space_);
     EXPECT_EQ(-100, param->min_bound_);
     EXPECT_EQ(200, param->max_bound_);
+    EXPECT_TRUE(param->diffusion_sub_cycling_);
+    EXPECT_EQ(4u, param->diffusion_temporal_block_size_);
+    EXPECT_TRUE(param->fuse_diffusion_grids_);
+    EXPECT_NEAR(1e-6, param->diffusion_sparsity_threshold_,
+                abs_error<double>::value);
+    EXPECT_TRUE(param->diffusion_single_precision_);
+    EXPECT_NEAR(1.5, param->diffusion_grid_growth_factor_,
+                abs_error<double>::value);
+    EXPECT_TRUE(param->lazy_gradients_);
+    EXPECT_TRUE(param->normalize_gradients_);
+    EXPECT_EQ(Param::DiffusionMethod::kADI, param->diffusion_method_);
+    EXPECT_EQ(Param::SecretionMode::kBuffered, param->secretion_mode_);
     EXPECT_FALSE(param->live_visualization_);
     EXPECT_TRUE(param->export_visualization_);
     EXPECT_EQ(100u, param->visualization_export_interval_);
     EXPECT_FALSE(param->visualization_export_generate_pvsm_);
+    EXPECT_TRUE(param->visualization_export_async_);
 
     // visualize_sim_object
     EXPECT_EQ(2u, param->visualize_sim_objects_.size());
@@ -146,12 +185,18 @@ class SimulationTest : public ::testing::Test {
 
     // performance group
     EXPECT_EQ(123u, param->scheduling_batch_size_);
+    EXPECT_TRUE(param->autotune_scheduling_batch_size_);
+    EXPECT_EQ(Param::SchedulingCostModel::kNeighbors,
+              param->scheduling_cost_model_);
     EXPECT_TRUE(param->detect_static_sim_objects_);
     EXPECT_TRUE(param->cache_neighbors_);
 
     // development group
     EXPECT_TRUE(param->statistics_);
     EXPECT_TRUE(param->debug_numa_);
+
+    // experimental group
+    EXPECT_TRUE(param->use_soa_mechanics_);
   }
 };
 
@@ -0,0 +1,96 @@
+// -----------------------------------------------------------------------------
+//
+// Copyright (C) The BioDynaMo Project.
+// All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+//
+// See the LICENSE file distributed with this work for details.
+// See the NOTICE file distributed with this work for additional information
+// regarding copyright ownership.
+//
+// -----------------------------------------------------------------------------
+
+#include <gtest/gtest.h>
+#include <cmath>
+
+#include "core/util/batch_size_tuner.h"
+
+namespace bdm {
+
+/// Simulates the execution of one pass over `num_so` sim objects on each NUMA
+/// node. The runtime per sim object is minimal for `optimal_batch_size`.
+std::vector<SchedulingStatistics> Execute(
+    const std::vector<uint64_t>& batch_sizes, uint64_t num_so,
+    uint64_t optimal_batch_size, double steal_rate) {
+  std::vector<SchedulingStatistics> statistics(batch_sizes.size());
+  for (uint64_t n = 0; n < batch_sizes.size(); n++) {
+    auto& stats = statistics[n];
+    stats.num_sim_objects = num_so;
+    stats.batches = num_so / batch_sizes[n];
+    stats.stolen_batches = steal_rate * stats.batches;
+    auto distance = std::abs(std::log2(batch_sizes[n]) -
+                             std::log2(optimal_batch_size));
+    stats.runtime = num_so * (100 + 10 * distance);
+  }
+  return statistics;
+}
+
+TEST(BatchSizeTunerTest, InitialBatchSize) {
+  BatchSizeTuner tuner(1000);
+  auto& batch_sizes = tuner.GetBatchSizes("op");
+  EXPECT_EQ(static_cast<uint64_t>(ThreadInfo::GetInstance()->GetNumaNodes()),
+            batch_sizes.size());
+  for (auto batch_size : batch_sizes) {
+    EXPECT_EQ(1000u, batch_size);
+  }
+}
+
+TEST(BatchSizeTunerTest, ConvergeToSmallerBatchSize) {
+  BatchSizeTuner tuner(1000);
+  for (int i = 0; i < 20; i++) {
+    auto statistics = Execute(tuner.GetBatchSizes("op"), 1e7, 62, 0.5);
+    tuner.Update("op", statistics);
+  }
+  for (auto batch_size : tuner.GetBatchSizes("op")) {
+    EXPECT_EQ(62u, batch_size);
+  }
+}
+
+TEST(BatchSizeTunerTest, ConvergeToLargerBatchSize) {
+  BatchSizeTuner tuner(10);
+  for (int i = 0; i < 20; i++) {
+    auto statistics = Execute(tuner.GetBatchSizes("op"), 1e7, 160, 0);
+    tuner.Update("op", statistics);
+  }
+  for (auto batch_size : tuner.GetBatchSizes("op")) {
+    EXPECT_EQ(160u, batch_size);
+  }
+}
+
+TEST(BatchSizeTunerTest, IndependentKeys) {
+  BatchSizeTuner tuner(100);
+  for (int i = 0; i < 20; i++) {
+    tuner.Update("cheap", Execute(tuner.GetBatchSizes("cheap"), 1e7, 800, 0));
+    tuner.Update("expensive",
+                 Execute(tuner.GetBatchSizes("expensive"), 1e7, 25, 0.5));
+  }
+  for (auto batch_size : tuner.GetBatchSizes("cheap")) {
+    EXPECT_EQ(800u, batch_size);
+  }
+  for (auto batch_size : tuner.GetBatchSizes("expensive")) {
+    EXPECT_EQ(25u, batch_size);
+  }
+
+  TimingAggregator statistics;
+  tuner.AddDescriptions(&statistics);
+  std::stringstream output;
+  output << statistics;
+  EXPECT_NE(std::string::npos,
+            output.str().find("batch size [cheap] numa node 0: 800"));
+  EXPECT_NE(std::string::npos,
+            output.str().find("batch size [expensive] numa node 0: 25"));
+}
+
+}  // namespace bdm
@@ -0,0 +1,90 @@
+// -----------------------------------------------------------------------------
+//
+// Copyright (C) The BioDynaMo Project.
+// All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+//
+// See the LICENSE file distributed with this work for details.
+// See the NOTICE file distributed with this work for additional information
+// regarding copyright ownership.
+//
+// -----------------------------------------------------------------------------
+
+#include <gtest/gtest.h>
+#include <omp.h>
+
+#include "core/util/time_step_controller.h"
+#include "unit/test_util/test_util.h"
+
+namespace bdm {
+
+TEST(TimeStepControllerTest, MaxDisplacement) {
+  TimeStepController controller;
+  controller.StartStep();
+  EXPECT_NEAR(0, controller.GetMaxDisplacement(), abs_error<double>::value);
+
+#pragma omp parallel for
+  for (int i = 0; i < 100; i++) {
+    controller.ObserveDisplacement(i * i);
+  }
+  EXPECT_NEAR(99, controller.GetMaxDisplacement(), abs_error<double>::value);
+
+  controller.StartStep();
+  controller.ObserveDisplacement(4);
+  EXPECT_NEAR(2, controller.GetMaxDisplacement(), abs_error<double>::value);
+}
+
+TEST(TimeStepControllerTest, MoreThreadsThanThreadInfo) {
+  TimeStepController controller;
+  controller.StartStep();
+  auto max_threads = ThreadInfo::GetInstance()->GetMaxThreads();
+  int num_threads = 1;
+  // threads with id >= max_threads do not have a slot
+#pragma omp parallel num_threads(max_threads + 2)
+  {
+    auto tid = omp_get_thread_num();
+#pragma omp master
+    num_threads = omp_get_num_threads();
+    if (tid >= max_threads) {
+      controller.ObserveDisplacement(tid * tid);
+    }
+  }
+  bool overflow = num_threads > max_threads;
+  EXPECT_EQ(overflow, controller.HasObservations());
+  EXPECT_NEAR(overflow ? num_threads - 1 : 0, controller.GetMaxDisplacement(),
+              abs_error<double>::value);
+}
+
+TEST(TimeStepControllerTest, NextTimeStep) {
+  TimeStepController controller;
+
+  // displacements have not been calculated: keep the time step
+  controller.StartStep();
+  EXPECT_FALSE(controller.HasObservations());
+  EXPECT_NEAR(0.1, controller.GetNextTimeStep(0.1, 3, 0.01, 1),
+              abs_error<double>::value);
+
+  // nothing moved: grow, but at most up to the maximum time step
+  controller.ObserveDisplacement(0);
+  EXPECT_TRUE(controller.HasObservations());
+  EXPECT_NEAR(0.2, controller.GetNextTimeStep(0.1, 3, 0.01, 1),
+              abs_error<double>::value);
+  EXPECT_NEAR(1, controller.GetNextTimeStep(0.8, 3, 0.01, 1),
+              abs_error<double>::value);
+
+  // aim for half of the maximum displacement
+  controller.ObserveDisplacement(1);
+  EXPECT_NEAR(0.15, controller.GetNextTimeStep(0.1, 3, 0.01, 1),
+              abs_error<double>::value);
+
+  // clipped displacements: shrink, but at most down to the minimum time step
+  controller.ObserveDisplacement(9);
+  EXPECT_NEAR(0.05, controller.GetNextTimeStep(0.1, 3, 0.01, 1),
+              abs_error<double>::value);
+  EXPECT_NEAR(0.01, controller.GetNextTimeStep(0.015, 3, 0.01, 1),
+              abs_error<double>::value);
+}
+
+}  // namespace bdm
@@ -146,6 +146,31 @@ TEST_F(ParaviewAdaptorTest, OmitPvsmAndJsonGeneration) {
   EXPECT_FALSE(FileExists(pvsm_filename));
 }
 
+/// Tests if the pipelined export writes the files of the exported step.
+TEST_F(ParaviewAdaptorTest, ExportVisualizationAsync) {
+  auto set_param = [](Param* param) {
+    param->export_visualization_ = true;
+    param->visualization_export_async_ = true;
+    param->visualization_export_generate_pvsm_ = false;
+    param->visualize_sim_objects_["Cell"] = std::set<std::string>{};
+  };
+  Simulation simulation(TEST_NAME, set_param);
+  auto* rm = simulation.GetResourceManager();
+  for (uint64_t i = 0; i < 10; i++) {
+    rm->push_back(new Cell({i * 10.0, 0, 0}));
+  }
+
+  auto filename = Concat(simulation.GetOutputDir(), "/Cell-0.pvtu");
+  remove(filename.c_str());
+
+  ParaviewAdaptor adaptor;
+  adaptor.Visualize();
+  adaptor.WaitForExport();
+
+  EXPECT_TRUE(FileExists(filename));
+  remove(filename.c_str());
+}
+
 /// Tests if the catalyst state is generated.
 TEST_F(ParaviewAdaptorTest, GenerateParaviewState) {
   Simulation simulation("MySimulation");